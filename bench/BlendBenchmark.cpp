@@ -0,0 +1,365 @@
+#include "ImageProcessor.h"
+#include "BlendMode.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace MaskOverlay;
+
+namespace {
+
+struct BenchmarkOptions {
+    std::vector<double> megapixels = {1, 4, 16, 100};
+    std::vector<unsigned int> threads;
+    std::vector<std::string> masks = {"dense", "sparse", "colorkey", "alpha"};
+    std::vector<bool> alpha = {true, false};
+    std::vector<bool> linear = {false};
+    std::vector<bool> statistics = {false};
+    double minTime = 0.25;
+    int minIterations = 3;
+    std::string output;
+};
+
+struct BenchmarkResult {
+    double megapixels;
+    sf::Vector2u size;
+    BlendModeType mode;
+    std::string mask;
+    bool alpha;
+    bool linear;
+    bool statistics;
+    unsigned int threads;
+    int iterations;
+    double minMs;
+    double medianMs;
+};
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+};
+
+class Random {
+public:
+    explicit Random(std::uint32_t seed) : m_state(seed ? seed : 1) {}
+
+    std::uint32_t next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    std::uint8_t byte() {
+        return static_cast<std::uint8_t>(next() >> 24);
+    }
+
+private:
+    std::uint32_t m_state;
+};
+
+const sf::Color KeyColor = sf::Color::Magenta;
+
+sf::Vector2u sizeForMegapixels(double megapixels) {
+    double pixels = megapixels * 1000000.0;
+    unsigned int width = static_cast<unsigned int>(std::round(std::sqrt(pixels * 4.0 / 3.0)));
+    unsigned int height = static_cast<unsigned int>(std::round(pixels / width));
+    return sf::Vector2u(std::max(1u, width), std::max(1u, height));
+}
+
+sf::Image makeSource(const sf::Vector2u& size) {
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+    Random random(12345);
+
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            std::uint8_t* p = &pixels[(static_cast<std::size_t>(y) * size.x + x) * 4];
+            std::uint8_t noise = random.byte() >> 3;
+            p[0] = static_cast<std::uint8_t>((x * 255) / size.x) ^ noise;
+            p[1] = static_cast<std::uint8_t>((y * 255) / size.y) ^ noise;
+            p[2] = static_cast<std::uint8_t>(((x + y) * 127) / (size.x + size.y) + noise);
+            p[3] = 255;
+        }
+    }
+
+    return sf::Image(size, pixels.data());
+}
+
+sf::Image makeMask(const sf::Vector2u& size, const std::string& kind) {
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+    Random random(67890);
+
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            std::uint8_t* p = &pixels[(static_cast<std::size_t>(y) * size.x + x) * 4];
+            sf::Color color(random.byte(), random.byte(), random.byte(), 255);
+
+            if (kind == "sparse") {
+                bool covered = ((x / 16) * 7 + (y / 16) * 13) % 20 == 0;
+                if (!covered) {
+                    color = KeyColor;
+                }
+            } else if (kind == "colorkey") {
+                if (((x / 32) + (y / 32)) % 2 == 0) {
+                    color = KeyColor;
+                }
+            } else if (kind == "alpha") {
+                color.a = static_cast<std::uint8_t>(1 + (x + y) % 254);
+            }
+
+            p[0] = color.r;
+            p[1] = color.g;
+            p[2] = color.b;
+            p[3] = color.a;
+        }
+    }
+
+    return sf::Image(size, pixels.data());
+}
+
+template <typename T>
+std::vector<T> parseList(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::stringstream itemStream(item);
+        T value;
+        if (itemStream >> value) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+std::vector<std::string> parseNames(const std::string& text) {
+    std::vector<std::string> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            values.push_back(item);
+        }
+    }
+    return values;
+}
+
+void printUsage() {
+    std::cerr << "Uzycie: MaskOverlayBench [opcje]\n"
+              << "  --sizes 1,4,16,100             rozmiary obrazow w megapikselach\n"
+              << "  --threads 1,2,4                liczby watkow (domyslnie 1 i wszystkie)\n"
+              << "  --masks dense,sparse,colorkey,alpha\n"
+              << "  --alpha on,off                 kanal alfa maski\n"
+              << "  --light gamma,linear           mieszanie na wartosciach z gamma i/lub w swietle liniowym\n"
+              << "  --stats off,on                 zbieranie statystyk wyniku w trakcie mieszania\n"
+              << "  --min-time 0.25                minimalny czas pomiaru [s]\n"
+              << "  --min-iterations 3\n"
+              << "  --output plik.json             zapis wynikow do pliku zamiast stdout\n";
+}
+
+bool parseArguments(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Brak wartosci dla opcji: " << arg << std::endl;
+            return false;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            options.megapixels = parseList<double>(value);
+        } else if (arg == "--threads") {
+            options.threads = parseList<unsigned int>(value);
+        } else if (arg == "--masks") {
+            options.masks = parseNames(value);
+        } else if (arg == "--alpha") {
+            options.alpha.clear();
+            for (const auto& name : parseNames(value)) {
+                options.alpha.push_back(name == "on");
+            }
+        } else if (arg == "--light") {
+            options.linear.clear();
+            for (const auto& name : parseNames(value)) {
+                options.linear.push_back(name == "linear");
+            }
+        } else if (arg == "--stats") {
+            options.statistics.clear();
+            for (const auto& name : parseNames(value)) {
+                options.statistics.push_back(name == "on");
+            }
+        } else if (arg == "--min-time") {
+            options.minTime = std::atof(value.c_str());
+        } else if (arg == "--min-iterations") {
+            options.minIterations = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            std::cerr << "Nieznana opcja: " << arg << std::endl;
+            printUsage();
+            return false;
+        }
+    }
+
+    if (options.threads.empty()) {
+        options.threads.push_back(1);
+        unsigned int hardware = ThreadPool::getHardwareThreadCount();
+        if (hardware > 1) {
+            options.threads.push_back(hardware);
+        }
+    }
+
+    return true;
+}
+
+BenchmarkResult measure(ImageProcessor& processor, BlendModeType mode, bool alpha, const BenchmarkOptions& options) {
+    using Clock = std::chrono::steady_clock;
+
+    processor.applyMask(mode, KeyColor, alpha);
+
+    std::vector<double> samples;
+    double total = 0;
+    while (static_cast<int>(samples.size()) < options.minIterations || total < options.minTime) {
+        auto start = Clock::now();
+        processor.applyMask(mode, KeyColor, alpha);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        samples.push_back(seconds * 1000.0);
+        total += seconds;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result{};
+    result.mode = mode;
+    result.alpha = alpha;
+    result.iterations = static_cast<int>(samples.size());
+    result.minMs = samples.front();
+    result.medianMs = samples[samples.size() / 2];
+    return result;
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"benchmark\": \"ImageProcessor::applyMask\",\n";
+    out << "  \"hardware_threads\": " << ThreadPool::getHardwareThreadCount() << ",\n";
+    out << "  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        double pixels = static_cast<double>(r.size.x) * r.size.y;
+        double mpxPerSecond = pixels / (r.medianMs * 1000.0);
+        double nsPerPixel = r.medianMs * 1000000.0 / pixels;
+
+        out << "    {"
+            << "\"megapixels\": " << r.megapixels
+            << ", \"width\": " << r.size.x
+            << ", \"height\": " << r.size.y
+            << ", \"mode\": \"" << BlendMode::getModeName(r.mode) << "\""
+            << ", \"mode_id\": " << static_cast<int>(r.mode)
+            << ", \"mask\": \"" << r.mask << "\""
+            << ", \"alpha\": " << (r.alpha ? "true" : "false")
+            << ", \"linear\": " << (r.linear ? "true" : "false")
+            << ", \"statistics\": " << (r.statistics ? "true" : "false")
+            << ", \"threads\": " << r.threads
+            << ", \"iterations\": " << r.iterations
+            << ", \"min_ms\": " << r.minMs
+            << ", \"median_ms\": " << r.medianMs
+            << ", \"mpx_per_s\": " << mpxPerSecond
+            << ", \"ns_per_px\": " << nsPerPixel
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    out << "  ]\n";
+    out << "}\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        return 1;
+    }
+
+    // ImageProcessor loguje kazda operacje na stdout, a stdout jest zarezerwowane na JSON
+    NullBuffer nullBuffer;
+    std::ostream console(std::cout.rdbuf());
+    std::cout.rdbuf(&nullBuffer);
+
+    std::vector<BenchmarkResult> results;
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+
+    for (double megapixels : options.megapixels) {
+        sf::Vector2u size = sizeForMegapixels(megapixels);
+        std::cerr << "Obraz " << megapixels << " MP (" << size.x << "x" << size.y << ")" << std::endl;
+        processor.setSourceImage(makeSource(size));
+
+        for (const auto& maskKind : options.masks) {
+            processor.setMask(makeMask(size, maskKind));
+
+            for (unsigned int threads : options.threads) {
+                processor.setThreadCount(threads);
+
+                for (bool alpha : options.alpha) {
+                    for (bool linear : options.linear) {
+                        processor.setLinearLight(linear);
+                        for (bool statistics : options.statistics) {
+                            processor.setCollectStatistics(statistics);
+                            for (BlendModeType mode : BlendMode::getAllModes()) {
+                                BenchmarkResult result = measure(processor, mode, alpha, options);
+                                result.linear = linear;
+                                result.statistics = statistics;
+                                result.megapixels = megapixels;
+                                result.size = size;
+                                result.mask = maskKind;
+                                result.threads = processor.getThreadCount();
+                                results.push_back(result);
+
+                                std::cerr << "  " << std::setw(20) << BlendMode::getModeName(mode)
+                                          << "  maska=" << maskKind
+                                          << "  alfa=" << (alpha ? "tak" : "nie")
+                                          << "  swiatlo=" << (linear ? "liniowe" : "gamma")
+                                          << "  statystyki=" << (statistics ? "tak" : "nie")
+                                          << "  watki=" << result.threads
+                                          << "  " << std::fixed << std::setprecision(2) << result.medianMs << " ms"
+                                          << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout.rdbuf(console.rdbuf());
+
+    if (options.output.empty()) {
+        writeJson(std::cout, results);
+    } else {
+        std::ofstream file(options.output);
+        if (!file) {
+            std::cerr << "Nie mozna zapisac wynikow do: " << options.output << std::endl;
+            return 1;
+        }
+        writeJson(file, results);
+        std::cerr << "Zapisano wyniki do: " << options.output << std::endl;
+    }
+
+    return 0;
+}
@@ -4,10 +4,16 @@
 #include <memory>
 #include <string>
 #include <optional>
+#include <cstdint>
+#include <atomic>
 #include "ImageProcessor.h"
+#include "PreviewProxy.h"
+#include "TilePyramid.h"
+#include "SplitView.h"
 #include "MaskLibrary.h"
 #include "GUI.h"
 #include "BlendMode.h"
+#include "BackgroundWorker.h"
 
 namespace MaskOverlay {
 
@@ -23,6 +29,7 @@ private:
     sf::Font m_font;
 
     std::unique_ptr<ImageProcessor> m_processor;
+    std::unique_ptr<PreviewProxy> m_previewProxy;
     std::unique_ptr<MaskLibrary> m_maskLibrary;
     std::unique_ptr<GUI> m_gui;
 
@@ -30,10 +37,33 @@ private:
     std::optional<sf::Sprite> m_maskSprite;
     std::optional<sf::Sprite> m_resultSprite;
 
+    TilePyramid m_sourceTiles;
+    TilePyramid m_resultTiles;
+    std::uint64_t m_sourceTilesGeneration;
+
+    SplitView m_splitView;
+    bool m_draggingDivider;
+
+    bool m_zoomed;
+    float m_zoom;
+    sf::Vector2f m_viewCenter;
+    bool m_panning;
+    sf::Vector2f m_panStart;
+    sf::Vector2f m_panStartCenter;
+
+    sf::RectangleShape m_previewBackground;
+    std::optional<sf::Text> m_helpText;
+
     BlendModeType m_currentBlendMode;
     sf::Color m_transparentColor;
+    int m_tolerance;
+    std::uint8_t m_opacity;
+    bool m_softKey;
     bool m_useAlpha;
     sf::Vector2i m_maskOffset;
+    MaskTransform m_maskTransform;
+    bool m_maskTransformPending;
+    sf::Clock m_maskTransformClock;
 
     enum class ViewMode {
         Source,
@@ -43,16 +73,50 @@ private:
     };
     ViewMode m_viewMode;
 
+    struct SceneState {
+        std::uint64_t sourceGeneration = 0;
+        std::uint64_t maskGeneration = 0;
+        std::uint64_t resultGeneration = 0;
+        bool showingProxy = false;
+        sf::FloatRect previewArea;
+        ViewMode viewMode = ViewMode::Source;
+        bool tiled = false;
+        bool valid = false;
+    };
+    SceneState m_sceneState;
+
     bool m_draggingMask;
     sf::Vector2i m_dragStart;
     sf::Vector2i m_dragStartOffset;
 
+    bool m_showingProxy;
+    bool m_fullApplyPending;
+    bool m_liveApply;
+    bool m_liveApplyPending;
+    sf::Clock m_liveApplyClock;
+
+    // Wyrownanie maski w tle: postep w procentach z watku zadania
+    bool m_aligning;
+    bool m_alignFound;
+    std::atomic<int> m_alignProgress;
+    int m_shownAlignProgress;
+
+    bool m_redrawRequested;
+    sf::Clock m_frameClock;
+
+    // Niszczony przed procesorem - czeka na zadanie, ktore z niego korzysta
+    BackgroundWorker m_applyWorker;
+
     bool initialize();
     bool loadFont();
     void initializeCallbacks();
     void loadDefaultMasks();
 
     void handleEvents();
+    void handleEvent(const sf::Event& event);
+    bool isInteracting() const;
+    bool isAnimating() const;
+    void requestRedraw();
     void update();
     void render();
 
@@ -60,17 +124,40 @@ private:
     void handleMousePress(sf::Mouse::Button button, const sf::Vector2f& pos);
     void handleMouseRelease(sf::Mouse::Button button, const sf::Vector2f& pos);
     void handleMouseMove(const sf::Vector2f& pos);
-    void handleMouseWheel(float delta);
+    void handleMouseWheel(const sf::Vector2f& pos, float delta);
 
     void loadSourceImage();
     void loadMaskImage();
     void saveResult();
     void applyMask();
+    void applyPreview();
+    void scheduleLiveApply();
+    void startBackgroundApply();
+    void finishBackgroundApply();
+    void completeBackgroundTask();
+    void showResult();
+    void stepHistory(bool forward);
+    void transformMask(const MaskTransform& transform, const std::optional<sf::Vector2i>& offset = std::nullopt);
+    void fitMaskToSource();
+    void alignMask();
+    void commitMaskTransform();
+    void resetMaskTransform();
+    const ImageProcessor& getDisplayedResult() const;
     void selectMaskFromLibrary(size_t index);
+    void saveTrace();
 
     std::string openFileDialog(const std::string& title, const std::string& filter);
     std::string saveFileDialog(const std::string& title, const std::string& filter);
     void updateSprites();
+    void updatePreviewLayout();
+    float getFitZoom() const;
+    float getViewZoom() const;
+    sf::Vector2f getViewCenter() const;
+    void clampViewCenter();
+    void resetZoom();
+    bool useTiledView() const;
+    void drawTiled(TilePyramid& tiles);
+    void drawSourcePreview();
     void fitSpriteToArea(sf::Sprite& sprite, const sf::FloatRect& area);
     void setStatusMessage(const std::string& message);
 };
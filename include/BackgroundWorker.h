@@ -0,0 +1,40 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace MaskOverlay {
+
+class BackgroundWorker {
+public:
+    BackgroundWorker();
+    ~BackgroundWorker();
+
+    BackgroundWorker(const BackgroundWorker&) = delete;
+    BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+
+    bool submit(std::function<void()> task);
+
+    bool isBusy() const;
+
+    bool takeFinished();
+
+    void wait();
+
+private:
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    std::function<void()> m_task;
+    bool m_busy;
+    bool m_finished;
+    bool m_stopping;
+
+    void workerLoop();
+};
+
+}
@@ -3,7 +3,10 @@
 #include <SFML/Graphics.hpp>
 #include <string>
 #include <functional>
+#include <vector>
 #include <cstdint>
+#include <cstddef>
+#include "BlendStatistics.h"
 
 namespace MaskOverlay {
 
@@ -15,39 +18,154 @@ enum class BlendModeType {
     Overlay,
     Difference,
     SoftLight,
-    HardLight
+    HardLight,
+    Darken,
+    Lighten,
+    ColorDodge,
+    ColorBurn,
+    LinearBurn,
+    Exclusion,
+    Subtract
+};
+
+struct BlendModeInfo {
+    BlendModeType type;
+    std::string name;
+    std::string label;
+    int (*channel)(int base, int blend, int one);
+    void (*channelRow)(const float* base, const float* blend, float* result, std::size_t count);
 };
 
 class BlendMode {
 public:
+    static constexpr int DefaultTolerance = 10;
+
+    static constexpr int LinearOne = 4095;
+
     static sf::Color blend(const sf::Color& source, 
                           const sf::Color& mask,
                           BlendModeType mode,
                           const sf::Color& transparentColor,
-                          bool useAlpha = true);
+                          bool useAlpha = true,
+                          int tolerance = DefaultTolerance,
+                          std::uint8_t opacity = 255,
+                          bool linear = false);
+
+    static void classifyRow(const std::uint8_t* mask,
+                            std::uint8_t* coverage,
+                            std::size_t count,
+                            const sf::Color& transparentColor,
+                            int tolerance,
+                            bool useAlpha);
+
+    static void buildKeyRamp(int tolerance, int softness, std::uint8_t* ramp);
+
+    static void softKeyRow(const std::uint8_t* mask,
+                           std::uint8_t* coverage,
+                           std::uint8_t* despilled,
+                           std::size_t count,
+                           const sf::Color& transparentColor,
+                           const std::uint8_t* ramp,
+                           bool useAlpha);
+
+    static void blendRow(const std::uint8_t* source,
+                         const std::uint8_t* mask,
+                         const std::uint8_t* coverage,
+                         std::uint8_t* result,
+                         std::size_t count,
+                         BlendModeType mode,
+                         std::uint8_t opacity = 255,
+                         bool linear = false,
+                         BlendStatistics* statistics = nullptr);
+
+    static void classifyRowFloat(const float* mask,
+                                 float* coverage,
+                                 std::size_t count,
+                                 const sf::Color& transparentColor,
+                                 int tolerance,
+                                 bool useAlpha);
+
+    static void blendRowFloat(const float* source,
+                              const float* mask,
+                              const float* coverage,
+                              float* result,
+                              std::size_t count,
+                              BlendModeType mode,
+                              std::uint8_t opacity = 255);
 
     static bool isTransparent(const sf::Color& color, 
                              const sf::Color& transparentColor,
-                             int tolerance = 10);
+                             int tolerance = DefaultTolerance);
+
+    static int clampTolerance(int tolerance);
 
     static std::string getModeName(BlendModeType mode);
 
+    static std::string getModeLabel(BlendModeType mode);
+
     static std::vector<BlendModeType> getAllModes();
 
+    static const std::vector<BlendModeInfo>& getRegistry();
+
+    static const BlendModeInfo* findMode(BlendModeType mode);
+
+    static const std::uint8_t* getLookupTable(BlendModeType mode, bool linear = false);
+
+    static const std::uint8_t* getClipTable(BlendModeType mode, bool linear = false);
+
+    static const std::uint16_t* getToLinearTable();
+
+    static const std::uint8_t* getFromLinearTable();
+
 private:
     static std::uint8_t clamp(int value);
-    static sf::Color blendReplace(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendAdd(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendMultiply(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendScreen(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendOverlay(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendDifference(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendSoftLight(const sf::Color& source, const sf::Color& mask);
-    static sf::Color blendHardLight(const sf::Color& source, const sf::Color& mask);
+    static std::uint8_t scaleCoverage(std::uint8_t coverage, std::uint8_t opacity);
+    static sf::Color blendColor(const sf::Color& source, const sf::Color& mask, BlendModeType mode, bool linear);
+    static const std::uint64_t* getReciprocalTable();
+    static const std::uint8_t* findTable(const std::vector<std::vector<std::uint8_t>>& tables, BlendModeType mode);
+    template <bool Statistics>
+    static void blendPixels(const std::uint8_t* source, const std::uint8_t* mask, const std::uint8_t* coverage,
+                            std::uint8_t* result, std::size_t count, const std::uint8_t* table,
+                            const std::uint8_t* scale, bool linear, const std::uint8_t* clip,
+                            BlendStatistics* statistics);
+    template <float (*Channel)(float, float, float)>
+    static void channelRow(const float* base, const float* blend, float* result, std::size_t count);
+    static std::uint8_t linearChannel(int (*channel)(int, int, int), std::uint8_t base, std::uint8_t blend);
+    template <typename T>
+    static T replaceChannel(T base, T blend, T one);
+    template <typename T>
+    static T addChannel(T base, T blend, T one);
+    template <typename T>
+    static T multiplyChannel(T base, T blend, T one);
+    template <typename T>
+    static T screenChannel(T base, T blend, T one);
+    template <typename T>
+    static T overlayChannel(T base, T blend, T one);
+    template <typename T>
+    static T differenceChannel(T base, T blend, T one);
+    template <typename T>
+    static T softLightChannel(T base, T blend, T one);
+    template <typename T>
+    static T hardLightChannel(T base, T blend, T one);
+    template <typename T>
+    static T darkenChannel(T base, T blend, T one);
+    template <typename T>
+    static T lightenChannel(T base, T blend, T one);
+    template <typename T>
+    static T colorDodgeChannel(T base, T blend, T one);
+    template <typename T>
+    static T colorBurnChannel(T base, T blend, T one);
+    template <typename T>
+    static T linearBurnChannel(T base, T blend, T one);
+    template <typename T>
+    static T exclusionChannel(T base, T blend, T one);
+    template <typename T>
+    static T subtractChannel(T base, T blend, T one);
     
     static sf::Color applyAlpha(const sf::Color& source, 
                                const sf::Color& blended, 
-                               std::uint8_t alpha);
+                               std::uint8_t alpha,
+                               bool linear = false);
 };
 
 }
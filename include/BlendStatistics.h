@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+
+namespace MaskOverlay {
+
+struct BlendStatistics {
+    static constexpr int Channels = 4;
+
+    std::array<std::array<long long, 256>, Channels> histogram{};
+    long long pixels = 0;
+    long long touched = 0;
+    long long clipped = 0;
+
+    void clear();
+
+    void merge(const BlendStatistics& other);
+
+    int getMin(int channel) const;
+
+    int getMax(int channel) const;
+
+    double getMean(int channel) const;
+
+    double getMeanLuminance() const;
+
+    double getTouchedFraction() const;
+
+    double getClippedFraction() const;
+};
+
+}
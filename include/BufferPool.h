@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace MaskOverlay {
+
+// Alokator bez zerowania - bufory wynikow i tak sa w calosci nadpisywane
+template <typename T>
+class DefaultInitAllocator : public std::allocator<T> {
+public:
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    DefaultInitAllocator() = default;
+
+    template <typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template <typename U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+class BufferPool {
+public:
+    using Buffer = std::vector<std::uint8_t, DefaultInitAllocator<std::uint8_t>>;
+
+    explicit BufferPool(std::size_t maxPooledBytes = std::size_t(512) << 20);
+
+    std::unique_ptr<Buffer> acquire(std::size_t bytes);
+
+    void release(std::unique_ptr<Buffer> buffer);
+
+    void trim();
+
+    std::size_t getPooledBytes() const;
+
+    void setMaxPooledBytes(std::size_t bytes);
+
+    static BufferPool& getShared();
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Buffer>> m_free;
+    std::size_t m_pooledBytes;
+    std::size_t m_maxPooledBytes;
+};
+
+}
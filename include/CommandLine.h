@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <optional>
+#include "BlendMode.h"
+#include "ImageResampler.h"
+#include "ImageProcessor.h"
+#include "PreciseImage.h"
+
+namespace MaskOverlay {
+
+class CommandLine {
+public:
+    CommandLine(int argc, char* argv[]);
+
+    int run();
+
+    static bool isHeadless(int argc, char* argv[]);
+
+private:
+    std::vector<std::string> m_args;
+
+    std::string m_sourcePath;
+    std::string m_maskPath;
+    std::string m_outputPath;
+    std::string m_tracePath;
+    std::string m_statisticsPath;
+    BlendModeType m_mode;
+    sf::Color m_transparentColor;
+    bool m_useAlpha;
+    sf::Vector2i m_maskOffset;
+    int m_tolerance;
+    int m_softness;
+    bool m_despill;
+    int m_feather;
+    std::uint8_t m_opacity;
+    MaskTransform m_maskTransform;
+    bool m_fit;
+    bool m_align;
+    bool m_linear;
+    MaskWrap m_wrap;
+    std::optional<PixelFormat> m_precision;
+    unsigned int m_threads;
+
+    bool parseArguments();
+    int runPrecise();
+    bool saveStatistics(const BlendStatistics& statistics) const;
+    void printUsage() const;
+    void printModes() const;
+    std::optional<BlendModeType> parseMode(const std::string& text) const;
+};
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <optional>
+
+namespace MaskOverlay {
+
+class DirtyRegion {
+public:
+    DirtyRegion();
+
+    void add(const sf::IntRect& rect);
+
+    void addAll(const sf::Vector2u& size);
+
+    void clear();
+
+    bool isEmpty() const;
+
+    const std::vector<sf::IntRect>& getRects() const;
+
+    std::optional<sf::IntRect> getBounds() const;
+
+    long long getArea() const;
+
+    void setMaxRects(std::size_t maxRects);
+
+private:
+    std::vector<sf::IntRect> m_rects;
+    std::size_t m_maxRects;
+
+    static bool touches(const sf::IntRect& a, const sf::IntRect& b);
+    static sf::IntRect unite(const sf::IntRect& a, const sf::IntRect& b);
+};
+
+}
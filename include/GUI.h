@@ -6,7 +6,9 @@
 #include <string>
 #include <optional>
 #include <functional>
+#include <memory>
 #include "BlendMode.h"
+#include "BlendStatistics.h"
 
 namespace MaskOverlay {
 
@@ -15,7 +17,7 @@ public:
     Button(const sf::Vector2f& position, const sf::Vector2f& size, 
            const std::string& label, const sf::Font& font);
 
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& target);
     bool isClicked(const sf::Vector2f& mousePos) const;
     bool contains(const sf::Vector2f& point) const;
     
@@ -36,6 +38,12 @@ public:
 
     void update(const sf::Vector2f& mousePos);
 
+    sf::FloatRect getBounds() const;
+
+    bool isDirty() const;
+
+    void clearDirty();
+
 private:
     sf::RectangleShape m_shape;
     std::optional<sf::Text> m_text;
@@ -43,6 +51,7 @@ private:
     bool m_selected;
     bool m_enabled;
     bool m_hovered;
+    bool m_dirty;
     
     sf::Color m_normalColor;
     sf::Color m_hoverColor;
@@ -56,7 +65,7 @@ public:
            float minValue, float maxValue, const sf::Font& font,
            const std::string& label = "");
 
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& target);
     bool handleEvent(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased);
     
     float getValue() const;
@@ -64,6 +73,14 @@ public:
 
     void setLabel(const std::string& label);
 
+    bool isDragging() const;
+
+    sf::FloatRect getBounds() const;
+
+    bool isDirty() const;
+
+    void clearDirty();
+
 private:
     sf::RectangleShape m_track;
     sf::RectangleShape m_thumb;
@@ -75,6 +92,7 @@ private:
     float m_maxValue;
     float m_value;
     bool m_dragging;
+    bool m_dirty;
     sf::Vector2f m_position;
     float m_width;
     
@@ -85,12 +103,20 @@ class ColorPicker {
 public:
     ColorPicker(const sf::Vector2f& position, const sf::Font& font);
 
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& target);
     bool handleEvent(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased);
     
     sf::Color getColor() const;
     void setColor(const sf::Color& color);
 
+    bool isDragging() const;
+
+    sf::FloatRect getBounds() const;
+
+    bool isDirty() const;
+
+    void clearDirty();
+
 private:
     sf::Vector2f m_position;
     sf::RectangleShape m_preview;
@@ -101,10 +127,32 @@ private:
     std::unique_ptr<Slider> m_blueSlider;
     std::unique_ptr<Slider> m_alphaSlider;
     sf::Color m_color;
+    bool m_dirty;
     
     void updatePreview();
 };
 
+class PerfOverlay {
+public:
+    PerfOverlay(const sf::Vector2f& position, const sf::Font& font);
+
+    void draw(sf::RenderTarget& target);
+    void update();
+
+    void setPosition(const sf::Vector2f& position);
+
+    void setResultStatistics(const BlendStatistics* statistics);
+
+private:
+    sf::RectangleShape m_background;
+    std::optional<sf::Text> m_text;
+    std::optional<BlendStatistics> m_resultStatistics;
+    sf::Clock m_refreshClock;
+    bool m_refreshed;
+
+    void refresh();
+};
+
 struct GUIPanel {
     sf::RectangleShape background;
     std::vector<Button> buttons;
@@ -127,6 +175,9 @@ public:
     void setOnApplyMask(std::function<void()> callback);
     void setOnBlendModeChange(std::function<void(BlendModeType)> callback);
     void setOnTransparentColorChange(std::function<void(const sf::Color&)> callback);
+    void setOnToleranceChange(std::function<void(int)> callback);
+
+    void setOnOpacityChange(std::function<void(int)> callback);
     void setOnUseAlphaChange(std::function<void(bool)> callback);
     void setOnMaskSelect(std::function<void(size_t)> callback);
     void setOnMaskOffsetChange(std::function<void(int, int)> callback);
@@ -136,6 +187,9 @@ public:
     void setHasResult(bool has);
     void setBlendMode(BlendModeType mode);
     void setTransparentColor(const sf::Color& color);
+    void setTolerance(int tolerance);
+
+    void setOpacity(int opacity);
     void setUseAlpha(bool use);
     void setMaskOffset(int x, int y);
     void setSourceSize(const sf::Vector2u& size);
@@ -145,12 +199,24 @@ public:
 
     sf::FloatRect getPreviewArea() const;
 
+    void setPerfOverlayVisible(bool visible);
+
+    bool isPerfOverlayVisible() const;
+
+    void setResultStatistics(const BlendStatistics* statistics);
+
+    bool isInteracting() const;
+
     void setStatusMessage(const std::string& message);
 
     BlendModeType getCurrentBlendMode() const;
 
     sf::Color getTransparentColor() const;
 
+    int getTolerance() const;
+
+    int getOpacity() const;
+
     bool getUseAlpha() const;
 
 private:
@@ -167,6 +233,11 @@ private:
     std::vector<Button> m_modeButtons;
     
     std::unique_ptr<ColorPicker> m_colorPicker;
+    std::unique_ptr<Slider> m_toleranceSlider;
+    std::unique_ptr<Slider> m_opacitySlider;
+
+    std::unique_ptr<PerfOverlay> m_perfOverlay;
+    bool m_perfOverlayVisible;
 
     Button* m_alphaCheckbox;
 
@@ -181,12 +252,21 @@ private:
     std::optional<sf::Text> m_statusText;
     std::optional<sf::Text> m_sizeInfoText;
 
+    sf::RenderTexture m_layer;
+    std::optional<sf::Sprite> m_layerSprite;
+    bool m_layerValid;
+    bool m_libraryDirty;
+    bool m_statusDirty;
+    bool m_sizeInfoDirty;
+
     std::function<void()> m_onLoadSource;
     std::function<void()> m_onLoadMask;
     std::function<void()> m_onSaveResult;
     std::function<void()> m_onApplyMask;
     std::function<void(BlendModeType)> m_onBlendModeChange;
     std::function<void(const sf::Color&)> m_onTransparentColorChange;
+    std::function<void(int)> m_onToleranceChange;
+    std::function<void(int)> m_onOpacityChange;
     std::function<void(bool)> m_onUseAlphaChange;
     std::function<void(size_t)> m_onMaskSelect;
     std::function<void(int, int)> m_onMaskOffsetChange;
@@ -196,6 +276,8 @@ private:
     bool m_hasResult;
     BlendModeType m_currentBlendMode;
     sf::Color m_transparentColor;
+    int m_tolerance;
+    int m_opacity;
     bool m_useAlpha;
     sf::Vector2i m_maskOffset;
     sf::Vector2u m_sourceSize;
@@ -206,7 +288,14 @@ private:
     void initializeModeButtons();
     void initializeColorPicker();
     void initializeSliders();
+    void handleToleranceSlider(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased);
+    void handleOpacitySlider(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased);
     void updateLayout();
+
+    void redrawLayer();
+    void redrawDirtyWidgets();
+    void drawLibrary(sf::RenderTarget& target);
+    void drawBackdrop(const sf::FloatRect& bounds, const sf::Color& color);
 };
 
 }
@@ -3,21 +3,52 @@
 #include <SFML/Graphics.hpp>
 #include <string>
 #include <optional>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstdint>
 #include "BlendMode.h"
+#include "BlendStatistics.h"
+#include "ThreadPool.h"
+#include "DirtyRegion.h"
+#include "BufferPool.h"
+#include "ImageResampler.h"
+#include "ResultHistory.h"
 
 namespace MaskOverlay {
 
+enum class MaskWrap {
+    None,
+    Repeat,
+    Mirror
+};
+
 class ImageProcessor {
 public:
     ImageProcessor();
+    ~ImageProcessor();
 
     bool loadSourceImage(const std::string& path);
 
     bool loadMask(const std::string& path);
 
+    bool setSourceImage(const sf::Image& image);
+
+    bool setMask(const sf::Image& image);
+
     void applyMask(BlendModeType mode, 
                    const sf::Color& transparentColor,
-                   bool useAlpha = true);
+                   bool useAlpha = true,
+                   int tolerance = BlendMode::DefaultTolerance,
+                   std::uint8_t opacity = 255);
+
+    bool computeMask(BlendModeType mode,
+                     const sf::Color& transparentColor,
+                     bool useAlpha = true,
+                     int tolerance = BlendMode::DefaultTolerance,
+                     std::uint8_t opacity = 255);
+
+    void publishResult();
 
     bool saveResult(const std::string& path);
 
@@ -27,6 +58,31 @@ public:
 
     void resetMaskOffset();
 
+    bool alignMask(const sf::Color& transparentColor, int tolerance = BlendMode::DefaultTolerance,
+                   std::atomic<int>* progress = nullptr);
+
+    bool setMaskTransform(const MaskTransform& transform, const sf::Color& fill = sf::Color::Transparent);
+
+    MaskTransform getMaskTransform() const;
+
+    void setSoftKey(int softness, bool despill = false, int feather = 0);
+
+    int getKeySoftness() const;
+
+    void setLinearLight(bool linear);
+
+    bool isLinearLight() const;
+
+    void setMaskWrap(MaskWrap wrap);
+
+    MaskWrap getMaskWrap() const;
+
+    void setCollectStatistics(bool collect);
+
+    bool isCollectingStatistics() const;
+
+    const BlendStatistics* getStatistics() const;
+
     sf::Vector2u getSourceSize() const;
 
     sf::Vector2u getMaskSize() const;
@@ -35,34 +91,168 @@ public:
 
     bool hasMask() const;
 
+    const sf::Image& getSourceImage() const;
+
+    const sf::Image& getMaskImage() const;
+
+    const sf::Image& getOriginalMaskImage() const;
+
     const sf::Texture& getSourceTexture() const;
 
     const sf::Texture& getMaskTexture() const;
 
     const sf::Texture& getResultTexture() const;
 
+    std::uint64_t getSourceGeneration() const;
+
+    std::uint64_t getMaskGeneration() const;
+
+    std::uint64_t getOriginalMaskGeneration() const;
+
+    std::uint64_t getResultGeneration() const;
+
+    std::uint64_t getResultRevision() const;
+
     bool hasResult() const;
 
     const sf::Image& getResultImage() const;
 
+    const std::uint8_t* getResultPixels() const;
+
+    sf::IntRect getLastApplyRegion() const;
+
+    bool undo();
+
+    bool redo();
+
+    bool canUndo() const;
+
+    bool canRedo() const;
+
+    void closeHistoryStep();
+
+    void setHistoryBudget(std::size_t bytes);
+
+    std::size_t getHistoryBytes() const;
+
+    static bool fitsInTexture(const sf::Vector2u& size);
+
+    void setThreadCount(unsigned int count);
+
+    unsigned int getThreadCount() const;
+
+    void setTexturesEnabled(bool enabled);
+
+    void setVisibleTextures(bool source, bool mask, bool result);
+
+    void setTextureBudget(std::size_t bytes);
+
+    std::size_t getTextureBytes() const;
+
+    void setKeepSourceImage(bool keep);
+
 private:
     sf::Image m_sourceImage;
     sf::Image m_maskImage;
-    sf::Image m_resultImage;
+    sf::Image m_transformedMask;
+    MaskTransform m_maskTransform;
+    sf::Color m_maskFill;
+    std::string m_sourcePath;
+    sf::Vector2u m_sourceSize;
+    bool m_sourceReleased;
+    bool m_keepSourceImage;
+    struct ResultBuffer {
+        std::unique_ptr<BufferPool::Buffer> pixels;
+        sf::Vector2u size;
+        std::optional<sf::IntRect> maskRect;
+        bool valid = false;
+    };
+    struct KeyCoverage {
+        std::vector<std::uint8_t> alpha;
+        std::vector<std::uint8_t> despilled;
+        std::uint64_t maskGeneration = 0;
+        sf::Color key;
+        int tolerance = 0;
+        int softness = 0;
+        bool despill = false;
+        int feather = 0;
+        bool useAlpha = false;
+        std::uint64_t revision = 0;
+        bool valid = false;
+    };
+    struct WrappedMask {
+        std::vector<std::uint8_t> pixels;
+        std::vector<std::uint8_t> alpha;
+        unsigned int width = 0;
+        std::uint64_t coverageRevision = 0;
+        MaskWrap wrap = MaskWrap::None;
+        bool valid = false;
+    };
+    KeyCoverage m_keyCoverage;
+    WrappedMask m_wrappedMask;
+    BlendStatistics m_sourceStatistics;
+    std::uint64_t m_sourceStatisticsGeneration;
+    std::optional<BlendStatistics> m_pendingStatistics;
+    std::optional<BlendStatistics> m_statistics;
+    std::uint64_t m_statisticsRevision;
+    ResultBuffer m_frontResult;
+    ResultBuffer m_backResult;
+    mutable sf::Image m_resultImage;
+    mutable bool m_resultImageValid;
+    sf::IntRect m_lastApplyRegion;
+    DirtyRegion m_resultDirty;
+    DirtyRegion m_pendingDirty;
+    sf::IntRect m_pendingRegion;
+    bool m_resultPending;
+    ResultHistory m_history;
+    std::vector<std::uint8_t> m_uploadBuffer;
     
     sf::Texture m_sourceTexture;
     sf::Texture m_maskTexture;
     sf::Texture m_resultTexture;
 
+    std::uint64_t m_sourceGeneration;
+    std::uint64_t m_maskGeneration;
+    std::uint64_t m_originalMaskGeneration;
+    std::uint64_t m_resultGeneration;
+    std::uint64_t m_resultRevision;
+
     sf::Vector2i m_maskOffset;
+    int m_keySoftness;
+    bool m_keyDespill;
+    int m_keyFeather;
+    bool m_linearLight;
+    MaskWrap m_maskWrap;
+    bool m_collectStatistics;
 
     bool m_hasSource;
     bool m_hasMask;
     bool m_hasResult;
+    bool m_texturesEnabled;
+    bool m_sourceTextureVisible;
+    bool m_maskTextureVisible;
+    bool m_resultTextureVisible;
+    bool m_sourceTextureValid;
+    bool m_maskTextureValid;
+    std::size_t m_textureBudget;
+
+    std::unique_ptr<ThreadPool> m_threadPool;
 
+    const sf::Image& getActiveMask() const;
+    bool rebuildTransformedMask();
     void updateSourceTexture();
     void updateMaskTexture();
     void updateResultTexture();
+    void syncTextures();
+    void releaseIdleTextures();
+    bool ensureSourceImage();
+    void releaseSourceImage();
+    void uploadResultRect(const sf::IntRect& rect);
+    bool stepHistory(bool forward);
+    void updateKeyCoverage(const sf::Color& transparentColor, int tolerance, bool useAlpha);
+    void featherKeyCoverage(int radius);
+    void updateWrappedMask();
+    void updateSourceStatistics();
 };
 
 }
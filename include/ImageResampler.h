@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+
+namespace MaskOverlay {
+
+enum class ResampleFilter {
+    Nearest,
+    Bilinear,
+    Area
+};
+
+struct MaskTransform {
+    float scale = 1.0f;
+    float rotation = 0.0f;
+    ResampleFilter filter = ResampleFilter::Area;
+
+    bool isIdentity() const;
+
+    bool operator==(const MaskTransform& other) const;
+
+    bool operator!=(const MaskTransform& other) const;
+};
+
+class ImageResampler {
+public:
+    static sf::Image resizeArea(const sf::Image& image, const sf::Vector2u& size);
+
+    static void resizeArea(const std::uint8_t* source, const sf::Vector2u& sourceSize,
+                           std::uint8_t* target, const sf::Vector2u& size, const sf::IntRect& region);
+
+    static sf::IntRect mapRegion(const sf::IntRect& rect, const sf::Vector2u& sourceSize, const sf::Vector2u& size);
+
+    static sf::Image resizeNearest(const sf::Image& image, const sf::Vector2u& size);
+
+    static sf::Vector2u transformedSize(const sf::Vector2u& size, const MaskTransform& transform);
+
+    static void transformRows(const std::uint8_t* source, const sf::Vector2u& sourceSize,
+                              std::uint8_t* target, const sf::Vector2u& size,
+                              const MaskTransform& transform, const sf::Color& fill,
+                              unsigned int rowBegin, unsigned int rowEnd);
+
+    static sf::Vector2u fitSize(const sf::Vector2u& size, const sf::Vector2f& bounds);
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <complex>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "ThreadPool.h"
+
+namespace MaskOverlay {
+
+struct AlignResult {
+    sf::Vector2i offset;
+    double score = 0.0;
+};
+
+class MaskAligner {
+public:
+    static constexpr unsigned int CoarseSize = 256;
+
+    static constexpr unsigned int MinCoarseMask = 8;
+
+    static constexpr unsigned int MaxTransformSize = 1024;
+
+    static constexpr unsigned int TileSize = 256;
+
+    static constexpr int Candidates = 16;
+
+    static constexpr double PruneMargin = 0.15;
+
+    static std::optional<AlignResult> align(const sf::Image& source,
+                                            const sf::Image& mask,
+                                            const sf::Color& transparentColor,
+                                            int tolerance,
+                                            ThreadPool& pool,
+                                            std::atomic<int>* progress = nullptr);
+
+    static void fft2D(std::vector<std::complex<float>>& data, const sf::Vector2u& size, bool inverse, ThreadPool& pool);
+
+private:
+    struct Plane {
+        sf::Vector2i origin;
+        sf::Vector2u size;
+        std::vector<std::uint8_t> luma;
+        std::vector<std::uint8_t> covered;
+    };
+
+    struct Match {
+        sf::Vector2i position;
+        double score = -2.0;
+        bool valid = false;
+    };
+
+    static Plane buildPlane(const sf::Image& image, unsigned int level, const sf::IntRect& region,
+                            const sf::Color* transparentColor, int tolerance, ThreadPool& pool);
+
+    static std::vector<sf::Vector2i> correlate(const Plane& source, const Plane& mask, long long minOverlap,
+                                               ThreadPool& pool, std::atomic<int>* progress);
+
+    static Match refine(const Plane& source, const Plane& mask, const sf::Vector2i& position,
+                        long long minOverlap, ThreadPool& pool);
+
+    static void prune(std::vector<Match>& matches);
+
+    static long long countCovered(const Plane& plane);
+};
+
+}
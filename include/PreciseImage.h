@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include <cstddef>
+
+namespace MaskOverlay {
+
+enum class PixelFormat {
+    UInt16,
+    Float32
+};
+
+class PreciseImage {
+public:
+    PreciseImage();
+
+    void create(const sf::Vector2u& size, PixelFormat format);
+
+    void assign(const sf::Image& image, PixelFormat format);
+
+    void convert(PixelFormat format);
+
+    bool loadFromFile(const std::string& path);
+
+    bool saveToFile(const std::string& path) const;
+
+    sf::Image toImage() const;
+
+    sf::Vector2u getSize() const;
+
+    PixelFormat getFormat() const;
+
+    bool isEmpty() const;
+
+    void readRow(unsigned int y, unsigned int x, std::size_t count, float* pixels) const;
+
+    void writeRow(unsigned int y, unsigned int x, std::size_t count, const float* pixels);
+
+    static bool isPreciseFile(const std::string& path);
+
+private:
+    sf::Vector2u m_size;
+    PixelFormat m_format;
+    std::vector<std::uint16_t> m_pixels16;
+    std::vector<float> m_pixelsFloat;
+
+    bool loadNetpbm(std::istream& file, const std::string& magic);
+    bool loadPfm(std::istream& file, bool color);
+    bool saveNetpbm(const std::string& path, bool alpha) const;
+    bool savePfm(const std::string& path) const;
+    static std::string extension(const std::string& path);
+};
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "BlendMode.h"
+#include "PreciseImage.h"
+#include "ThreadPool.h"
+
+namespace MaskOverlay {
+
+class PreciseProcessor {
+public:
+    explicit PreciseProcessor(PixelFormat format = PixelFormat::UInt16);
+
+    bool loadSourceImage(const std::string& path);
+
+    bool loadMask(const std::string& path);
+
+    bool setSourceImage(const PreciseImage& image);
+
+    bool setMask(const PreciseImage& image);
+
+    void applyMask(BlendModeType mode,
+                   const sf::Color& transparentColor,
+                   bool useAlpha = true,
+                   int tolerance = BlendMode::DefaultTolerance,
+                   std::uint8_t opacity = 255);
+
+    bool saveResult(const std::string& path) const;
+
+    void setMaskOffset(int x, int y);
+
+    sf::Vector2i getMaskOffset() const;
+
+    sf::Vector2u getSourceSize() const;
+
+    sf::Vector2u getMaskSize() const;
+
+    PixelFormat getFormat() const;
+
+    bool hasResult() const;
+
+    const PreciseImage& getResult() const;
+
+    void setThreadCount(unsigned int count);
+
+    unsigned int getThreadCount() const;
+
+private:
+    PixelFormat m_format;
+    PreciseImage m_sourceImage;
+    PreciseImage m_maskImage;
+    PreciseImage m_resultImage;
+    sf::Vector2i m_maskOffset;
+    bool m_hasResult;
+
+    std::unique_ptr<ThreadPool> m_threadPool;
+};
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include "ImageProcessor.h"
+#include "BlendMode.h"
+
+namespace MaskOverlay {
+
+class PreviewProxy {
+public:
+    PreviewProxy();
+
+    bool update(const ImageProcessor& processor, const sf::Vector2f& previewSize);
+
+    bool isActive() const;
+
+    void applyMask(const sf::Vector2i& maskOffset,
+                   BlendModeType mode,
+                   const sf::Color& transparentColor,
+                   bool useAlpha = true,
+                   int tolerance = BlendMode::DefaultTolerance,
+                   std::uint8_t opacity = 255);
+
+    void setSoftKey(int softness, bool despill, int feather);
+
+    void setMaskTransform(const MaskTransform& transform);
+
+    void setLinearLight(bool linear);
+
+    void setMaskWrap(MaskWrap wrap);
+
+    float getScale() const;
+
+    const ImageProcessor& getProcessor() const;
+
+private:
+    ImageProcessor m_processor;
+    float m_scale;
+    bool m_active;
+    sf::Vector2u m_proxySize;
+    std::uint64_t m_sourceGeneration;
+    std::uint64_t m_maskGeneration;
+    MaskTransform m_maskTransform;
+};
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace MaskOverlay {
+
+enum class ProfileStage {
+    Decode,
+    Blend,
+    Upload,
+    Render,
+    Frame,
+    Count
+};
+
+enum class ProfileCounter {
+    UploadBytes,
+    DrawCalls,
+    Count
+};
+
+struct StageStatistics {
+    double last = 0;
+    double p50 = 0;
+    double p95 = 0;
+    double p99 = 0;
+};
+
+struct CounterStatistics {
+    std::uint64_t last = 0;
+    double average = 0;
+    std::uint64_t peak = 0;
+};
+
+class Profiler {
+public:
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void addSample(ProfileStage stage, double milliseconds);
+
+    static void addCount(ProfileCounter counter, std::uint64_t value) {
+        if (isEnabled()) {
+            s_frameCounters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    static void countDrawCall() {
+        addCount(ProfileCounter::DrawCalls, 1);
+    }
+
+    static void recordApply(std::uint64_t pixels, double milliseconds);
+
+    static void endFrame();
+
+    static StageStatistics getStageStatistics(ProfileStage stage);
+
+    static CounterStatistics getCounterStatistics(ProfileCounter counter);
+
+    static double getLastApplyMegapixelsPerSecond();
+
+    static std::string getStageName(ProfileStage stage);
+
+private:
+    inline static std::atomic<bool> s_enabled{false};
+    inline static std::atomic<std::uint64_t> s_frameCounters[static_cast<int>(ProfileCounter::Count)]{};
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage)
+        : m_stage(stage)
+        , m_active(Profiler::isEnabled())
+    {
+        if (m_active) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ProfileScope() {
+        if (m_active) {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+            Profiler::addSample(m_stage, elapsed.count());
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileStage m_stage;
+    bool m_active;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <deque>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "DirtyRegion.h"
+#include "ThreadPool.h"
+
+namespace MaskOverlay {
+
+class ResultHistory {
+public:
+    static constexpr int TileSize = 64;
+
+    explicit ResultHistory(std::size_t budget = std::size_t(256) << 20);
+
+    void record(const std::uint8_t* before,
+                const std::uint8_t* after,
+                const sf::Vector2u& size,
+                const sf::IntRect& region,
+                const std::optional<sf::IntRect>& beforeMaskRect,
+                const std::optional<sf::IntRect>& afterMaskRect,
+                ThreadPool& pool);
+
+    void closeStep();
+
+    bool undo(std::uint8_t* pixels, DirtyRegion& changed, std::optional<sf::IntRect>& maskRect, ThreadPool& pool);
+
+    bool redo(std::uint8_t* pixels, DirtyRegion& changed, std::optional<sf::IntRect>& maskRect, ThreadPool& pool);
+
+    bool canUndo() const;
+
+    bool canRedo() const;
+
+    void clear();
+
+    void setBudget(std::size_t bytes);
+
+    std::size_t getBudget() const;
+
+    std::size_t getBytes() const;
+
+private:
+    struct Tile {
+        std::uint32_t index;
+        std::vector<std::uint8_t> data;
+    };
+    struct Step {
+        std::vector<Tile> tiles;
+        std::optional<sf::IntRect> beforeMaskRect;
+        std::optional<sf::IntRect> afterMaskRect;
+        std::size_t bytes = 0;
+    };
+
+    std::deque<Step> m_steps;
+    std::size_t m_position;
+    std::size_t m_bytes;
+    std::size_t m_budget;
+    sf::Vector2u m_size;
+    bool m_open;
+
+    sf::IntRect tileRect(std::uint32_t index) const;
+    void applyStep(const Step& step, std::uint8_t* pixels, DirtyRegion& changed, ThreadPool& pool) const;
+    void trimToBudget();
+    static void encode(const std::uint8_t* delta, std::size_t count, std::vector<std::uint8_t>& out);
+    static void apply(const std::vector<std::uint8_t>& data, std::uint8_t* pixels, std::size_t stride, const sf::IntRect& rect);
+};
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "ImageProcessor.h"
+
+namespace MaskOverlay {
+
+class SplitView {
+public:
+    SplitView();
+
+    void update(const ImageProcessor& source, const ImageProcessor& result, const sf::FloatRect& area);
+
+    void draw(sf::RenderTarget& target);
+
+    void clear();
+
+    void setDivider(float position);
+
+    void setDividerFromPoint(float x);
+
+    float getDivider() const;
+
+    bool isOnDivider(const sf::Vector2f& point) const;
+
+    sf::FloatRect getImageRect() const;
+
+private:
+    struct Layer {
+        sf::Texture texture;
+        std::vector<std::uint8_t> pixels;
+        bool valid = false;
+    };
+
+    Layer m_source;
+    Layer m_result;
+    sf::Vector2u m_size;
+    sf::FloatRect m_area;
+    sf::FloatRect m_imageRect;
+    float m_divider;
+    std::uint64_t m_sourceGeneration;
+    const ImageProcessor* m_resultProcessor;
+    std::uint64_t m_resultGeneration;
+    std::uint64_t m_resultRevision;
+
+    void uploadLayer(Layer& layer);
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace MaskOverlay {
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int getThreadCount() const;
+
+    void parallelFor(std::size_t count,
+                     const std::function<void(std::size_t, std::size_t)>& task,
+                     std::size_t chunkSize = 0);
+
+    static unsigned int getHardwareThreadCount();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    const std::function<void(std::size_t, std::size_t)>* m_task;
+    std::size_t m_count;
+    std::size_t m_chunkSize;
+    std::atomic<std::size_t> m_nextIndex;
+    unsigned int m_busyWorkers;
+    std::uint64_t m_generation;
+    bool m_stopping;
+
+    void workerLoop();
+    void runChunks();
+};
+
+}
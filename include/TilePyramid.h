@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "DirtyRegion.h"
+
+namespace MaskOverlay {
+
+class TilePyramid {
+public:
+    explicit TilePyramid(unsigned int tileSize = 512);
+
+    void setImage(const std::uint8_t* pixels, const sf::Vector2u& size);
+
+    void invalidate(const sf::IntRect& rect);
+
+    void invalidateAll();
+
+    void clear();
+
+    void draw(sf::RenderTarget& target, const sf::FloatRect& area, const sf::Vector2f& center, float zoom);
+
+    sf::Vector2u getSize() const;
+
+    unsigned int getLevelCount() const;
+
+    sf::Vector2u getLevelSize(unsigned int level) const;
+
+    const std::uint8_t* getLevelPixels(unsigned int level);
+
+    void setMaxTiles(std::size_t maxTiles);
+
+private:
+    struct Level {
+        sf::Vector2u size;
+        std::vector<std::uint8_t> pixels;
+        bool built = false;
+        DirtyRegion dirty;
+    };
+
+    struct Tile {
+        sf::Texture texture;
+        unsigned int level = 0;
+        sf::IntRect rect;
+        bool stale = true;
+        std::uint64_t lastUsed = 0;
+    };
+
+    const std::uint8_t* m_pixels;
+    sf::Vector2u m_size;
+    unsigned int m_tileSize;
+    std::vector<Level> m_levels;
+    std::unordered_map<std::uint64_t, Tile> m_tiles;
+    std::vector<std::uint8_t> m_uploadBuffer;
+    std::size_t m_maxTiles;
+    std::uint64_t m_frame;
+
+    void ensureLevel(unsigned int level);
+    void downsample(unsigned int level, const sf::IntRect& rect);
+    void uploadTile(Tile& tile, unsigned int level, const sf::IntRect& rect);
+    void evictTiles();
+    static std::uint64_t tileKey(unsigned int level, unsigned int x, unsigned int y);
+};
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace MaskOverlay {
+
+struct TraceEvent {
+    const char* name = "";
+    const char* category = "";
+    std::uint32_t threadId = 0;
+    std::int64_t start = 0;
+    std::int64_t duration = 0;
+    std::string args;
+};
+
+class Tracer {
+public:
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled() {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void setCapacity(std::size_t capacity);
+
+    static void record(TraceEvent&& event);
+
+    static void clear();
+
+    static bool dumpChromeTrace(const std::string& path);
+
+    static void setThreadName(const std::string& name);
+
+    static std::uint32_t getThreadId();
+
+    static std::int64_t now();
+
+private:
+    inline static std::atomic<bool> s_enabled{false};
+};
+
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    bool isActive() const {
+        return m_active;
+    }
+
+    void addArg(const char* key, long long value);
+    void addArg(const char* key, const std::string& value);
+
+private:
+    TraceEvent m_event;
+    bool m_active;
+};
+
+}
@@ -1,4 +1,9 @@
 #include "Application.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
 #include <optional>
@@ -11,14 +16,33 @@ namespace MaskOverlay {
 
 Application::Application()
     : m_window(sf::VideoMode({1200, 800}), "Nakladanie masek - Projekt")
+    , m_sourceTilesGeneration(0)
+    , m_draggingDivider(false)
+    , m_zoomed(false)
+    , m_zoom(1.0f)
+    , m_viewCenter(0, 0)
+    , m_panning(false)
     , m_currentBlendMode(BlendModeType::Replace)
     , m_transparentColor(sf::Color::Magenta)
+    , m_tolerance(BlendMode::DefaultTolerance)
+    , m_opacity(255)
+    , m_softKey(false)
     , m_useAlpha(true)
     , m_maskOffset(0, 0)
+    , m_maskTransformPending(false)
     , m_viewMode(ViewMode::Source)
     , m_draggingMask(false)
     , m_dragStart(0, 0)
     , m_dragStartOffset(0, 0)
+    , m_showingProxy(false)
+    , m_fullApplyPending(false)
+    , m_liveApply(false)
+    , m_liveApplyPending(false)
+    , m_aligning(false)
+    , m_alignFound(false)
+    , m_alignProgress(0)
+    , m_shownAlignProgress(-1)
+    , m_redrawRequested(true)
 {
     m_window.setFramerateLimit(60);
 }
@@ -34,7 +58,17 @@ int Application::run() {
     while (m_window.isOpen()) {
         handleEvents();
         update();
+        
+        if (!m_redrawRequested || !m_window.isOpen()) {
+            continue;
+        }
+        m_redrawRequested = false;
+        
         render();
+        m_window.display();
+        
+        Profiler::addSample(ProfileStage::Frame, m_frameClock.restart().asMicroseconds() / 1000.0);
+        Profiler::endFrame();
     }
     
     return 0;
@@ -45,13 +79,22 @@ bool Application::initialize() {
         return false;
     }
     
+    Tracer::setThreadName("Glowny");
+    Tracer::setEnabled(true);
+    
     m_processor = std::make_unique<ImageProcessor>();
+    m_previewProxy = std::make_unique<PreviewProxy>();
     m_maskLibrary = std::make_unique<MaskLibrary>();
     m_gui = std::make_unique<GUI>(m_window, m_font);
     
     initializeCallbacks();
     loadDefaultMasks();
     
+    m_helpText.emplace(m_font, "1-Zrodlo  2-Maska  3-Wynik  4-Podziel  Spacja-Zastosuj  R-Reset  K-Miekki klucz  L-Liniowe  W-Powtarzanie  A-Na zywo  F/T-Dopasuj/Resetuj maske  G-Wyrownaj maske  Ctrl/Shift+Kolko-Skala/Obrot  Ctrl+Z/Ctrl+Y-Cofnij/Ponow  Ctrl+S-Zapisz  Kolko/PPM-Powieksz/Przesun  0-Dopasuj  F3-Statystyki  F12-Slad", 11);
+    m_helpText->setFillColor(sf::Color(150, 150, 150));
+    m_previewBackground.setFillColor(sf::Color(50, 50, 55));
+    updatePreviewLayout();
+    
     setStatusMessage("Gotowy - wczytaj obraz i maske");
     
     return true;
@@ -89,24 +132,47 @@ void Application::initializeCallbacks() {
     m_gui->setOnBlendModeChange([this](BlendModeType mode) {
         m_currentBlendMode = mode;
         setStatusMessage("Tryb nakladania: " + BlendMode::getModeName(mode));
+        scheduleLiveApply();
     });
     
     m_gui->setOnTransparentColorChange([this](const sf::Color& color) {
         m_transparentColor = color;
+        scheduleLiveApply();
+        if (m_gui->isInteracting() && (m_processor->hasResult() || m_showingProxy)) {
+            applyPreview();
+        }
+    });
+    
+    m_gui->setOnToleranceChange([this](int tolerance) {
+        m_tolerance = tolerance;
+        scheduleLiveApply();
+        if (m_gui->isInteracting() && (m_processor->hasResult() || m_showingProxy)) {
+            applyPreview();
+        }
+    });
+    
+    m_gui->setOnOpacityChange([this](int opacity) {
+        m_opacity = static_cast<std::uint8_t>(opacity);
+        scheduleLiveApply();
+        if (m_gui->isInteracting() && (m_processor->hasResult() || m_showingProxy)) {
+            applyPreview();
+        }
     });
     
     m_gui->setOnUseAlphaChange([this](bool use) {
         m_useAlpha = use;
         setStatusMessage(use ? "Kanal alfa: wlaczony" : "Kanal alfa: wylaczony");
+        scheduleLiveApply();
     });
     
     m_gui->setOnMaskSelect([this](size_t index) {
         selectMaskFromLibrary(index);
     });
     
+    // Przesuniecie trafia do procesora przy zastosowaniu - w tym czasie moze liczyc w tle
     m_gui->setOnMaskOffsetChange([this](int x, int y) {
         m_maskOffset = sf::Vector2i(x, y);
-        m_processor->setMaskOffset(x, y);
+        scheduleLiveApply();
     });
 }
 
@@ -136,45 +202,74 @@ void Application::loadDefaultMasks() {
 }
 
 void Application::handleEvents() {
-    while (const std::optional<sf::Event> event = m_window.pollEvent()) {
-        if (event->is<sf::Event::Closed>()) {
-            m_window.close();
-            return;
-        }
+    if (!isAnimating()) {
+        // W bezczynnosci watek spi w waitEvent; limit czasu odswieza nakladke statystyk
+        sf::Time timeout = m_gui->isPerfOverlayVisible() ? sf::milliseconds(250) : sf::seconds(1);
+        const std::optional<sf::Event> event = m_window.waitEvent(timeout);
+        m_frameClock.restart();
         
-        if (const auto* keyPressed = event->getIf<sf::Event::KeyPressed>()) {
-            handleKeyPress(keyPressed->code);
-        }
-        
-        if (const auto* mousePressed = event->getIf<sf::Event::MouseButtonPressed>()) {
-            sf::Vector2f pos(static_cast<float>(mousePressed->position.x), 
-                           static_cast<float>(mousePressed->position.y));
-            handleMousePress(mousePressed->button, pos);
-            m_gui->handleMouseClick(pos);
-        }
-        
-        if (const auto* mouseReleased = event->getIf<sf::Event::MouseButtonReleased>()) {
-            sf::Vector2f pos(static_cast<float>(mouseReleased->position.x), 
-                           static_cast<float>(mouseReleased->position.y));
-            handleMouseRelease(mouseReleased->button, pos);
-        }
-        
-        if (const auto* mouseMoved = event->getIf<sf::Event::MouseMoved>()) {
-            sf::Vector2f pos(static_cast<float>(mouseMoved->position.x), 
-                           static_cast<float>(mouseMoved->position.y));
-            handleMouseMove(pos);
-        }
-        
-        if (const auto* mouseWheel = event->getIf<sf::Event::MouseWheelScrolled>()) {
-            sf::Vector2f pos(static_cast<float>(sf::Mouse::getPosition(m_window).x), 
-                           static_cast<float>(sf::Mouse::getPosition(m_window).y));
-            handleMouseWheel(mouseWheel->delta);
-            m_gui->handleMouseWheel(pos, mouseWheel->delta);
+        if (!event) {
+            if (m_gui->isPerfOverlayVisible()) {
+                requestRedraw();
+            }
+            return;
         }
-        
-        if (event->is<sf::Event::Resized>()) {
-            m_gui->handleResize();
+        handleEvent(*event);
+    } else {
+        m_frameClock.restart();
+        requestRedraw();
+    }
+    
+    while (m_window.isOpen()) {
+        const std::optional<sf::Event> event = m_window.pollEvent();
+        if (!event) {
+            break;
         }
+        handleEvent(*event);
+    }
+}
+
+void Application::handleEvent(const sf::Event& event) {
+    requestRedraw();
+    
+    if (event.is<sf::Event::Closed>()) {
+        m_window.close();
+        return;
+    }
+    
+    if (const auto* keyPressed = event.getIf<sf::Event::KeyPressed>()) {
+        handleKeyPress(keyPressed->code);
+    }
+    
+    if (const auto* mousePressed = event.getIf<sf::Event::MouseButtonPressed>()) {
+        sf::Vector2f pos(static_cast<float>(mousePressed->position.x), 
+                       static_cast<float>(mousePressed->position.y));
+        handleMousePress(mousePressed->button, pos);
+        m_gui->handleMouseClick(pos);
+    }
+    
+    if (const auto* mouseReleased = event.getIf<sf::Event::MouseButtonReleased>()) {
+        sf::Vector2f pos(static_cast<float>(mouseReleased->position.x), 
+                       static_cast<float>(mouseReleased->position.y));
+        handleMouseRelease(mouseReleased->button, pos);
+    }
+    
+    if (const auto* mouseMoved = event.getIf<sf::Event::MouseMoved>()) {
+        sf::Vector2f pos(static_cast<float>(mouseMoved->position.x), 
+                       static_cast<float>(mouseMoved->position.y));
+        handleMouseMove(pos);
+    }
+    
+    if (const auto* mouseWheel = event.getIf<sf::Event::MouseWheelScrolled>()) {
+        sf::Vector2f pos(static_cast<float>(sf::Mouse::getPosition(m_window).x), 
+                       static_cast<float>(sf::Mouse::getPosition(m_window).y));
+        handleMouseWheel(pos, mouseWheel->delta);
+        m_gui->handleMouseWheel(pos, mouseWheel->delta);
+    }
+    
+    if (event.is<sf::Event::Resized>()) {
+        m_gui->handleResize();
+        updatePreviewLayout();
     }
 }
 
@@ -205,16 +300,94 @@ void Application::handleKeyPress(sf::Keyboard::Key key) {
                 saveResult();
             }
             break;
+        case sf::Keyboard::Key::Z:
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
+                sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl)) {
+                // Ctrl+Shift+Z - ponow, jak w wiekszosci edytorow
+                stepHistory(sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
+                            sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift));
+            }
+            break;
+        case sf::Keyboard::Key::Y:
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
+                sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl)) {
+                stepHistory(true);
+            }
+            break;
         case sf::Keyboard::Key::O:
             if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
                 sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl)) {
                 loadSourceImage();
             }
             break;
+        case sf::Keyboard::Key::Num0:
+            resetZoom();
+            setStatusMessage("Widok: dopasowany do okna");
+            break;
         case sf::Keyboard::Key::R:
-            m_processor->resetMaskOffset();
             m_maskOffset = sf::Vector2i(0, 0);
             setStatusMessage("Przesuniecie maski zresetowane");
+            scheduleLiveApply();
+            break;
+        case sf::Keyboard::Key::F:
+            fitMaskToSource();
+            break;
+        case sf::Keyboard::Key::G:
+            alignMask();
+            break;
+        case sf::Keyboard::Key::T:
+            transformMask(MaskTransform());
+            setStatusMessage("Transformacja maski zresetowana");
+            break;
+        case sf::Keyboard::Key::K:
+            // Miekki klucz z odjeciem koloru klucza i lekkim zmiekczeniem krawedzi
+            finishBackgroundApply();
+            m_softKey = !m_softKey;
+            m_processor->setSoftKey(m_softKey ? 32 : 0, m_softKey, m_softKey ? 1 : 0);
+            m_previewProxy->setSoftKey(m_softKey ? 32 : 0, m_softKey, 0);
+            setStatusMessage(m_softKey ? "Miekki klucz: wlaczony" : "Miekki klucz: wylaczony");
+            if (m_processor->hasResult()) {
+                applyMask();
+            }
+            break;
+        case sf::Keyboard::Key::L:
+            // Mieszanie w swietle liniowym zamiast na wartosciach z gamma
+            finishBackgroundApply();
+            m_processor->setLinearLight(!m_processor->isLinearLight());
+            m_previewProxy->setLinearLight(m_processor->isLinearLight());
+            setStatusMessage(m_processor->isLinearLight() ? "Mieszanie liniowe: wlaczone" : "Mieszanie liniowe: wylaczone");
+            if (m_processor->hasResult()) {
+                applyMask();
+            }
+            break;
+        case sf::Keyboard::Key::W: {
+            // Maska pojedyncza, powtarzana lub powtarzana z odbiciem; przesuniecie jest faza
+            finishBackgroundApply();
+            const MaskWrap wrap = m_processor->getMaskWrap() == MaskWrap::None ? MaskWrap::Repeat :
+                                  m_processor->getMaskWrap() == MaskWrap::Repeat ? MaskWrap::Mirror : MaskWrap::None;
+            m_processor->setMaskWrap(wrap);
+            m_previewProxy->setMaskWrap(wrap);
+            setStatusMessage(wrap == MaskWrap::None ? "Powtarzanie maski: wylaczone" :
+                             wrap == MaskWrap::Repeat ? "Powtarzanie maski: powtorz" : "Powtarzanie maski: odbicie");
+            if (m_processor->hasResult()) {
+                applyMask();
+            }
+            break;
+        }
+        case sf::Keyboard::Key::A:
+            m_liveApply = !m_liveApply;
+            setStatusMessage(m_liveApply ? "Podglad na zywo: wlaczony" : "Podglad na zywo: wylaczony");
+            scheduleLiveApply();
+            break;
+        case sf::Keyboard::Key::F3:
+            m_gui->setPerfOverlayVisible(!m_gui->isPerfOverlayVisible());
+            Profiler::setEnabled(m_gui->isPerfOverlayVisible());
+            // Statystyki wyniku kosztuja czas mieszania - zbierane tylko przy widocznej nakladce
+            finishBackgroundApply();
+            m_processor->setCollectStatistics(m_gui->isPerfOverlayVisible());
+            break;
+        case sf::Keyboard::Key::F12:
+            saveTrace();
             break;
         case sf::Keyboard::Key::Escape:
             m_window.close();
@@ -227,12 +400,25 @@ void Application::handleKeyPress(sf::Keyboard::Key key) {
 void Application::handleMousePress(sf::Mouse::Button button, const sf::Vector2f& pos) {
     sf::FloatRect previewArea = m_gui->getPreviewArea();
     
+    if ((button == sf::Mouse::Button::Right || button == sf::Mouse::Button::Middle) &&
+        m_zoomed && previewArea.contains(pos)) {
+        m_panning = true;
+        m_panStart = pos;
+        m_panStartCenter = m_viewCenter;
+    }
+    
+    if (button == sf::Mouse::Button::Left && m_viewMode == ViewMode::SplitView && m_splitView.isOnDivider(pos)) {
+        m_draggingDivider = true;
+        return;
+    }
+    
     if (button == sf::Mouse::Button::Left && previewArea.contains(pos)) {
         if (m_processor->hasMask() && m_processor->hasSourceImage()) {
             sf::Vector2u maskSize = m_processor->getMaskSize();
             sf::Vector2u sourceSize = m_processor->getSourceSize();
             
-            if (maskSize.x > sourceSize.x || maskSize.y > sourceSize.y) {
+            if (maskSize.x > sourceSize.x || maskSize.y > sourceSize.y ||
+                m_processor->getMaskWrap() != MaskWrap::None) {
                 m_draggingMask = true;
                 m_dragStart = sf::Vector2i(static_cast<int>(pos.x), static_cast<int>(pos.y));
                 m_dragStartOffset = m_maskOffset;
@@ -244,10 +430,24 @@ void Application::handleMousePress(sf::Mouse::Button button, const sf::Vector2f&
 void Application::handleMouseRelease(sf::Mouse::Button button, const sf::Vector2f& pos) {
     if (button == sf::Mouse::Button::Left) {
         m_draggingMask = false;
+        m_draggingDivider = false;
+    }
+    
+    if (button == sf::Mouse::Button::Right || button == sf::Mouse::Button::Middle) {
+        m_panning = false;
     }
 }
 
 void Application::handleMouseMove(const sf::Vector2f& pos) {
+    if (m_draggingDivider) {
+        m_splitView.setDividerFromPoint(pos.x);
+    }
+    
+    if (m_panning) {
+        m_viewCenter = m_panStartCenter - (pos - m_panStart) / m_zoom;
+        clampViewCenter();
+    }
+    
     if (m_draggingMask) {
         int dx = static_cast<int>(pos.x) - m_dragStart.x;
         int dy = static_cast<int>(pos.y) - m_dragStart.y;
@@ -255,91 +455,223 @@ void Application::handleMouseMove(const sf::Vector2f& pos) {
         m_maskOffset.x = m_dragStartOffset.x - dx;
         m_maskOffset.y = m_dragStartOffset.y - dy;
         
-        m_processor->setMaskOffset(m_maskOffset.x, m_maskOffset.y);
-        
         if (m_processor->hasSourceImage() && m_processor->hasMask()) {
-            applyMask();
+            applyPreview();
+        }
+    }
+}
+
+void Application::handleMouseWheel(const sf::Vector2f& pos, float delta) {
+    sf::FloatRect previewArea = m_gui->getPreviewArea();
+    
+    // Ctrl - skala maski, Shift - obrot maski
+    bool control = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl) ||
+                   sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RControl);
+    bool shift = sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift) ||
+                 sf::Keyboard::isKeyPressed(sf::Keyboard::Key::RShift);
+    if ((control || shift) && previewArea.contains(pos) && m_processor->hasMask()) {
+        MaskTransform transform = m_maskTransform;
+        if (control) {
+            transform.scale = std::clamp(transform.scale * std::pow(1.05f, delta), 0.01f, 16.0f);
+        } else {
+            transform.rotation = std::fmod(transform.rotation + 2.0f * delta + 360.0f, 360.0f);
+            if (std::abs(transform.rotation) < 0.01f || std::abs(transform.rotation - 360.0f) < 0.01f) {
+                transform.rotation = 0.0f;
+            }
         }
+        transformMask(transform);
+        return;
+    }
+    
+    if (!previewArea.contains(pos) || !m_processor->hasSourceImage() ||
+        (m_viewMode != ViewMode::Source && m_viewMode != ViewMode::Result)) {
+        return;
     }
+    
+    // Punkt obrazu pod kursorem pozostaje w miejscu
+    float fitZoom = getFitZoom();
+    float zoom = getViewZoom();
+    sf::Vector2f cursor = pos - (previewArea.position + previewArea.size / 2.0f);
+    sf::Vector2f anchor = getViewCenter() + cursor / zoom;
+    float newZoom = std::clamp(zoom * std::pow(1.25f, delta), fitZoom, std::max(fitZoom, 32.0f));
+    
+    if (newZoom <= fitZoom) {
+        resetZoom();
+    } else {
+        m_zoomed = true;
+        m_zoom = newZoom;
+        m_viewCenter = anchor - cursor / newZoom;
+        clampViewCenter();
+    }
+    
+    setStatusMessage("Powiekszenie: " + std::to_string(static_cast<int>(std::lround(getViewZoom() * 100))) + "%");
+}
+
+float Application::getFitZoom() const {
+    sf::FloatRect previewArea = m_gui->getPreviewArea();
+    sf::Vector2u size = m_processor->getSourceSize();
+    if (size.x == 0 || size.y == 0) {
+        return 1.0f;
+    }
+    return std::min(previewArea.size.x / size.x, previewArea.size.y / size.y);
+}
+
+float Application::getViewZoom() const {
+    return m_zoomed ? m_zoom : getFitZoom();
+}
+
+sf::Vector2f Application::getViewCenter() const {
+    if (m_zoomed) {
+        return m_viewCenter;
+    }
+    sf::Vector2u size = m_processor->getSourceSize();
+    return sf::Vector2f(size.x / 2.0f, size.y / 2.0f);
+}
+
+void Application::clampViewCenter() {
+    sf::Vector2u size = m_processor->getSourceSize();
+    m_viewCenter.x = std::clamp(m_viewCenter.x, 0.0f, static_cast<float>(size.x));
+    m_viewCenter.y = std::clamp(m_viewCenter.y, 0.0f, static_cast<float>(size.y));
+}
+
+void Application::resetZoom() {
+    m_zoomed = false;
+    m_panning = false;
+}
+
+bool Application::useTiledView() const {
+    return m_zoomed || !ImageProcessor::fitsInTexture(m_processor->getSourceSize());
+}
+
+void Application::drawTiled(TilePyramid& tiles) {
+    tiles.draw(m_window, m_gui->getPreviewArea(), getViewCenter(), getViewZoom());
+}
+
+void Application::drawSourcePreview() {
+    if (!m_processor->hasSourceImage()) {
+        return;
+    }
+    
+    if (useTiledView()) {
+        drawTiled(m_sourceTiles);
+    } else if (m_sourceSprite.has_value()) {
+        m_window.draw(*m_sourceSprite);
+        Profiler::countDrawCall();
+    }
+}
+
+bool Application::isInteracting() const {
+    return m_draggingMask || m_panning || m_draggingDivider || m_gui->isInteracting() ||
+           (m_maskTransformPending && m_maskTransformClock.getElapsedTime() < sf::milliseconds(300));
+}
+
+bool Application::isAnimating() const {
+    // Petla nie zasypia, dopoki wynik w tle nie zostanie policzony i pokazany
+    return isInteracting() || m_liveApplyPending || m_applyWorker.isBusy();
 }
 
-void Application::handleMouseWheel(float delta) {
+void Application::requestRedraw() {
+    m_redrawRequested = true;
 }
 
 void Application::update() {
     m_gui->update();
+    
+    // Wynik policzony w tle jest zamieniany z wyswietlanym i wysylany na GPU w tym watku
+    if (m_applyWorker.takeFinished()) {
+        completeBackgroundTask();
+    }
+    
+    if (m_aligning && m_alignProgress != m_shownAlignProgress) {
+        m_shownAlignProgress = m_alignProgress;
+        m_gui->setStatusMessage("Wyrownywanie maski: " + std::to_string(m_shownAlignProgress) + "%");
+        requestRedraw();
+    }
+    
+    const bool idle = !isInteracting() && !m_applyWorker.isBusy();
+    
+    // Transformacja w pelnej jakosci dopiero, gdy uzytkownik przestanie ja zmieniac
+    if (m_maskTransformPending && idle) {
+        commitMaskTransform();
+    }
+    
+    if (m_processor->getSourceGeneration() != m_sourceTilesGeneration) {
+        m_sourceTiles.setImage(m_processor->getSourceImage().getPixelsPtr(), m_processor->getSourceSize());
+        m_sourceTiles.invalidateAll();
+        m_sourceTilesGeneration = m_processor->getSourceGeneration();
+        resetZoom();
+    }
+    
+    // Koniec interakcji albo przerwa po zmianie parametru - wynik w pelnej rozdzielczosci
+    // liczony w tle, podglad z proxy zostaje do jego zakonczenia
+    if (idle && (m_fullApplyPending ||
+                 (m_liveApplyPending && m_liveApplyClock.getElapsedTime() >= sf::milliseconds(150)))) {
+        startBackgroundApply();
+    }
+    
+    // Wszystkie zastosowania w trakcie jednej interakcji (np. przeciagania) to jeden krok cofania
+    if (!isAnimating()) {
+        m_processor->closeHistoryStep();
+    }
+    
     updateSprites();
 }
 
 void Application::render() {
+    TraceScope trace("render", "frame");
+    ProfileScope scope(ProfileStage::Render);
     m_window.clear(sf::Color(60, 60, 65));
     
-    sf::FloatRect previewArea = m_gui->getPreviewArea();
-    sf::RectangleShape previewBg(sf::Vector2f(previewArea.size.x, previewArea.size.y));
-    previewBg.setPosition(sf::Vector2f(previewArea.position.x, previewArea.position.y));
-    previewBg.setFillColor(sf::Color(50, 50, 55));
-    m_window.draw(previewBg);
+    m_window.draw(m_previewBackground);
+    Profiler::countDrawCall();
     
     switch (m_viewMode) {
         case ViewMode::Source:
-            if (m_processor->hasSourceImage() && m_sourceSprite.has_value()) {
-                m_window.draw(*m_sourceSprite);
-            }
+            drawSourcePreview();
             break;
             
         case ViewMode::Mask:
             if (m_processor->hasMask() && m_maskSprite.has_value()) {
                 m_window.draw(*m_maskSprite);
+                Profiler::countDrawCall();
             }
             break;
             
         case ViewMode::Result:
-            if (m_processor->hasResult() && m_resultSprite.has_value()) {
+            if (!getDisplayedResult().hasResult()) {
+                drawSourcePreview();
+            } else if (!m_showingProxy && useTiledView()) {
+                drawTiled(m_resultTiles);
+            } else if (m_resultSprite.has_value()) {
                 m_window.draw(*m_resultSprite);
-            } else if (m_processor->hasSourceImage() && m_sourceSprite.has_value()) {
-                m_window.draw(*m_sourceSprite);
+                Profiler::countDrawCall();
             }
             break;
             
         case ViewMode::SplitView:
-            if (m_processor->hasSourceImage() && m_sourceSprite.has_value()) {
-                sf::Sprite leftSprite = *m_sourceSprite;
-                fitSpriteToArea(leftSprite, sf::FloatRect(
-                    sf::Vector2f(previewArea.position.x, previewArea.position.y),
-                    sf::Vector2f(previewArea.size.x / 2 - 5, previewArea.size.y)
-                ));
-                m_window.draw(leftSprite);
-            }
-            
-            if (m_processor->hasResult() && m_resultSprite.has_value()) {
-                sf::Sprite rightSprite = *m_resultSprite;
-                fitSpriteToArea(rightSprite, sf::FloatRect(
-                    sf::Vector2f(previewArea.position.x + previewArea.size.x / 2 + 5, previewArea.position.y),
-                    sf::Vector2f(previewArea.size.x / 2 - 5, previewArea.size.y)
-                ));
-                m_window.draw(rightSprite);
-            }
+            m_splitView.draw(m_window);
             break;
     }
     
     m_gui->draw();
     
-    sf::Text helpText(m_font, "1-Zrodlo  2-Maska  3-Wynik  4-Podziel  Spacja-Zastosuj  R-Reset  Ctrl+S-Zapisz", 11);
-    helpText.setFillColor(sf::Color(150, 150, 150));
-    helpText.setPosition(sf::Vector2f(previewArea.position.x + 10, static_cast<float>(m_window.getSize().y) - 25));
-    m_window.draw(helpText);
-    
-    m_window.display();
+    if (m_helpText) {
+        m_window.draw(*m_helpText);
+    }
+    Profiler::countDrawCall();
 }
 
 void Application::loadSourceImage() {
     std::string path = openFileDialog("Wybierz obraz zrodlowy", "*.bmp;*.png;*.jpg");
     
     if (!path.empty()) {
+        finishBackgroundApply();
         if (m_processor->loadSourceImage(path)) {
+            m_showingProxy = false;
+            m_fullApplyPending = false;
             m_gui->setHasSource(true);
             m_gui->setSourceSize(m_processor->getSourceSize());
-            updateSprites();
+            m_gui->setResultStatistics(nullptr);
             setStatusMessage("Wczytano obraz: " + std::filesystem::path(path).filename().string());
             m_viewMode = ViewMode::Source;
         } else {
@@ -352,13 +684,17 @@ void Application::loadMaskImage() {
     std::string path = openFileDialog("Wybierz maske", "*.bmp;*.png;*.jpg");
     
     if (!path.empty()) {
+        finishBackgroundApply();
         if (m_processor->loadMask(path)) {
+            m_showingProxy = false;
+            m_fullApplyPending = false;
             m_gui->setHasMask(true);
             m_gui->setMaskSize(m_processor->getMaskSize());
             m_maskOffset = sf::Vector2i(0, 0);
-            updateSprites();
+            resetMaskTransform();
             setStatusMessage("Wczytano maske: " + std::filesystem::path(path).filename().string());
             m_viewMode = ViewMode::Mask;
+            scheduleLiveApply();
         } else {
             setStatusMessage("Blad wczytywania maski!");
         }
@@ -366,6 +702,11 @@ void Application::loadMaskImage() {
 }
 
 void Application::saveResult() {
+    finishBackgroundApply();
+    if (m_fullApplyPending) {
+        applyMask();
+    }
+    
     if (!m_processor->hasResult()) {
         setStatusMessage("Brak wyniku do zapisania!");
         return;
@@ -392,24 +733,256 @@ void Application::applyMask() {
         return;
     }
     
-    m_processor->applyMask(m_currentBlendMode, m_transparentColor, m_useAlpha);
-    m_gui->setHasResult(true);
-    updateSprites();
+    finishBackgroundApply();
+    commitMaskTransform();
+    m_processor->setMaskOffset(m_maskOffset.x, m_maskOffset.y);
+    m_processor->applyMask(m_currentBlendMode, m_transparentColor, m_useAlpha, m_tolerance, m_opacity);
+    m_liveApplyPending = false;
+    showResult();
     m_viewMode = ViewMode::Result;
+}
+
+void Application::scheduleLiveApply() {
+    if (!m_liveApply || !m_processor->hasSourceImage() || !m_processor->hasMask()) {
+        return;
+    }
+    
+    // Kolejne zmiany w krotkim odstepie daja jedno przeliczenie
+    m_liveApplyPending = true;
+    m_liveApplyClock.restart();
+}
+
+void Application::startBackgroundApply() {
+    m_liveApplyPending = false;
+    m_fullApplyPending = false;
+    if (!m_processor->hasSourceImage() || !m_processor->hasMask()) {
+        return;
+    }
+    
+    // Zmiany stanu procesora tylko w tym watku, przed zleceniem; pokrycie klucza i obszar
+    // przeliczenia sa brane z pamieci podrecznej procesora jak przy zwyklym zastosowaniu
+    commitMaskTransform();
+    m_processor->setMaskOffset(m_maskOffset.x, m_maskOffset.y);
+    
+    const BlendModeType mode = m_currentBlendMode;
+    const sf::Color key = m_transparentColor;
+    const bool useAlpha = m_useAlpha;
+    const int tolerance = m_tolerance;
+    const std::uint8_t opacity = m_opacity;
+    m_applyWorker.submit([this, mode, key, useAlpha, tolerance, opacity]() {
+        m_processor->computeMask(mode, key, useAlpha, tolerance, opacity);
+    });
+}
+
+void Application::finishBackgroundApply() {
+    m_applyWorker.wait();
+    if (m_applyWorker.takeFinished()) {
+        completeBackgroundTask();
+    }
+}
+
+void Application::completeBackgroundTask() {
+    if (!m_aligning) {
+        m_processor->publishResult();
+        showResult();
+        return;
+    }
+    
+    m_aligning = false;
+    if (!m_alignFound) {
+        setStatusMessage("Nie znaleziono polozenia maski");
+        return;
+    }
+    
+    // Wynik przeliczany w tle jak po przeciagnieciu maski
+    m_maskOffset = m_processor->getMaskOffset();
+    setStatusMessage("Maska wyrownana: " + std::to_string(m_maskOffset.x) + "," + std::to_string(m_maskOffset.y));
+    scheduleLiveApply();
+    if (m_processor->hasResult() || m_showingProxy) {
+        m_fullApplyPending = true;
+    }
+    requestRedraw();
+}
+
+void Application::showResult() {
+    if (!m_processor->hasResult()) {
+        return;
+    }
+    
+    m_resultTiles.setImage(m_processor->getResultPixels(), m_processor->getSourceSize());
+    m_resultTiles.invalidate(m_processor->getLastApplyRegion());
+    m_showingProxy = false;
+    m_fullApplyPending = false;
+    m_gui->setHasResult(true);
+    m_gui->setResultStatistics(m_processor->getStatistics());
+    if (m_viewMode != ViewMode::SplitView) {
+        m_viewMode = ViewMode::Result;
+    }
     setStatusMessage("Zastosowano maske w trybie: " + BlendMode::getModeName(m_currentBlendMode));
+    requestRedraw();
+}
+
+void Application::stepHistory(bool forward) {
+    // Niedokonczony podglad z proxy najpierw staje sie pelnym wynikiem i krokiem historii
+    finishBackgroundApply();
+    if (m_fullApplyPending) {
+        applyMask();
+    }
+    m_processor->closeHistoryStep();
+    
+    if (!(forward ? m_processor->redo() : m_processor->undo())) {
+        setStatusMessage(forward ? "Brak zmian do ponowienia" : "Brak zmian do cofniecia");
+        return;
+    }
+    
+    m_resultTiles.setImage(m_processor->getResultPixels(), m_processor->getSourceSize());
+    m_resultTiles.invalidate(m_processor->getLastApplyRegion());
+    m_showingProxy = false;
+    m_gui->setHasResult(true);
+    m_gui->setResultStatistics(m_processor->getStatistics());
+    if (m_viewMode != ViewMode::SplitView) {
+        m_viewMode = ViewMode::Result;
+    }
+    setStatusMessage(std::string(forward ? "Ponowiono" : "Cofnieto") + " (historia: " +
+                     std::to_string((m_processor->getHistoryBytes() + (1 << 19)) >> 20) + " MB)");
+}
+
+void Application::applyPreview() {
+    // Proxy jest dopasowane do calego podgladu - przy powiekszeniu liczony jest pelny wynik
+    if (m_zoomed) {
+        applyMask();
+        return;
+    }
+    
+    if (!m_previewProxy->update(*m_processor, m_gui->getPreviewArea().size)) {
+        applyMask();
+        return;
+    }
+    
+    m_previewProxy->applyMask(m_maskOffset, m_currentBlendMode, m_transparentColor, m_useAlpha,
+                                  m_tolerance, m_opacity);
+    m_showingProxy = true;
+    m_fullApplyPending = true;
+    if (m_viewMode != ViewMode::SplitView) {
+        m_viewMode = ViewMode::Result;
+    }
+}
+
+void Application::transformMask(const MaskTransform& transform, const std::optional<sf::Vector2i>& offset) {
+    if (!m_processor->hasMask()) {
+        return;
+    }
+    
+    // Bez podanego przesuniecia srodek maski zostaje w miejscu, gdy zmienia sie jej rozmiar
+    if (offset) {
+        m_maskOffset = *offset;
+    } else {
+        sf::Vector2u originalSize = m_processor->getOriginalMaskImage().getSize();
+        sf::Vector2i oldSize(ImageResampler::transformedSize(originalSize, m_maskTransform));
+        sf::Vector2i newSize(ImageResampler::transformedSize(originalSize, transform));
+        m_maskOffset += (newSize - oldSize) / 2;
+    }
+    
+    m_maskTransform = transform;
+    m_maskTransformPending = true;
+    m_maskTransformClock.restart();
+    m_previewProxy->setMaskTransform(transform);
+    scheduleLiveApply();
+    setStatusMessage("Maska: skala " + std::to_string(static_cast<int>(std::lround(transform.scale * 100))) +
+                     "%, obrot " + std::to_string(static_cast<int>(std::lround(transform.rotation))));
+    
+    if (m_processor->hasSourceImage() && (m_processor->hasResult() || m_showingProxy)) {
+        applyPreview();
+    }
+}
+
+void Application::fitMaskToSource() {
+    if (!m_processor->hasMask() || !m_processor->hasSourceImage()) {
+        setStatusMessage("Wczytaj obraz i maske!");
+        return;
+    }
+    
+    sf::Vector2u maskSize = m_processor->getOriginalMaskImage().getSize();
+    sf::Vector2u sourceSize = m_processor->getSourceSize();
+    MaskTransform transform = m_maskTransform;
+    transform.scale = std::min(static_cast<float>(sourceSize.x) / maskSize.x,
+                               static_cast<float>(sourceSize.y) / maskSize.y);
+    transform.rotation = 0.0f;
+    
+    // Maska wysrodkowana na obrazie
+    sf::Vector2i fittedSize(ImageResampler::transformedSize(maskSize, transform));
+    transformMask(transform, (fittedSize - sf::Vector2i(sourceSize)) / 2);
+    setStatusMessage("Maska dopasowana do obrazu");
+}
+
+void Application::alignMask() {
+    if (!m_processor->hasMask() || !m_processor->hasSourceImage()) {
+        setStatusMessage("Wczytaj obraz i maske!");
+        return;
+    }
+    
+    if (m_aligning) {
+        return;
+    }
+    
+    // Szukane jest polozenie maski po transformacji; zastepuje ono przeciaganie. Na duzym
+    // obrazie z mala maska trwa to sekundy, wiec liczy watek w tle, a okno pokazuje postep
+    commitMaskTransform();
+    m_aligning = true;
+    m_alignProgress = 0;
+    m_shownAlignProgress = -1;
+    const sf::Color key = m_transparentColor;
+    const int tolerance = m_tolerance;
+    m_applyWorker.submit([this, key, tolerance]() {
+        m_alignFound = m_processor->alignMask(key, tolerance, &m_alignProgress);
+    });
+}
+
+void Application::commitMaskTransform() {
+    finishBackgroundApply();
+    m_maskTransformPending = false;
+    if (m_processor->setMaskTransform(m_maskTransform, m_transparentColor)) {
+        m_gui->setMaskSize(m_processor->getMaskSize());
+    }
+}
+
+void Application::resetMaskTransform() {
+    m_maskTransform = MaskTransform();
+    m_maskTransformPending = false;
+    m_previewProxy->setMaskTransform(m_maskTransform);
+}
+
+const ImageProcessor& Application::getDisplayedResult() const {
+    return m_showingProxy ? m_previewProxy->getProcessor() : *m_processor;
+}
+
+void Application::saveTrace() {
+    auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string path = "slad-" + std::to_string(timestamp) + ".json";
+    
+    if (Tracer::dumpChromeTrace(path)) {
+        setStatusMessage("Zapisano slad: " + path);
+    } else {
+        setStatusMessage("Blad zapisywania sladu!");
+    }
 }
 
 void Application::selectMaskFromLibrary(size_t index) {
     std::string path = m_maskLibrary->getMaskPath(index);
     
     if (!path.empty()) {
+        finishBackgroundApply();
         if (m_processor->loadMask(path)) {
+            m_showingProxy = false;
+            m_fullApplyPending = false;
             m_gui->setHasMask(true);
             m_gui->setMaskSize(m_processor->getMaskSize());
             m_maskOffset = sf::Vector2i(0, 0);
-            updateSprites();
+            resetMaskTransform();
             setStatusMessage("Wybrano maske: " + m_maskLibrary->getMask(index).name);
             m_viewMode = ViewMode::Mask;
+            scheduleLiveApply();
         }
     }
 }
@@ -474,20 +1047,75 @@ std::string Application::saveFileDialog(const std::string& title, const std::str
 
 void Application::updateSprites() {
     sf::FloatRect previewArea = m_gui->getPreviewArea();
+    std::uint64_t sourceGeneration = m_processor->getSourceGeneration();
+    std::uint64_t maskGeneration = m_processor->getMaskGeneration();
+    const ImageProcessor& resultProcessor = getDisplayedResult();
+    bool tiled = (m_viewMode == ViewMode::Source || m_viewMode == ViewMode::Result) && useTiledView();
+    bool sourceShown = m_viewMode == ViewMode::Source ||
+                       (m_viewMode == ViewMode::Result && !resultProcessor.hasResult());
+    bool resultShown = m_viewMode == ViewMode::Result;
+    
+    // Tekstury GPU tylko dla aktualnego widoku - pozostale zwalniane w ramach budzetu
+    m_processor->setVisibleTextures(sourceShown && !tiled,
+                                    m_viewMode == ViewMode::Mask,
+                                    resultShown && !tiled && !m_showingProxy);
+    std::uint64_t resultGeneration = resultProcessor.getResultGeneration();
     
-    if (m_processor->hasSourceImage()) {
+    // Podzielony widok ma wlasne przeskalowane tekstury; aktualizacja tylko po zmianach
+    if (m_viewMode == ViewMode::SplitView) {
+        m_splitView.update(*m_processor, resultProcessor, previewArea);
+    }
+    
+    // Sprite'y zaleza tylko od rozmiaru tekstur, obszaru podgladu i trybu widoku
+    if (m_sceneState.valid &&
+        m_sceneState.sourceGeneration == sourceGeneration &&
+        m_sceneState.maskGeneration == maskGeneration &&
+        m_sceneState.resultGeneration == resultGeneration &&
+        m_sceneState.showingProxy == m_showingProxy &&
+        m_sceneState.previewArea == previewArea &&
+        m_sceneState.viewMode == m_viewMode &&
+        m_sceneState.tiled == tiled) {
+        return;
+    }
+    
+    if (sourceGeneration > 0 && m_processor->getSourceTexture().getSize().x > 0) {
         m_sourceSprite.emplace(m_processor->getSourceTexture());
         fitSpriteToArea(*m_sourceSprite, previewArea);
+    } else {
+        m_sourceSprite.reset();
     }
     
-    if (m_processor->hasMask()) {
+    if (maskGeneration > 0 && m_processor->getMaskTexture().getSize().x > 0) {
         m_maskSprite.emplace(m_processor->getMaskTexture());
         fitSpriteToArea(*m_maskSprite, previewArea);
+    } else {
+        m_maskSprite.reset();
     }
     
-    if (m_processor->hasResult()) {
-        m_resultSprite.emplace(m_processor->getResultTexture());
+    if (resultGeneration > 0 && resultProcessor.getResultTexture().getSize().x > 0) {
+        m_resultSprite.emplace(resultProcessor.getResultTexture());
         fitSpriteToArea(*m_resultSprite, previewArea);
+    } else {
+        m_resultSprite.reset();
+    }
+    
+    m_sceneState.sourceGeneration = sourceGeneration;
+    m_sceneState.maskGeneration = maskGeneration;
+    m_sceneState.resultGeneration = resultGeneration;
+    m_sceneState.showingProxy = m_showingProxy;
+    m_sceneState.previewArea = previewArea;
+    m_sceneState.viewMode = m_viewMode;
+    m_sceneState.tiled = tiled;
+    m_sceneState.valid = true;
+}
+
+void Application::updatePreviewLayout() {
+    sf::FloatRect previewArea = m_gui->getPreviewArea();
+    m_previewBackground.setSize(previewArea.size);
+    m_previewBackground.setPosition(previewArea.position);
+    
+    if (m_helpText) {
+        m_helpText->setPosition(sf::Vector2f(previewArea.position.x + 10, static_cast<float>(m_window.getSize().y) - 25));
     }
 }
 
@@ -0,0 +1,78 @@
+#include "BackgroundWorker.h"
+#include "Tracer.h"
+
+namespace MaskOverlay {
+
+BackgroundWorker::BackgroundWorker()
+    : m_busy(false)
+    , m_finished(false)
+    , m_stopping(false)
+{
+    m_thread = std::thread([this]() {
+        Tracer::setThreadName("Watek w tle");
+        workerLoop();
+    });
+}
+
+BackgroundWorker::~BackgroundWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_all();
+    m_thread.join();
+}
+
+bool BackgroundWorker::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Jedno zadanie naraz - wywolujacy zglasza kolejne po odebraniu wyniku
+        if (m_busy) {
+            return false;
+        }
+        m_task = std::move(task);
+        m_busy = true;
+        m_finished = false;
+    }
+    m_wakeCondition.notify_all();
+    return true;
+}
+
+bool BackgroundWorker::isBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_busy;
+}
+
+bool BackgroundWorker::takeFinished() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool finished = m_finished;
+    m_finished = false;
+    return finished;
+}
+
+void BackgroundWorker::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return !m_busy; });
+}
+
+void BackgroundWorker::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wakeCondition.wait(lock, [this]() { return m_stopping || m_busy; });
+        // Zlecone zadanie jest dokonczone nawet przy zamykaniu
+        if (!m_busy) {
+            return;
+        }
+        
+        std::function<void()> task = std::move(m_task);
+        lock.unlock();
+        task();
+        lock.lock();
+        
+        m_busy = false;
+        m_finished = true;
+        m_doneCondition.notify_all();
+    }
+}
+
+}
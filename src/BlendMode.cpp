@@ -1,6 +1,7 @@
 #include "BlendMode.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace MaskOverlay {
 
@@ -8,6 +9,11 @@ std::uint8_t BlendMode::clamp(int value) {
     return static_cast<std::uint8_t>(std::max(0, std::min(255, value)));
 }
 
+int BlendMode::clampTolerance(int tolerance) {
+    // Jedno miejsce obcinania - sciezka skalarna, wierszowa i precyzyjna klasyfikuja maske identycznie
+    return std::clamp(tolerance, 0, 255);
+}
+
 bool BlendMode::isTransparent(const sf::Color& color, 
                               const sf::Color& transparentColor,
                               int tolerance) {
@@ -15,6 +21,7 @@ bool BlendMode::isTransparent(const sf::Color& color,
         return true;
     }
     
+    tolerance = clampTolerance(tolerance);
     int dr = std::abs(static_cast<int>(color.r) - static_cast<int>(transparentColor.r));
     int dg = std::abs(static_cast<int>(color.g) - static_cast<int>(transparentColor.g));
     int db = std::abs(static_cast<int>(color.b) - static_cast<int>(transparentColor.b));
@@ -26,185 +33,614 @@ sf::Color BlendMode::blend(const sf::Color& source,
                           const sf::Color& mask,
                           BlendModeType mode,
                           const sf::Color& transparentColor,
-                          bool useAlpha) {
-    if (isTransparent(mask, transparentColor)) {
+                          bool useAlpha,
+                          int tolerance,
+                          std::uint8_t opacity,
+                          bool linear) {
+    if (isTransparent(mask, transparentColor, tolerance)) {
+        return source;
+    }
+    
+    std::uint8_t alpha = scaleCoverage(useAlpha ? mask.a : 255, opacity);
+    if (alpha == 0) {
         return source;
     }
     
-    sf::Color blended;
-    
-    switch (mode) {
-        case BlendModeType::Replace:
-            blended = blendReplace(source, mask);
-            break;
-        case BlendModeType::Add:
-            blended = blendAdd(source, mask);
-            break;
-        case BlendModeType::Multiply:
-            blended = blendMultiply(source, mask);
-            break;
-        case BlendModeType::Screen:
-            blended = blendScreen(source, mask);
-            break;
-        case BlendModeType::Overlay:
-            blended = blendOverlay(source, mask);
-            break;
-        case BlendModeType::Difference:
-            blended = blendDifference(source, mask);
-            break;
-        case BlendModeType::SoftLight:
-            blended = blendSoftLight(source, mask);
-            break;
-        case BlendModeType::HardLight:
-            blended = blendHardLight(source, mask);
-            break;
-        default:
-            blended = blendReplace(source, mask);
-    }
-    
-    if (useAlpha && mask.a < 255) {
-        return applyAlpha(source, blended, mask.a);
+    sf::Color blended = blendColor(source, mask, mode, linear);
+    
+    if (alpha < 255) {
+        return applyAlpha(source, blended, alpha, linear);
     }
     
     return blended;
 }
 
-sf::Color BlendMode::applyAlpha(const sf::Color& source, 
-                               const sf::Color& blended, 
-                               std::uint8_t alpha) {
-    float a = alpha / 255.0f;
+std::uint8_t BlendMode::scaleCoverage(std::uint8_t coverage, std::uint8_t opacity) {
+    return static_cast<std::uint8_t>((coverage * opacity + 127) / 255);
+}
+
+sf::Color BlendMode::blendColor(const sf::Color& source, const sf::Color& mask, BlendModeType mode, bool linear) {
+    const BlendModeInfo* info = findMode(mode);
+    int (*channel)(int, int, int) = info ? info->channel : &replaceChannel<int>;
+    if (linear) {
+        return sf::Color(
+            linearChannel(channel, source.r, mask.r),
+            linearChannel(channel, source.g, mask.g),
+            linearChannel(channel, source.b, mask.b),
+            255
+        );
+    }
     return sf::Color(
-        clamp(static_cast<int>(source.r * (1 - a) + blended.r * a)),
-        clamp(static_cast<int>(source.g * (1 - a) + blended.g * a)),
-        clamp(static_cast<int>(source.b * (1 - a) + blended.b * a)),
+        clamp(channel(source.r, mask.r, 255)),
+        clamp(channel(source.g, mask.g, 255)),
+        clamp(channel(source.b, mask.b, 255)),
         255
     );
 }
 
-sf::Color BlendMode::blendReplace(const sf::Color& source, const sf::Color& mask) {
-    return sf::Color(mask.r, mask.g, mask.b, 255);
+std::uint8_t BlendMode::linearChannel(int (*channel)(int, int, int), std::uint8_t base, std::uint8_t blend) {
+    const std::uint16_t* toLinear = getToLinearTable();
+    int value = channel(toLinear[base], toLinear[blend], LinearOne);
+    return getFromLinearTable()[std::clamp(value, 0, LinearOne)];
 }
 
-sf::Color BlendMode::blendAdd(const sf::Color& source, const sf::Color& mask) {
-    return sf::Color(
-        clamp(source.r + mask.r),
-        clamp(source.g + mask.g),
-        clamp(source.b + mask.b),
-        255
-    );
+const std::uint16_t* BlendMode::getToLinearTable() {
+    // sRGB -> swiatlo liniowe w 12 bitach; mniej niz 8 bitow gubiloby ciemne tony
+    static const std::vector<std::uint16_t> table = [] {
+        std::vector<std::uint16_t> built(256);
+        for (int i = 0; i < 256; ++i) {
+            double c = i / 255.0;
+            double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+            built[i] = static_cast<std::uint16_t>(std::lround(linear * LinearOne));
+        }
+        return built;
+    }();
+    return table.data();
 }
 
-sf::Color BlendMode::blendMultiply(const sf::Color& source, const sf::Color& mask) {
-    return sf::Color(
-        clamp((source.r * mask.r) / 255),
-        clamp((source.g * mask.g) / 255),
-        clamp((source.b * mask.b) / 255),
-        255
-    );
+const std::uint8_t* BlendMode::getFromLinearTable() {
+    static const std::vector<std::uint8_t> table = [] {
+        std::vector<std::uint8_t> built(LinearOne + 1);
+        for (int i = 0; i <= LinearOne; ++i) {
+            double linear = static_cast<double>(i) / LinearOne;
+            double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+            built[i] = clamp(static_cast<int>(std::lround(c * 255)));
+        }
+        return built;
+    }();
+    return table.data();
 }
 
-sf::Color BlendMode::blendScreen(const sf::Color& source, const sf::Color& mask) {
-    return sf::Color(
-        clamp(255 - ((255 - source.r) * (255 - mask.r)) / 255),
-        clamp(255 - ((255 - source.g) * (255 - mask.g)) / 255),
-        clamp(255 - ((255 - source.b) * (255 - mask.b)) / 255),
-        255
-    );
+void BlendMode::classifyRow(const std::uint8_t* mask,
+                            std::uint8_t* coverage,
+                            std::size_t count,
+                            const sf::Color& transparentColor,
+                            int tolerance,
+                            bool useAlpha) {
+    const int keyR = transparentColor.r;
+    const int keyG = transparentColor.g;
+    const int keyB = transparentColor.b;
+    const int limit = clampTolerance(tolerance);
+    const std::uint8_t opaque = useAlpha ? 0 : 255;
+    
+    // Bez rozgalezien - petla wektoryzuje sie przez kompilator
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint8_t* m = mask + i * 4;
+        const bool keyed = (std::abs(m[0] - keyR) <= limit) &
+                           (std::abs(m[1] - keyG) <= limit) &
+                           (std::abs(m[2] - keyB) <= limit);
+        const bool transparent = keyed | (m[3] == 0);
+        coverage[i] = transparent ? 0 : static_cast<std::uint8_t>(m[3] | opaque);
+    }
 }
 
-sf::Color BlendMode::blendOverlay(const sf::Color& source, const sf::Color& mask) {
-    auto overlayChannel = [](int base, int blend) -> int {
-        if (base < 128) {
-            return (2 * base * blend) / 255;
+void BlendMode::buildKeyRamp(int tolerance, int softness, std::uint8_t* ramp) {
+    const int limit = clampTolerance(tolerance);
+    const int width = std::max(0, softness);
+    
+    // Odleglosc od klucza (maksimum po kanalach) -> krycie; liniowe przejscie o szerokosci softness
+    for (int distance = 0; distance < 256; ++distance) {
+        if (distance <= limit) {
+            ramp[distance] = 0;
+        } else if (distance >= limit + width) {
+            ramp[distance] = 255;
         } else {
-            return 255 - (2 * (255 - base) * (255 - blend)) / 255;
+            ramp[distance] = static_cast<std::uint8_t>(((distance - limit) * 255 + width / 2) / width);
         }
+    }
+}
+
+const std::uint64_t* BlendMode::getReciprocalTable() {
+    // ceil(2^32 / a): (n * r) >> 32 == n / a dla n < 2^16 - dzielenie bez instrukcji dzielenia
+    static const std::vector<std::uint64_t> table = [] {
+        std::vector<std::uint64_t> built(256, 0);
+        for (std::uint64_t a = 1; a < 256; ++a) {
+            built[a] = ((std::uint64_t(1) << 32) + a - 1) / a;
+        }
+        return built;
+    }();
+    return table.data();
+}
+
+void BlendMode::softKeyRow(const std::uint8_t* mask,
+                           std::uint8_t* coverage,
+                           std::uint8_t* despilled,
+                           std::size_t count,
+                           const sf::Color& transparentColor,
+                           const std::uint8_t* ramp,
+                           bool useAlpha) {
+    const int keyR = transparentColor.r;
+    const int keyG = transparentColor.g;
+    const int keyB = transparentColor.b;
+    const int opaque = useAlpha ? 0 : 255;
+    
+    // Odleglosc od klucza - maksimum po kanalach
+    auto distance = [&](const std::uint8_t* m) {
+        return std::max(std::max(std::abs(m[0] - keyR), std::abs(m[1] - keyG)), std::abs(m[2] - keyB));
     };
     
-    return sf::Color(
-        clamp(overlayChannel(source.r, mask.r)),
-        clamp(overlayChannel(source.g, mask.g)),
-        clamp(overlayChannel(source.b, mask.b)),
-        255
-    );
+    // Bez odjecia klucza osobna petla - bez rozgalezien w srodku
+    if (!despilled) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::uint8_t* m = mask + i * 4;
+            const int keyAlpha = ramp[distance(m)];
+            const int maskAlpha = m[3] == 0 ? 0 : (m[3] | opaque);
+            coverage[i] = static_cast<std::uint8_t>((keyAlpha * maskAlpha + 127) / 255);
+        }
+        return;
+    }
+    
+    // Piksel krawedzi traktowany jako mieszanka koloru maski z kluczem - udzial klucza jest odejmowany;
+    // dzielenie przez krycie klucza jako mnozenie przez odwrotnosc z tablicy
+    const std::uint64_t* reciprocal = getReciprocalTable();
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint8_t* m = mask + i * 4;
+        std::uint8_t* d = despilled + i * 4;
+        const int keyAlpha = ramp[distance(m)];
+        const int maskAlpha = m[3] == 0 ? 0 : (m[3] | opaque);
+        coverage[i] = static_cast<std::uint8_t>((keyAlpha * maskAlpha + 127) / 255);
+        
+        const bool unmix = keyAlpha != 0 && keyAlpha != 255;
+        const std::uint64_t inverse = reciprocal[keyAlpha];
+        const int keyShare = 255 - keyAlpha;
+        const int half = keyAlpha / 2;
+        auto channel = [&](int value, int key) {
+            const int numerator = std::max(0, value * 255 - keyShare * key + half);
+            const int unmixed = static_cast<int>((static_cast<std::uint64_t>(numerator) * inverse) >> 32);
+            return static_cast<std::uint8_t>(unmix ? std::min(unmixed, 255) : value);
+        };
+        d[0] = channel(m[0], keyR);
+        d[1] = channel(m[1], keyG);
+        d[2] = channel(m[2], keyB);
+        d[3] = m[3];
+    }
 }
 
-sf::Color BlendMode::blendDifference(const sf::Color& source, const sf::Color& mask) {
-    return sf::Color(
-        clamp(std::abs(source.r - mask.r)),
-        clamp(std::abs(source.g - mask.g)),
-        clamp(std::abs(source.b - mask.b)),
-        255
-    );
+void BlendMode::blendRow(const std::uint8_t* source,
+                         const std::uint8_t* mask,
+                         const std::uint8_t* coverage,
+                         std::uint8_t* result,
+                         std::size_t count,
+                         BlendModeType mode,
+                         std::uint8_t opacity,
+                         bool linear,
+                         BlendStatistics* statistics) {
+    // Krycie 0 - wiersz zrodla bez zmian
+    if (opacity == 0) {
+        std::memcpy(result, source, count * 4);
+        return;
+    }
+    
+    // Krycie warstwy wchodzi w pokrycie przez tablice 256 wartosci; przy 255 pokrycie jest uzywane wprost
+    std::uint8_t scaled[256];
+    const std::uint8_t* scale = nullptr;
+    if (opacity < 255) {
+        for (int c = 0; c < 256; ++c) {
+            scaled[c] = scaleCoverage(static_cast<std::uint8_t>(c), opacity);
+        }
+        scale = scaled;
+    }
+    
+    // Tablica [zrodlo][maska] z funkcji kanalu trybu - ta sama sciezka dla kazdego trybu z rejestru;
+    // w trybie liniowym tablica zawiera juz konwersje sRGB -> liniowe -> sRGB
+    const std::uint8_t* table = getLookupTable(mode, linear);
+    
+    // Statystyki w osobnej instancji petli - bez nich petla nie ma dodatkowych rozgalezien
+    if (statistics) {
+        blendPixels<true>(source, mask, coverage, result, count, table, scale, linear,
+                          getClipTable(mode, linear), statistics);
+    } else {
+        blendPixels<false>(source, mask, coverage, result, count, table, scale, linear, nullptr, nullptr);
+    }
 }
 
-sf::Color BlendMode::blendSoftLight(const sf::Color& source, const sf::Color& mask) {
-    auto softLightChannel = [](int base, int blend) -> int {
-        float b = base / 255.0f;
-        float l = blend / 255.0f;
-        float result;
+template <bool Statistics>
+void BlendMode::blendPixels(const std::uint8_t* source, const std::uint8_t* mask, const std::uint8_t* coverage,
+                            std::uint8_t* result, std::size_t count, const std::uint8_t* table,
+                            const std::uint8_t* scale, bool linear, const std::uint8_t* clip,
+                            BlendStatistics* statistics) {
+    long long touched = 0;
+    long long clipped = 0;
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint8_t* s = source + i * 4;
+        std::uint8_t* r = result + i * 4;
+        const std::uint8_t c = scale ? scale[coverage[i]] : coverage[i];
         
-        if (l < 0.5f) {
-            result = b - (1 - 2 * l) * b * (1 - b);
-        } else {
-            float d = (b <= 0.25f) ? ((16 * b - 12) * b + 4) * b : std::sqrt(b);
-            result = b + (2 * l - 1) * (d - b);
+        if (c == 0) {
+            r[0] = s[0];
+            r[1] = s[1];
+            r[2] = s[2];
+            r[3] = s[3];
+            continue;
         }
         
-        return static_cast<int>(result * 255);
-    };
+        const std::uint8_t* m = mask + i * 4;
+        const int r0 = s[0] << 8 | m[0];
+        const int g0 = s[1] << 8 | m[1];
+        const int b0 = s[2] << 8 | m[2];
+        const sf::Color base(s[0], s[1], s[2], s[3]);
+        sf::Color blended(table[r0], table[g0], table[b0], 255);
+        if (c < 255) {
+            blended = applyAlpha(base, blended, c, linear);
+        }
+        
+        r[0] = blended.r;
+        r[1] = blended.g;
+        r[2] = blended.b;
+        r[3] = blended.a;
+        
+        // Histogram zbiera roznice wynik - zrodlo tylko dla pikseli, ktorych dotknela maska;
+        // reszte wyniku stanowi zrodlo, dodawane przez wywolujacego
+        if constexpr (Statistics) {
+            ++touched;
+            clipped += clip[r0] | clip[g0] | clip[b0];
+            auto& histogram = statistics->histogram;
+            ++histogram[0][blended.r];
+            ++histogram[1][blended.g];
+            ++histogram[2][blended.b];
+            ++histogram[3][blended.a];
+            --histogram[0][base.r];
+            --histogram[1][base.g];
+            --histogram[2][base.b];
+            --histogram[3][base.a];
+        }
+    }
     
-    return sf::Color(
-        clamp(softLightChannel(source.r, mask.r)),
-        clamp(softLightChannel(source.g, mask.g)),
-        clamp(softLightChannel(source.b, mask.b)),
-        255
-    );
+    if constexpr (Statistics) {
+        statistics->touched += touched;
+        statistics->clipped += clipped;
+    }
 }
 
-sf::Color BlendMode::blendHardLight(const sf::Color& source, const sf::Color& mask) {
+void BlendMode::classifyRowFloat(const float* mask,
+                                 float* coverage,
+                                 std::size_t count,
+                                 const sf::Color& transparentColor,
+                                 int tolerance,
+                                 bool useAlpha) {
+    const float keyR = transparentColor.r / 255.0f;
+    const float keyG = transparentColor.g / 255.0f;
+    const float keyB = transparentColor.b / 255.0f;
+    // Pol poziomu zapasu - wartosci z obrazow 8-bitowych klasyfikowane jak w classifyRow()
+    const float limit = (clampTolerance(tolerance) + 0.5f) / 255.0f;
+    
+    for (std::size_t i = 0; i < count; ++i) {
+        const float* m = mask + i * 4;
+        const bool keyed = (std::abs(m[0] - keyR) <= limit) &
+                           (std::abs(m[1] - keyG) <= limit) &
+                           (std::abs(m[2] - keyB) <= limit);
+        const bool transparent = keyed | (m[3] <= 0.0f);
+        coverage[i] = transparent ? 0.0f : (useAlpha ? std::min(m[3], 1.0f) : 1.0f);
+    }
+}
 
-    auto hardLightChannel = [](int base, int blend) -> int {
-        if (blend < 128) {
-            return (2 * base * blend) / 255;
-        } else {
-            return 255 - (2 * (255 - base) * (255 - blend)) / 255;
+void BlendMode::blendRowFloat(const float* source,
+                              const float* mask,
+                              const float* coverage,
+                              float* result,
+                              std::size_t count,
+                              BlendModeType mode,
+                              std::uint8_t opacity) {
+    const BlendModeInfo* info = findMode(mode);
+    if (!info || opacity == 0) {
+        std::copy(source, source + count * 4, result);
+        return;
+    }
+    
+    // Najpierw tryb na calym wierszu (wszystkie kanaly jako jedna tablica - petla bez
+    // rozgalezien na piksel), potem mieszanie z pokryciem
+    info->channelRow(source, mask, result, count * 4);
+    
+    // Pokrycie ponizej pol poziomu 8-bitowego liczy sie jako zero - kryja te same piksele co w blendRow()
+    const float scale = opacity / 255.0f;
+    const float minCoverage = 0.5f / 255.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float* s = source + i * 4;
+        const float* m = mask + i * 4;
+        float* r = result + i * 4;
+        const float scaled = coverage[i] * scale;
+        const float c = scaled >= minCoverage ? scaled : 0.0f;
+        // Wynik trybu obciety do bieli jak w 8 bitach; wartosci HDR (powyzej 1) z wejsc zostaja
+        for (int k = 0; k < 3; ++k) {
+            const float limit = std::max({1.0f, s[k], m[k]});
+            r[k] = s[k] + (std::clamp(r[k], 0.0f, limit) - s[k]) * c;
         }
-    };
+        r[3] = c > 0.0f ? 1.0f : s[3];
+    }
+}
+
+template <float (*Channel)(float, float, float)>
+void BlendMode::channelRow(const float* base, const float* blend, float* result, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        result[i] = Channel(base[i], blend[i], 1.0f);
+    }
+}
+
+sf::Color BlendMode::applyAlpha(const sf::Color& source, 
+                               const sf::Color& blended, 
+                               std::uint8_t alpha,
+                               bool linear) {
+    if (linear) {
+        // Mieszanie w swietle liniowym - bez ciemnych obwodek na polprzezroczystych krawedziach
+        const std::uint16_t* toLinear = getToLinearTable();
+        const std::uint8_t* fromLinear = getFromLinearTable();
+        auto mix = [&](std::uint8_t s, std::uint8_t b) {
+            return fromLinear[(toLinear[s] * (255 - alpha) + toLinear[b] * alpha + 127) / 255];
+        };
+        return sf::Color(mix(source.r, blended.r), mix(source.g, blended.g), mix(source.b, blended.b), 255);
+    }
     
+    float a = alpha / 255.0f;
     return sf::Color(
-        clamp(hardLightChannel(source.r, mask.r)),
-        clamp(hardLightChannel(source.g, mask.g)),
-        clamp(hardLightChannel(source.b, mask.b)),
+        clamp(static_cast<int>(source.r * (1 - a) + blended.r * a)),
+        clamp(static_cast<int>(source.g * (1 - a) + blended.g * a)),
+        clamp(static_cast<int>(source.b * (1 - a) + blended.b * a)),
         255
     );
 }
 
-std::string BlendMode::getModeName(BlendModeType mode) {
-    switch (mode) {
-        case BlendModeType::Replace:    return "Zamiana";
-        case BlendModeType::Add:        return "Sumowanie";
-        case BlendModeType::Multiply:   return "Mnozenie";
-        case BlendModeType::Screen:     return "Screen";
-        case BlendModeType::Overlay:    return "Nakladka";
-        case BlendModeType::Difference: return "Roznica";
-        case BlendModeType::SoftLight:  return "Miekkie swiatlo";
-        case BlendModeType::HardLight:  return "Twarde swiatlo";
-        default:                        return "Nieznany";
+// Funkcje kanalu dzialaja w skali 0..one: 255 dla wartosci 8-bitowych (z gamma),
+// LinearOne dla wartosci liniowych z tablicy getToLinearTable(), 1.0f dla sciezki
+// zmiennoprzecinkowej (16 bitow i float)
+template <typename T>
+T BlendMode::replaceChannel(T /*base*/, T blend, T /*one*/) {
+    return blend;
+}
+
+template <typename T>
+T BlendMode::addChannel(T base, T blend, T /*one*/) {
+    return base + blend;
+}
+
+template <typename T>
+T BlendMode::multiplyChannel(T base, T blend, T one) {
+    return (base * blend) / one;
+}
+
+template <typename T>
+T BlendMode::screenChannel(T base, T blend, T one) {
+    return one - ((one - base) * (one - blend)) / one;
+}
+
+template <typename T>
+T BlendMode::overlayChannel(T base, T blend, T one) {
+    if (2 * base <= one) {
+        return (2 * base * blend) / one;
+    } else {
+        return one - (2 * (one - base) * (one - blend)) / one;
     }
 }
 
-std::vector<BlendModeType> BlendMode::getAllModes() {
-    return {
-        BlendModeType::Replace,
-        BlendModeType::Add,
-        BlendModeType::Multiply,
-        BlendModeType::Screen,
-        BlendModeType::Overlay,
-        BlendModeType::Difference,
-        BlendModeType::SoftLight,
-        BlendModeType::HardLight
+template <typename T>
+T BlendMode::differenceChannel(T base, T blend, T /*one*/) {
+    return std::abs(base - blend);
+}
+
+template <typename T>
+T BlendMode::softLightChannel(T base, T blend, T one) {
+    float b = static_cast<float>(base) / static_cast<float>(one);
+    float l = static_cast<float>(blend) / static_cast<float>(one);
+    float result;
+    
+    if (l < 0.5f) {
+        result = b - (1 - 2 * l) * b * (1 - b);
+    } else {
+        float d = (b <= 0.25f) ? ((16 * b - 12) * b + 4) * b : std::sqrt(b);
+        result = b + (2 * l - 1) * (d - b);
+    }
+    
+    return static_cast<T>(result * static_cast<float>(one));
+}
+
+template <typename T>
+T BlendMode::hardLightChannel(T base, T blend, T one) {
+    if (2 * blend <= one) {
+        return (2 * base * blend) / one;
+    } else {
+        return one - (2 * (one - base) * (one - blend)) / one;
+    }
+}
+
+template <typename T>
+T BlendMode::darkenChannel(T base, T blend, T /*one*/) {
+    return std::min(base, blend);
+}
+
+template <typename T>
+T BlendMode::lightenChannel(T base, T blend, T /*one*/) {
+    return std::max(base, blend);
+}
+
+template <typename T>
+T BlendMode::colorDodgeChannel(T base, T blend, T one) {
+    if (base <= 0) {
+        return 0;
+    }
+    if (blend >= one) {
+        return one;
+    }
+    return (base * one) / (one - blend);
+}
+
+template <typename T>
+T BlendMode::colorBurnChannel(T base, T blend, T one) {
+    if (base >= one) {
+        return one;
+    }
+    if (blend <= 0) {
+        return 0;
+    }
+    return one - ((one - base) * one) / blend;
+}
+
+template <typename T>
+T BlendMode::linearBurnChannel(T base, T blend, T one) {
+    return base + blend - one;
+}
+
+template <typename T>
+T BlendMode::exclusionChannel(T base, T blend, T one) {
+    return base + blend - (2 * base * blend) / one;
+}
+
+template <typename T>
+T BlendMode::subtractChannel(T base, T blend, T /*one*/) {
+    return base - blend;
+}
+
+const std::vector<BlendModeInfo>& BlendMode::getRegistry() {
+    // Kolejnosc wyznacza numery trybow w CLI i przyciski w GUI - nowe tryby dopisywac na koncu
+    static const std::vector<BlendModeInfo> registry = {
+        {BlendModeType::Replace,    "Zamiana",          "Zamiana",  &replaceChannel<int>, &channelRow<&replaceChannel<float>>},
+        {BlendModeType::Add,        "Sumowanie",        "Suma",     &addChannel<int>, &channelRow<&addChannel<float>>},
+        {BlendModeType::Multiply,   "Mnozenie",         "Mnozenie", &multiplyChannel<int>, &channelRow<&multiplyChannel<float>>},
+        {BlendModeType::Screen,     "Screen",           "Screen",   &screenChannel<int>, &channelRow<&screenChannel<float>>},
+        {BlendModeType::Overlay,    "Nakladka",         "Nakladka", &overlayChannel<int>, &channelRow<&overlayChannel<float>>},
+        {BlendModeType::Difference, "Roznica",          "Roznica",  &differenceChannel<int>, &channelRow<&differenceChannel<float>>},
+        {BlendModeType::SoftLight,  "Miekkie swiatlo",  "Miekkie",  &softLightChannel<int>, &channelRow<&softLightChannel<float>>},
+        {BlendModeType::HardLight,  "Twarde swiatlo",   "Twarde",   &hardLightChannel<int>, &channelRow<&hardLightChannel<float>>},
+        {BlendModeType::Darken,     "Ciemniej",         "Ciemniej", &darkenChannel<int>, &channelRow<&darkenChannel<float>>},
+        {BlendModeType::Lighten,    "Jasniej",          "Jasniej",  &lightenChannel<int>, &channelRow<&lightenChannel<float>>},
+        {BlendModeType::ColorDodge, "Rozjasnianie",     "Rozjasn.", &colorDodgeChannel<int>, &channelRow<&colorDodgeChannel<float>>},
+        {BlendModeType::ColorBurn,  "Sciemnianie",      "Sciemn.",  &colorBurnChannel<int>, &channelRow<&colorBurnChannel<float>>},
+        {BlendModeType::LinearBurn, "Sciemnianie liniowe", "Sc. lin.", &linearBurnChannel<int>, &channelRow<&linearBurnChannel<float>>},
+        {BlendModeType::Exclusion,  "Wykluczenie",      "Wyklucz.", &exclusionChannel<int>, &channelRow<&exclusionChannel<float>>},
+        {BlendModeType::Subtract,   "Odejmowanie",      "Odejm.",   &subtractChannel<int>, &channelRow<&subtractChannel<float>>}
     };
+    return registry;
+}
+
+const BlendModeInfo* BlendMode::findMode(BlendModeType mode) {
+    for (const auto& info : getRegistry()) {
+        if (info.type == mode) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+const std::uint8_t* BlendMode::getLookupTable(BlendModeType mode, bool linear) {
+    // Tablice 256x256 dla wszystkich trybow budowane raz, przy pierwszym uzyciu;
+    // liniowe osobno, zeby nie budowac ich, gdy nie sa uzywane
+    static const std::vector<std::vector<std::uint8_t>> gammaTables = [] {
+        std::vector<std::vector<std::uint8_t>> built;
+        for (const auto& info : getRegistry()) {
+            std::vector<std::uint8_t> table(256 * 256);
+            for (int base = 0; base < 256; ++base) {
+                for (int blend = 0; blend < 256; ++blend) {
+                    table[base << 8 | blend] = clamp(info.channel(base, blend, 255));
+                }
+            }
+            built.push_back(std::move(table));
+        }
+        return built;
+    }();
+    
+    if (linear) {
+        static const std::vector<std::vector<std::uint8_t>> linearTables = [] {
+            std::vector<std::vector<std::uint8_t>> built;
+            for (const auto& info : getRegistry()) {
+                std::vector<std::uint8_t> table(256 * 256);
+                for (int base = 0; base < 256; ++base) {
+                    for (int blend = 0; blend < 256; ++blend) {
+                        table[base << 8 | blend] = linearChannel(info.channel,
+                            static_cast<std::uint8_t>(base), static_cast<std::uint8_t>(blend));
+                    }
+                }
+                built.push_back(std::move(table));
+            }
+            return built;
+        }();
+        return findTable(linearTables, mode);
+    }
+    return findTable(gammaTables, mode);
+}
+
+const std::uint8_t* BlendMode::getClipTable(BlendModeType mode, bool linear) {
+    // 1 tam, gdzie funkcja kanalu wychodzi poza zakres i clamp() obcina wynik trybu
+    static const std::vector<std::vector<std::uint8_t>> gammaTables = [] {
+        std::vector<std::vector<std::uint8_t>> built;
+        for (const auto& info : getRegistry()) {
+            std::vector<std::uint8_t> table(256 * 256);
+            for (int base = 0; base < 256; ++base) {
+                for (int blend = 0; blend < 256; ++blend) {
+                    const int value = info.channel(base, blend, 255);
+                    table[base << 8 | blend] = value < 0 || value > 255;
+                }
+            }
+            built.push_back(std::move(table));
+        }
+        return built;
+    }();
+    
+    if (linear) {
+        static const std::vector<std::vector<std::uint8_t>> linearTables = [] {
+            const std::uint16_t* toLinear = getToLinearTable();
+            std::vector<std::vector<std::uint8_t>> built;
+            for (const auto& info : getRegistry()) {
+                std::vector<std::uint8_t> table(256 * 256);
+                for (int base = 0; base < 256; ++base) {
+                    for (int blend = 0; blend < 256; ++blend) {
+                        const int value = info.channel(toLinear[base], toLinear[blend], LinearOne);
+                        table[base << 8 | blend] = value < 0 || value > LinearOne;
+                    }
+                }
+                built.push_back(std::move(table));
+            }
+            return built;
+        }();
+        return findTable(linearTables, mode);
+    }
+    return findTable(gammaTables, mode);
+}
+
+const std::uint8_t* BlendMode::findTable(const std::vector<std::vector<std::uint8_t>>& tables, BlendModeType mode) {
+    const auto& registry = getRegistry();
+    for (std::size_t i = 0; i < registry.size(); ++i) {
+        if (registry[i].type == mode) {
+            return tables[i].data();
+        }
+    }
+    return tables.front().data();
+}
+
+std::string BlendMode::getModeName(BlendModeType mode) {
+    const BlendModeInfo* info = findMode(mode);
+    return info ? info->name : "Nieznany";
+}
+
+std::string BlendMode::getModeLabel(BlendModeType mode) {
+    const BlendModeInfo* info = findMode(mode);
+    return info ? info->label : "?";
+}
+
+std::vector<BlendModeType> BlendMode::getAllModes() {
+    std::vector<BlendModeType> modes;
+    for (const auto& info : getRegistry()) {
+        modes.push_back(info.type);
+    }
+    return modes;
 }
 
 }
@@ -0,0 +1,62 @@
+#include "BlendStatistics.h"
+
+namespace MaskOverlay {
+
+void BlendStatistics::clear() {
+    *this = BlendStatistics();
+}
+
+void BlendStatistics::merge(const BlendStatistics& other) {
+    for (int channel = 0; channel < Channels; ++channel) {
+        for (int value = 0; value < 256; ++value) {
+            histogram[channel][value] += other.histogram[channel][value];
+        }
+    }
+    pixels += other.pixels;
+    touched += other.touched;
+    clipped += other.clipped;
+}
+
+int BlendStatistics::getMin(int channel) const {
+    for (int value = 0; value < 256; ++value) {
+        if (histogram[channel][value] > 0) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+int BlendStatistics::getMax(int channel) const {
+    for (int value = 255; value >= 0; --value) {
+        if (histogram[channel][value] > 0) {
+            return value;
+        }
+    }
+    return 0;
+}
+
+double BlendStatistics::getMean(int channel) const {
+    if (pixels == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (int value = 0; value < 256; ++value) {
+        sum += static_cast<double>(histogram[channel][value]) * value;
+    }
+    return sum / static_cast<double>(pixels);
+}
+
+double BlendStatistics::getMeanLuminance() const {
+    // Luminancja Rec. 601 na wartosciach sRGB - liniowa, wiec srednia wynika ze srednich kanalow
+    return 0.299 * getMean(0) + 0.587 * getMean(1) + 0.114 * getMean(2);
+}
+
+double BlendStatistics::getTouchedFraction() const {
+    return pixels > 0 ? static_cast<double>(touched) / static_cast<double>(pixels) : 0.0;
+}
+
+double BlendStatistics::getClippedFraction() const {
+    return pixels > 0 ? static_cast<double>(clipped) / static_cast<double>(pixels) : 0.0;
+}
+
+}
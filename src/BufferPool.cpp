@@ -0,0 +1,79 @@
+#include "BufferPool.h"
+#include <algorithm>
+
+namespace MaskOverlay {
+
+BufferPool::BufferPool(std::size_t maxPooledBytes)
+    : m_pooledBytes(0)
+    , m_maxPooledBytes(maxPooledBytes)
+{
+}
+
+std::unique_ptr<BufferPool::Buffer> BufferPool::acquire(std::size_t bytes) {
+    std::unique_ptr<Buffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Najmniejszy wolny bufor, ktory pomiesci zadany rozmiar bez realokacji
+        auto best = m_free.end();
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if ((*it)->capacity() >= bytes &&
+                (best == m_free.end() || (*it)->capacity() < (*best)->capacity())) {
+                best = it;
+            }
+        }
+
+        if (best != m_free.end()) {
+            buffer = std::move(*best);
+            m_free.erase(best);
+            m_pooledBytes -= buffer->capacity();
+        }
+    }
+
+    if (!buffer) {
+        buffer = std::make_unique<Buffer>();
+    }
+    buffer->resize(bytes);
+    return buffer;
+}
+
+void BufferPool::release(std::unique_ptr<Buffer> buffer) {
+    if (!buffer || buffer->capacity() == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pooledBytes + buffer->capacity() > m_maxPooledBytes) {
+        return;
+    }
+
+    m_pooledBytes += buffer->capacity();
+    m_free.push_back(std::move(buffer));
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.clear();
+    m_pooledBytes = 0;
+}
+
+std::size_t BufferPool::getPooledBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pooledBytes;
+}
+
+void BufferPool::setMaxPooledBytes(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxPooledBytes = bytes;
+    while (m_pooledBytes > m_maxPooledBytes && !m_free.empty()) {
+        m_pooledBytes -= m_free.back()->capacity();
+        m_free.pop_back();
+    }
+}
+
+BufferPool& BufferPool::getShared() {
+    static BufferPool pool;
+    return pool;
+}
+
+}
@@ -0,0 +1,402 @@
+#include "CommandLine.h"
+#include "ImageProcessor.h"
+#include "PreciseProcessor.h"
+#include "Tracer.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include <cmath>
+
+namespace MaskOverlay {
+
+namespace {
+
+const char* const Options[] = {
+    "--help", "--list-modes", "--source", "--mask", "--output", "--mode", "--key", "--tolerance",
+    "--opacity", "--soft", "--despill", "--feather", "--linear", "--no-alpha", "--offset", "--align",
+    "--scale", "--rotate", "--fit", "--wrap", "--filter", "--precision", "--threads", "--trace", "--stats"
+};
+
+}
+
+CommandLine::CommandLine(int argc, char* argv[])
+    : m_args(argv + 1, argv + argc)
+    , m_mode(BlendModeType::Replace)
+    , m_transparentColor(sf::Color::Magenta)
+    , m_useAlpha(true)
+    , m_maskOffset(0, 0)
+    , m_tolerance(BlendMode::DefaultTolerance)
+    , m_softness(0)
+    , m_despill(false)
+    , m_feather(0)
+    , m_opacity(255)
+    , m_fit(false)
+    , m_align(false)
+    , m_linear(false)
+    , m_wrap(MaskWrap::None)
+    , m_threads(0)
+{
+}
+
+bool CommandLine::isHeadless(int argc, char* argv[]) {
+    // Tryb wsadowy tylko od znanej opcji - plik z "Otworz za pomoca" albo -psn_* od systemu
+    // uruchamiaja interfejs graficzny
+    if (argc < 2) {
+        return false;
+    }
+    const std::string first = argv[1];
+    return std::find(std::begin(Options), std::end(Options), first) != std::end(Options);
+}
+
+int CommandLine::run() {
+    if (std::find(m_args.begin(), m_args.end(), "--help") != m_args.end()) {
+        printUsage();
+        return 0;
+    }
+    if (std::find(m_args.begin(), m_args.end(), "--list-modes") != m_args.end()) {
+        printModes();
+        return 0;
+    }
+    if (!parseArguments()) {
+        printUsage();
+        return 1;
+    }
+    
+    if (!m_tracePath.empty()) {
+        Tracer::setThreadName("Glowny");
+        Tracer::setEnabled(true);
+    }
+    
+    int exitCode = 0;
+    if (m_precision) {
+        exitCode = runPrecise();
+    } else {
+        ImageProcessor processor;
+        processor.setTexturesEnabled(false);
+        processor.setKeepSourceImage(false);
+        processor.setHistoryBudget(0);
+        processor.setThreadCount(m_threads);
+        processor.setSoftKey(m_softness, m_despill, m_feather);
+        processor.setLinearLight(m_linear);
+        processor.setMaskWrap(m_wrap);
+        processor.setCollectStatistics(!m_statisticsPath.empty());
+        
+        if (!processor.loadSourceImage(m_sourcePath) || !processor.loadMask(m_maskPath)) {
+            exitCode = 1;
+        } else {
+            // --fit dopasowuje maske do obrazu i ja wysrodkowuje; --offset przesuwa ja dalej
+            MaskTransform transform = m_maskTransform;
+            sf::Vector2i offset = m_maskOffset;
+            if (m_fit) {
+                sf::Vector2u maskSize = processor.getMaskSize();
+                sf::Vector2u sourceSize = processor.getSourceSize();
+                transform.scale = std::min(static_cast<float>(sourceSize.x) / maskSize.x,
+                                           static_cast<float>(sourceSize.y) / maskSize.y);
+                offset += (sf::Vector2i(ImageResampler::transformedSize(maskSize, transform)) - sf::Vector2i(sourceSize)) / 2;
+            }
+            processor.setMaskTransform(transform, m_transparentColor);
+            processor.setMaskOffset(offset.x, offset.y);
+            // --align wyznacza przesuniecie samo, zamiast --offset
+            if (m_align && !processor.alignMask(m_transparentColor, m_tolerance)) {
+                exitCode = 1;
+            } else {
+                processor.applyMask(m_mode, m_transparentColor, m_useAlpha, m_tolerance, m_opacity);
+                if (!processor.saveResult(m_outputPath)) {
+                    exitCode = 1;
+                }
+                const BlendStatistics* statistics = processor.getStatistics();
+                if (!m_statisticsPath.empty() && (!statistics || !saveStatistics(*statistics))) {
+                    exitCode = 1;
+                }
+            }
+        }
+    }
+    
+    if (!m_tracePath.empty() && !Tracer::dumpChromeTrace(m_tracePath)) {
+        exitCode = 1;
+    }
+    
+    return exitCode;
+}
+
+int CommandLine::runPrecise() {
+    PreciseProcessor processor(*m_precision);
+    processor.setThreadCount(m_threads);
+    
+    if (!processor.loadSourceImage(m_sourcePath) || !processor.loadMask(m_maskPath)) {
+        return 1;
+    }
+    
+    processor.setMaskOffset(m_maskOffset.x, m_maskOffset.y);
+    processor.applyMask(m_mode, m_transparentColor, m_useAlpha, m_tolerance, m_opacity);
+    return processor.saveResult(m_outputPath) ? 0 : 1;
+}
+
+bool CommandLine::parseArguments() {
+    for (size_t i = 0; i < m_args.size(); ++i) {
+        const std::string& arg = m_args[i];
+        
+        if (arg == "--no-alpha") {
+            m_useAlpha = false;
+            continue;
+        }
+        
+        if (arg == "--despill") {
+            m_despill = true;
+            continue;
+        }
+        
+        if (arg == "--fit") {
+            m_fit = true;
+            continue;
+        }
+        
+        if (arg == "--linear") {
+            m_linear = true;
+            continue;
+        }
+        
+        if (arg == "--align") {
+            m_align = true;
+            continue;
+        }
+        
+        if (i + 1 >= m_args.size()) {
+            std::cerr << "Brak wartości dla opcji: " << arg << std::endl;
+            return false;
+        }
+        const std::string& value = m_args[++i];
+        
+        if (arg == "--source") {
+            m_sourcePath = value;
+        } else if (arg == "--mask") {
+            m_maskPath = value;
+        } else if (arg == "--output") {
+            m_outputPath = value;
+        } else if (arg == "--trace") {
+            m_tracePath = value;
+        } else if (arg == "--stats") {
+            m_statisticsPath = value;
+        } else if (arg == "--mode") {
+            auto mode = parseMode(value);
+            if (!mode) {
+                std::cerr << "Nieznany tryb: " << value << std::endl;
+                return false;
+            }
+            m_mode = *mode;
+        } else if (arg == "--key") {
+            int r = 0, g = 0, b = 0;
+            char comma1 = 0, comma2 = 0;
+            std::stringstream ss(value);
+            if (!(ss >> r >> comma1 >> g >> comma2 >> b) || comma1 != ',' || comma2 != ',') {
+                std::cerr << "Niepoprawny kolor (oczekiwano R,G,B): " << value << std::endl;
+                return false;
+            }
+            m_transparentColor = sf::Color(
+                static_cast<std::uint8_t>(std::clamp(r, 0, 255)),
+                static_cast<std::uint8_t>(std::clamp(g, 0, 255)),
+                static_cast<std::uint8_t>(std::clamp(b, 0, 255)));
+        } else if (arg == "--tolerance") {
+            char* end = nullptr;
+            long tolerance = std::strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || tolerance < 0 || tolerance > 255) {
+                std::cerr << "Niepoprawna tolerancja (oczekiwano 0-255): " << value << std::endl;
+                return false;
+            }
+            m_tolerance = static_cast<int>(tolerance);
+        } else if (arg == "--opacity") {
+            char* end = nullptr;
+            long opacity = std::strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || opacity < 0 || opacity > 255) {
+                std::cerr << "Niepoprawne krycie (oczekiwano 0-255): " << value << std::endl;
+                return false;
+            }
+            m_opacity = static_cast<std::uint8_t>(opacity);
+        } else if (arg == "--soft" || arg == "--feather") {
+            char* end = nullptr;
+            long amount = std::strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || amount < 0 || amount > (arg == "--soft" ? 255 : 64)) {
+                std::cerr << "Niepoprawna wartość dla " << arg << ": " << value << std::endl;
+                return false;
+            }
+            (arg == "--soft" ? m_softness : m_feather) = static_cast<int>(amount);
+        } else if (arg == "--scale" || arg == "--rotate") {
+            char* end = nullptr;
+            float amount = std::strtof(value.c_str(), &end);
+            if (end == value.c_str() || *end != '\0' || (arg == "--scale" && (amount < 0.01f || amount > 16.0f))) {
+                std::cerr << "Niepoprawna wartość dla " << arg << ": " << value << std::endl;
+                return false;
+            }
+            if (arg == "--scale") {
+                m_maskTransform.scale = amount;
+            } else {
+                m_maskTransform.rotation = std::fmod(std::fmod(amount, 360.0f) + 360.0f, 360.0f);
+            }
+        } else if (arg == "--filter") {
+            if (value == "nearest") {
+                m_maskTransform.filter = ResampleFilter::Nearest;
+            } else if (value == "bilinear") {
+                m_maskTransform.filter = ResampleFilter::Bilinear;
+            } else if (value == "area") {
+                m_maskTransform.filter = ResampleFilter::Area;
+            } else {
+                std::cerr << "Nieznany filtr: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--wrap") {
+            if (value == "none") {
+                m_wrap = MaskWrap::None;
+            } else if (value == "repeat") {
+                m_wrap = MaskWrap::Repeat;
+            } else if (value == "mirror") {
+                m_wrap = MaskWrap::Mirror;
+            } else {
+                std::cerr << "Nieznany sposób powtarzania maski: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--offset") {
+            char comma = 0;
+            std::stringstream ss(value);
+            if (!(ss >> m_maskOffset.x >> comma >> m_maskOffset.y) || comma != ',') {
+                std::cerr << "Niepoprawne przesunięcie (oczekiwano X,Y): " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--precision") {
+            if (value == "8") {
+                m_precision.reset();
+            } else if (value == "16") {
+                m_precision = PixelFormat::UInt16;
+            } else if (value == "float") {
+                m_precision = PixelFormat::Float32;
+            } else {
+                std::cerr << "Niepoprawna precyzja (oczekiwano 8, 16 lub float): " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--threads") {
+            char* end = nullptr;
+            long threads = std::strtol(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || threads < 0 || threads > 256) {
+                std::cerr << "Niepoprawna liczba wątków (oczekiwano 0-256): " << value << std::endl;
+                return false;
+            }
+            m_threads = static_cast<unsigned int>(threads);
+        } else {
+            std::cerr << "Nieznana opcja: " << arg << std::endl;
+            return false;
+        }
+    }
+    
+    if (m_sourcePath.empty() || m_maskPath.empty() || m_outputPath.empty()) {
+        std::cerr << "Wymagane opcje: --source, --mask, --output" << std::endl;
+        return false;
+    }
+    
+    // Sciezka 16-bit/float obsluguje tylko twardy klucz bez transformacji maski
+    if (m_precision && (m_linear || m_softness > 0 || m_despill || m_feather > 0 ||
+                        !m_maskTransform.isIdentity() || m_fit || m_wrap != MaskWrap::None || m_align ||
+                        !m_statisticsPath.empty())) {
+        std::cerr << "Opcje --linear, --soft, --despill, --feather, --scale, --rotate, --fit, --wrap, --align i --stats "
+                  << "nie są dostępne z --precision 16/float" << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool CommandLine::saveStatistics(const BlendStatistics& statistics) const {
+    std::ofstream out(m_statisticsPath);
+    if (!out) {
+        std::cerr << "Nie można zapisać statystyk do: " << m_statisticsPath << std::endl;
+        return false;
+    }
+    
+    const char* channels[] = {"r", "g", "b", "a"};
+    out << "{\n"
+        << "  \"pixels\": " << statistics.pixels << ",\n"
+        << "  \"touched\": " << statistics.touched << ",\n"
+        << "  \"touched_fraction\": " << statistics.getTouchedFraction() << ",\n"
+        << "  \"clipped\": " << statistics.clipped << ",\n"
+        << "  \"clipped_fraction\": " << statistics.getClippedFraction() << ",\n"
+        << "  \"mean_luminance\": " << statistics.getMeanLuminance() << ",\n"
+        << "  \"channels\": {\n";
+    for (int channel = 0; channel < BlendStatistics::Channels; ++channel) {
+        out << "    \"" << channels[channel] << "\": {"
+            << "\"min\": " << statistics.getMin(channel)
+            << ", \"max\": " << statistics.getMax(channel)
+            << ", \"mean\": " << statistics.getMean(channel)
+            << ", \"histogram\": [";
+        for (int value = 0; value < 256; ++value) {
+            out << (value ? "," : "") << statistics.histogram[channel][value];
+        }
+        out << "]}" << (channel + 1 < BlendStatistics::Channels ? "," : "") << "\n";
+    }
+    out << "  }\n"
+        << "}\n";
+    
+    std::cout << "Zapisano statystyki wyniku do: " << m_statisticsPath << std::endl;
+    return true;
+}
+
+std::optional<BlendModeType> CommandLine::parseMode(const std::string& text) const {
+    auto modes = BlendMode::getAllModes();
+    
+    for (const auto& mode : modes) {
+        if (BlendMode::getModeName(mode) == text) {
+            return mode;
+        }
+    }
+    
+    char* end = nullptr;
+    long index = std::strtol(text.c_str(), &end, 10);
+    if (end != text.c_str() && *end == '\0' && index >= 0 && index < static_cast<long>(modes.size())) {
+        return modes[static_cast<size_t>(index)];
+    }
+    
+    return std::nullopt;
+}
+
+void CommandLine::printUsage() const {
+    std::cout << "Uzycie (tryb wsadowy):\n"
+              << "  MaskOverlay --source obraz.png --mask maska.png --output wynik.png [opcje]\n"
+              << "\n"
+              << "Opcje:\n"
+              << "  --mode N|nazwa     tryb nakladania (--list-modes)\n"
+              << "  --key R,G,B        kolor przezroczysty (domyslnie 255,0,255)\n"
+              << "  --tolerance N      tolerancja koloru przezroczystego 0-255 (domyslnie 10)\n"
+              << "  --opacity N        krycie maski 0-255 (domyslnie 255)\n"
+              << "  --soft N           miekki klucz: przejscie krycia o szerokosci N (0-255)\n"
+              << "  --despill          usun kolor klucza z polprzezroczystych krawedzi\n"
+              << "  --feather N        zmiekczenie krawedzi klucza o promieniu N (0-64)\n"
+              << "  --linear           mieszanie w swietle liniowym (np. do druku)\n"
+              << "  --no-alpha         ignoruj kanal alfa maski\n"
+              << "  --offset X,Y       przesuniecie maski (przy --wrap: faza powtarzania)\n"
+              << "  --align            znajdz przesuniecie maski automatycznie (zamiast --offset)\n"
+              << "  --scale F          skala maski 0.01-16\n"
+              << "  --rotate DEG       obrot maski w stopniach\n"
+              << "  --fit              dopasuj maske do obrazu i wysrodkuj\n"
+              << "  --wrap TRYB        powtarzanie maski na calym obrazie: none (domyslnie),\n"
+              << "                     repeat lub mirror (z odbiciem)\n"
+              << "  --filter NAZWA     filtr transformacji: nearest, bilinear, area (domyslnie)\n"
+              << "  --precision P      glebia przetwarzania: 8 (domyslnie), 16 lub float;\n"
+              << "                     16/float czyta i zapisuje PGM/PPM/PAM/PFM bez utraty bitow;\n"
+              << "                     inne formaty (PNG, JPG, ...) sa czytane i zapisywane z 8 bitami\n"
+              << "  --threads N        liczba watkow 0-256 (0 = wszystkie rdzenie)\n"
+              << "  --trace plik.json  zapisz slad w formacie Chrome trace (Perfetto)\n"
+              << "  --stats plik.json  zapisz statystyki wyniku: histogramy kanalow, min/max,\n"
+              << "                     obciete piksele, udzial pikseli pod maska\n"
+              << "\n"
+              << "Tryb wsadowy, gdy pierwszy argument jest jedna z powyzszych opcji; bez opcji\n"
+              << "(np. z samym plikiem) uruchamia interfejs graficzny." << std::endl;
+}
+
+void CommandLine::printModes() const {
+    auto modes = BlendMode::getAllModes();
+    for (size_t i = 0; i < modes.size(); ++i) {
+        std::cout << i << "  " << BlendMode::getModeName(modes[i]) << std::endl;
+    }
+}
+
+}
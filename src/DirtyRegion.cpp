@@ -0,0 +1,92 @@
+#include "DirtyRegion.h"
+#include <algorithm>
+
+namespace MaskOverlay {
+
+DirtyRegion::DirtyRegion()
+    : m_maxRects(16)
+{
+}
+
+void DirtyRegion::add(const sf::IntRect& rect) {
+    if (rect.size.x <= 0 || rect.size.y <= 0) {
+        return;
+    }
+    
+    sf::IntRect merged = rect;
+    bool changed = true;
+    
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < m_rects.size(); ++i) {
+            if (touches(m_rects[i], merged)) {
+                merged = unite(m_rects[i], merged);
+                m_rects.erase(m_rects.begin() + static_cast<std::ptrdiff_t>(i));
+                changed = true;
+                break;
+            }
+        }
+    }
+    
+    m_rects.push_back(merged);
+    
+    if (m_rects.size() > m_maxRects) {
+        sf::IntRect bounds = *getBounds();
+        m_rects.assign(1, bounds);
+    }
+}
+
+void DirtyRegion::addAll(const sf::Vector2u& size) {
+    m_rects.assign(1, sf::IntRect({0, 0}, sf::Vector2i(size)));
+}
+
+void DirtyRegion::clear() {
+    m_rects.clear();
+}
+
+bool DirtyRegion::isEmpty() const {
+    return m_rects.empty();
+}
+
+const std::vector<sf::IntRect>& DirtyRegion::getRects() const {
+    return m_rects;
+}
+
+std::optional<sf::IntRect> DirtyRegion::getBounds() const {
+    if (m_rects.empty()) {
+        return std::nullopt;
+    }
+    
+    sf::IntRect bounds = m_rects.front();
+    for (const auto& rect : m_rects) {
+        bounds = unite(bounds, rect);
+    }
+    return bounds;
+}
+
+long long DirtyRegion::getArea() const {
+    long long area = 0;
+    for (const auto& rect : m_rects) {
+        area += static_cast<long long>(rect.size.x) * rect.size.y;
+    }
+    return area;
+}
+
+void DirtyRegion::setMaxRects(std::size_t maxRects) {
+    m_maxRects = std::max<std::size_t>(1, maxRects);
+}
+
+bool DirtyRegion::touches(const sf::IntRect& a, const sf::IntRect& b) {
+    return a.position.x <= b.position.x + b.size.x && b.position.x <= a.position.x + a.size.x &&
+           a.position.y <= b.position.y + b.size.y && b.position.y <= a.position.y + a.size.y;
+}
+
+sf::IntRect DirtyRegion::unite(const sf::IntRect& a, const sf::IntRect& b) {
+    int left = std::min(a.position.x, b.position.x);
+    int top = std::min(a.position.y, b.position.y);
+    int right = std::max(a.position.x + a.size.x, b.position.x + b.size.x);
+    int bottom = std::max(a.position.y + a.size.y, b.position.y + b.size.y);
+    return sf::IntRect({left, top}, {right - left, bottom - top});
+}
+
+}
@@ -1,7 +1,10 @@
 #include "GUI.h"
+#include "Profiler.h"
 #include <algorithm>
+#include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
 #include <cstdint>
 
 namespace MaskOverlay {
@@ -14,6 +17,7 @@ Button::Button(const sf::Vector2f& position, const sf::Vector2f& size,
     , m_selected(false)
     , m_enabled(true)
     , m_hovered(false)
+    , m_dirty(true)
     , m_normalColor(sf::Color(70, 70, 70))
     , m_hoverColor(sf::Color(90, 90, 90))
     , m_selectedColor(sf::Color(50, 120, 200))
@@ -35,10 +39,12 @@ Button::Button(const sf::Vector2f& position, const sf::Vector2f& size,
     m_text->setPosition({position.x + size.x / 2, position.y + size.y / 2});
 }
 
-void Button::draw(sf::RenderWindow& window) {
-    window.draw(m_shape);
+void Button::draw(sf::RenderTarget& target) {
+    target.draw(m_shape);
+    Profiler::countDrawCall();
     if (m_text) {
-        window.draw(*m_text);
+        target.draw(*m_text);
+        Profiler::countDrawCall();
     }
 }
 
@@ -75,6 +81,7 @@ void Button::setLabel(const std::string& label) {
         m_text->setOrigin({textBounds.position.x + textBounds.size.x / 2,
                            textBounds.position.y + textBounds.size.y / 2});
     }
+    m_dirty = true;
 }
 
 std::string Button::getLabel() const {
@@ -91,6 +98,7 @@ void Button::setPosition(const sf::Vector2f& position) {
         sf::FloatRect textBounds = m_text->getLocalBounds();
         m_text->setPosition({position.x + size.x / 2, position.y + size.y / 2});
     }
+    m_dirty = true;
 }
 
 void Button::setSize(const sf::Vector2f& size) {
@@ -99,6 +107,7 @@ void Button::setSize(const sf::Vector2f& size) {
     if (m_text) {
         m_text->setPosition({position.x + size.x / 2, position.y + size.y / 2});
     }
+    m_dirty = true;
 }
 
 void Button::setColors(const sf::Color& normal, const sf::Color& hover,
@@ -111,6 +120,7 @@ void Button::setColors(const sf::Color& normal, const sf::Color& hover,
 }
 
 void Button::update(const sf::Vector2f& mousePos) {
+    sf::Color previousColor = m_shape.getFillColor();
     m_hovered = m_shape.getGlobalBounds().contains(mousePos);
     
     if (!m_enabled) {
@@ -126,6 +136,22 @@ void Button::update(const sf::Vector2f& mousePos) {
         m_shape.setFillColor(m_normalColor);
         if (m_text) m_text->setFillColor(sf::Color::White);
     }
+    
+    if (m_shape.getFillColor() != previousColor) {
+        m_dirty = true;
+    }
+}
+
+sf::FloatRect Button::getBounds() const {
+    return m_shape.getGlobalBounds();
+}
+
+bool Button::isDirty() const {
+    return m_dirty;
+}
+
+void Button::clearDirty() {
+    m_dirty = false;
 }
 
 
@@ -138,6 +164,7 @@ Slider::Slider(const sf::Vector2f& position, float width,
     , m_maxValue(maxValue)
     , m_value(minValue)
     , m_dragging(false)
+    , m_dirty(true)
     , m_position(position)
     , m_width(width)
 {
@@ -163,11 +190,12 @@ Slider::Slider(const sf::Vector2f& position, float width,
     updateThumbPosition();
 }
 
-void Slider::draw(sf::RenderWindow& window) {
-    if (m_label) window.draw(*m_label);
-    window.draw(m_track);
-    window.draw(m_thumb);
-    if (m_valueText) window.draw(*m_valueText);
+void Slider::draw(sf::RenderTarget& target) {
+    if (m_label) target.draw(*m_label);
+    target.draw(m_track);
+    target.draw(m_thumb);
+    if (m_valueText) target.draw(*m_valueText);
+    Profiler::addCount(ProfileCounter::DrawCalls, 2 + (m_label ? 1 : 0) + (m_valueText ? 1 : 0));
 }
 
 bool Slider::handleEvent(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased) {
@@ -215,6 +243,24 @@ void Slider::setLabel(const std::string& label) {
     if (m_label) {
         m_label->setString(label);
     }
+    m_dirty = true;
+}
+
+bool Slider::isDragging() const {
+    return m_dragging;
+}
+
+sf::FloatRect Slider::getBounds() const {
+    // Etykieta, tor z kciukiem i wartosc po prawej stronie toru
+    return sf::FloatRect({m_position.x - 8, m_position.y}, {m_width + 60, 32});
+}
+
+bool Slider::isDirty() const {
+    return m_dirty;
+}
+
+void Slider::clearDirty() {
+    m_dirty = false;
 }
 
 void Slider::updateThumbPosition() {
@@ -232,6 +278,7 @@ void Slider::updateThumbPosition() {
         ss << std::fixed << std::setprecision(0) << m_value;
         m_valueText->setString(ss.str());
     }
+    m_dirty = true;
 }
 
 
@@ -240,6 +287,7 @@ ColorPicker::ColorPicker(const sf::Vector2f& position, const sf::Font& font)
     : m_position(position)
     , m_font(&font)
     , m_color(sf::Color::Magenta)
+    , m_dirty(true)
 {
     m_label.emplace(font, "Kolor przezroczysty:", 13);
     m_label->setFillColor(sf::Color::White);
@@ -264,13 +312,14 @@ ColorPicker::ColorPicker(const sf::Vector2f& position, const sf::Font& font)
     updatePreview();
 }
 
-void ColorPicker::draw(sf::RenderWindow& window) {
-    if (m_label) window.draw(*m_label);
-    window.draw(m_preview);
-    if (m_redSlider) m_redSlider->draw(window);
-    if (m_greenSlider) m_greenSlider->draw(window);
-    if (m_blueSlider) m_blueSlider->draw(window);
-    if (m_alphaSlider) m_alphaSlider->draw(window);
+void ColorPicker::draw(sf::RenderTarget& target) {
+    if (m_label) target.draw(*m_label);
+    target.draw(m_preview);
+    Profiler::addCount(ProfileCounter::DrawCalls, 1 + (m_label ? 1 : 0));
+    if (m_redSlider) m_redSlider->draw(target);
+    if (m_greenSlider) m_greenSlider->draw(target);
+    if (m_blueSlider) m_blueSlider->draw(target);
+    if (m_alphaSlider) m_alphaSlider->draw(target);
 }
 
 bool ColorPicker::handleEvent(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased) {
@@ -307,8 +356,128 @@ void ColorPicker::setColor(const sf::Color& color) {
     updatePreview();
 }
 
+bool ColorPicker::isDragging() const {
+    return (m_redSlider && m_redSlider->isDragging()) ||
+           (m_greenSlider && m_greenSlider->isDragging()) ||
+           (m_blueSlider && m_blueSlider->isDragging()) ||
+           (m_alphaSlider && m_alphaSlider->isDragging());
+}
+
+sf::FloatRect ColorPicker::getBounds() const {
+    // Suwaki z wartosciami i podglad koloru; kciuk wystaje poza tor o polowe szerokosci
+    return sf::FloatRect({m_position.x - 8, m_position.y}, {230, 200});
+}
+
+bool ColorPicker::isDirty() const {
+    return m_dirty ||
+           (m_redSlider && m_redSlider->isDirty()) ||
+           (m_greenSlider && m_greenSlider->isDirty()) ||
+           (m_blueSlider && m_blueSlider->isDirty()) ||
+           (m_alphaSlider && m_alphaSlider->isDirty());
+}
+
+void ColorPicker::clearDirty() {
+    m_dirty = false;
+    if (m_redSlider) m_redSlider->clearDirty();
+    if (m_greenSlider) m_greenSlider->clearDirty();
+    if (m_blueSlider) m_blueSlider->clearDirty();
+    if (m_alphaSlider) m_alphaSlider->clearDirty();
+}
+
 void ColorPicker::updatePreview() {
     m_preview.setFillColor(m_color);
+    m_dirty = true;
+}
+
+
+
+PerfOverlay::PerfOverlay(const sf::Vector2f& position, const sf::Font& font)
+    : m_refreshed(false)
+{
+    m_background.setFillColor(sf::Color(0, 0, 0, 170));
+    m_background.setOutlineThickness(1);
+    m_background.setOutlineColor(sf::Color(100, 100, 100));
+    
+    m_text.emplace(font, "", 12);
+    m_text->setFillColor(sf::Color(180, 255, 180));
+    
+    setPosition(position);
+}
+
+void PerfOverlay::draw(sf::RenderTarget& target) {
+    target.draw(m_background);
+    if (m_text) {
+        target.draw(*m_text);
+    }
+    Profiler::addCount(ProfileCounter::DrawCalls, m_text ? 2 : 1);
+}
+
+void PerfOverlay::update() {
+    if (!m_refreshed || m_refreshClock.getElapsedTime() >= sf::milliseconds(250)) {
+        refresh();
+        m_refreshClock.restart();
+        m_refreshed = true;
+    }
+}
+
+void PerfOverlay::setPosition(const sf::Vector2f& position) {
+    m_background.setPosition(position);
+    if (m_text) {
+        m_text->setPosition({position.x + 8, position.y + 6});
+    }
+}
+
+void PerfOverlay::setResultStatistics(const BlendStatistics* statistics) {
+    if (statistics) {
+        m_resultStatistics = *statistics;
+    } else {
+        m_resultStatistics.reset();
+    }
+    m_refreshed = false;
+}
+
+void PerfOverlay::refresh() {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    
+    StageStatistics frame = Profiler::getStageStatistics(ProfileStage::Frame);
+    ss << "Klatka: " << frame.last << " ms  (p50 " << frame.p50
+       << " / p95 " << frame.p95 << " / p99 " << frame.p99 << ")\n";
+    
+    for (ProfileStage stage : {ProfileStage::Decode, ProfileStage::Blend, ProfileStage::Upload, ProfileStage::Render}) {
+        StageStatistics stats = Profiler::getStageStatistics(stage);
+        ss << Profiler::getStageName(stage) << ": " << stats.last << " ms  (p95 " << stats.p95 << ")\n";
+    }
+    
+    ss << std::setprecision(1);
+    ss << "Ostatnie zastosowanie: " << Profiler::getLastApplyMegapixelsPerSecond() << " Mpx/s\n";
+    
+    CounterStatistics upload = Profiler::getCounterStatistics(ProfileCounter::UploadBytes);
+    ss << "Tekstury: " << upload.average / 1024.0 << " KB/klatke  (max " << upload.peak / 1024.0 << " KB)\n";
+    
+    CounterStatistics drawCalls = Profiler::getCounterStatistics(ProfileCounter::DrawCalls);
+    ss << "Wywolania rysowania: " << drawCalls.last << "\n";
+    
+    // Statystyki wyniku zbierane w trakcie mieszania, gdy nakladka jest widoczna
+    if (m_resultStatistics) {
+        const BlendStatistics& result = *m_resultStatistics;
+        ss << "Wynik: maska " << result.getTouchedFraction() * 100 << "% pikseli, obciete "
+           << result.getClippedFraction() * 100 << "% (" << result.clipped << ")\n";
+        const char* channels[] = {"R", "G", "B", "A"};
+        for (int channel = 0; channel < BlendStatistics::Channels; ++channel) {
+            ss << channels[channel] << ": " << result.getMin(channel) << "-" << result.getMax(channel)
+               << "  srednia " << result.getMean(channel) << "\n";
+        }
+        ss << "Luminancja: srednia " << result.getMeanLuminance();
+    } else {
+        ss << "Wynik: brak statystyk (zastosuj maske)";
+    }
+    
+    if (m_text) {
+        m_text->setString(ss.str());
+        sf::FloatRect bounds = m_text->getLocalBounds();
+        m_background.setSize(sf::Vector2f(bounds.position.x + bounds.size.x + 16, bounds.position.y + bounds.size.y + 14));
+    }
 }
 
 
@@ -316,16 +485,23 @@ void ColorPicker::updatePreview() {
 GUI::GUI(sf::RenderWindow& window, const sf::Font& font)
     : m_window(window)
     , m_font(font)
+    , m_perfOverlayVisible(false)
     , m_alphaCheckbox(nullptr)
     , m_offsetXSlider(nullptr)
     , m_offsetYSlider(nullptr)
     , m_selectedMaskIndex(-1)
     , m_maskScrollOffset(0)
+    , m_layerValid(false)
+    , m_libraryDirty(false)
+    , m_statusDirty(false)
+    , m_sizeInfoDirty(false)
     , m_hasSource(false)
     , m_hasMask(false)
     , m_hasResult(false)
     , m_currentBlendMode(BlendModeType::Replace)
     , m_transparentColor(sf::Color::Magenta)
+    , m_tolerance(BlendMode::DefaultTolerance)
+    , m_opacity(255)
     , m_useAlpha(true)
     , m_maskOffset(0, 0)
     , m_sourceSize(0, 0)
@@ -336,6 +512,7 @@ GUI::GUI(sf::RenderWindow& window, const sf::Font& font)
     initializeModeButtons();
     initializeColorPicker();
     initializeSliders();
+    m_perfOverlay = std::make_unique<PerfOverlay>(sf::Vector2f(260, 10), m_font);
     updateLayout();
 }
 
@@ -371,6 +548,11 @@ void GUI::initializePanels() {
     m_sizeInfoText.emplace(m_font, "", 11);
     m_sizeInfoText->setFillColor(sf::Color(150, 150, 150));
     m_sizeInfoText->setPosition({15, static_cast<float>(windowSize.y - 70)});
+    
+
+    m_rightPanel.title.emplace(m_font, "Biblioteka masek:", 13);
+    m_rightPanel.title->setFillColor(sf::Color(200, 200, 200));
+    m_rightPanel.title->setPosition({static_cast<float>(windowSize.x - 200) + 10, 50});
 }
 
 void GUI::initializeButtons() {
@@ -423,10 +605,11 @@ void GUI::initializeButtons() {
 
 void GUI::initializeModeButtons() {
     float startY = 300;
-    float buttonWidth = 105;
-    float buttonHeight = 30;
+    float buttonWidth = 70;
+    float buttonHeight = 26;
     float spacing = 5;
     float x = 15;
+    int columns = 3;
     
 
     m_leftPanel.title.emplace(m_font, "Tryb nakladania:", 13);
@@ -444,12 +627,12 @@ void GUI::initializeModeButtons() {
         m_modeButtons.emplace_back(
             sf::Vector2f(posX, posY),
             sf::Vector2f(buttonWidth, buttonHeight),
-            BlendMode::getModeName(mode),
+            BlendMode::getModeLabel(mode),
             m_font
         );
         
         col++;
-        if (col >= 2) {
+        if (col >= columns) {
             col = 0;
             row++;
         }
@@ -466,7 +649,39 @@ void GUI::initializeColorPicker() {
 }
 
 void GUI::initializeSliders() {
+    m_toleranceSlider = std::make_unique<Slider>(sf::Vector2f(15, 675), 55, 0, 100, m_font, "Tolerancja:");
+    m_toleranceSlider->setValue(static_cast<float>(m_tolerance));
+    
+    m_opacitySlider = std::make_unique<Slider>(sf::Vector2f(133, 675), 55, 0, 255, m_font, "Krycie:");
+    m_opacitySlider->setValue(static_cast<float>(m_opacity));
+}
 
+void GUI::handleToleranceSlider(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased) {
+    if (!m_toleranceSlider || !m_toleranceSlider->handleEvent(mousePos, mousePressed, mouseReleased)) {
+        return;
+    }
+    
+    int tolerance = static_cast<int>(std::lround(m_toleranceSlider->getValue()));
+    if (tolerance != m_tolerance) {
+        m_tolerance = tolerance;
+        if (m_onToleranceChange) {
+            m_onToleranceChange(m_tolerance);
+        }
+    }
+}
+
+void GUI::handleOpacitySlider(const sf::Vector2f& mousePos, bool mousePressed, bool mouseReleased) {
+    if (!m_opacitySlider || !m_opacitySlider->handleEvent(mousePos, mousePressed, mouseReleased)) {
+        return;
+    }
+    
+    int opacity = static_cast<int>(std::lround(m_opacitySlider->getValue()));
+    if (opacity != m_opacity) {
+        m_opacity = opacity;
+        if (m_onOpacityChange) {
+            m_onOpacityChange(m_opacity);
+        }
+    }
 }
 
 void GUI::updateLayout() {
@@ -486,41 +701,162 @@ void GUI::updateLayout() {
     if (m_sizeInfoText) {
         m_sizeInfoText->setPosition({15, static_cast<float>(windowSize.y - 70)});
     }
+    if (m_rightPanel.title) {
+        m_rightPanel.title->setPosition({static_cast<float>(windowSize.x - 200) + 10, 50});
+    }
+    
+    if (m_layer.getSize() != windowSize) {
+        if (!m_layer.resize(windowSize)) {
+            std::cerr << "Nie mozna utworzyc warstwy interfejsu " << windowSize.x << "x" << windowSize.y << std::endl;
+        }
+        m_layerSprite.emplace(m_layer.getTexture());
+    }
+    m_layerValid = false;
 }
 
 void GUI::draw() {
-
-    m_window.draw(m_leftPanel.background);
-    m_window.draw(m_rightPanel.background);
-    m_window.draw(m_bottomBar);
+    if (!m_layerValid) {
+        redrawLayer();
+    } else {
+        redrawDirtyWidgets();
+    }
     
-
-    sf::Text libraryTitle(m_font, "Biblioteka masek:", 13);
-    libraryTitle.setFillColor(sf::Color(200, 200, 200));
-    libraryTitle.setPosition({m_rightPanel.background.getPosition().x + 10, 50});
-    m_window.draw(libraryTitle);
+    if (m_layerSprite) {
+        m_window.draw(*m_layerSprite);
+        Profiler::countDrawCall();
+    }
     
+    if (m_perfOverlayVisible && m_perfOverlay) {
+        m_perfOverlay->draw(m_window);
+    }
+}
 
+void GUI::redrawLayer() {
+    m_layer.clear(sf::Color::Transparent);
+    
+    m_layer.draw(m_leftPanel.background);
+    m_layer.draw(m_rightPanel.background);
+    m_layer.draw(m_bottomBar);
+    Profiler::addCount(ProfileCounter::DrawCalls, 3);
+    
     if (m_leftPanel.title) {
-        m_window.draw(*m_leftPanel.title);
+        m_layer.draw(*m_leftPanel.title);
+        Profiler::countDrawCall();
     }
     
-
     for (auto& btn : m_mainButtons) {
-        btn.draw(m_window);
+        btn.draw(m_layer);
+        btn.clearDirty();
     }
     
-
     for (auto& btn : m_modeButtons) {
-        btn.draw(m_window);
+        btn.draw(m_layer);
+        btn.clearDirty();
     }
     
-
     if (m_colorPicker) {
-        m_colorPicker->draw(m_window);
+        m_colorPicker->draw(m_layer);
+        m_colorPicker->clearDirty();
+    }
+    
+    if (m_toleranceSlider) {
+        m_toleranceSlider->draw(m_layer);
+        m_toleranceSlider->clearDirty();
     }
     
+    if (m_opacitySlider) {
+        m_opacitySlider->draw(m_layer);
+        m_opacitySlider->clearDirty();
+    }
+    
+    drawLibrary(m_layer);
+    
+    if (m_statusText) m_layer.draw(*m_statusText);
+    if (m_sizeInfoText) m_layer.draw(*m_sizeInfoText);
+    Profiler::addCount(ProfileCounter::DrawCalls, (m_statusText ? 1 : 0) + (m_sizeInfoText ? 1 : 0));
+    
+    m_layer.display();
+    m_layerValid = true;
+    m_libraryDirty = false;
+    m_statusDirty = false;
+    m_sizeInfoDirty = false;
+}
 
+void GUI::redrawDirtyWidgets() {
+    // Zmienione kontrolki sa zamalowywane tlem panelu i rysowane ponownie w warstwie
+    const sf::Color panelColor = m_leftPanel.background.getFillColor();
+    bool changed = false;
+    
+    for (auto* buttons : {&m_mainButtons, &m_modeButtons}) {
+        for (auto& btn : *buttons) {
+            if (btn.isDirty()) {
+                drawBackdrop(btn.getBounds(), panelColor);
+                btn.draw(m_layer);
+                btn.clearDirty();
+                changed = true;
+            }
+        }
+    }
+    
+    if (m_colorPicker && m_colorPicker->isDirty()) {
+        drawBackdrop(m_colorPicker->getBounds(), panelColor);
+        m_colorPicker->draw(m_layer);
+        m_colorPicker->clearDirty();
+        changed = true;
+    }
+    
+    if (m_toleranceSlider && m_toleranceSlider->isDirty()) {
+        drawBackdrop(m_toleranceSlider->getBounds(), panelColor);
+        m_toleranceSlider->draw(m_layer);
+        m_toleranceSlider->clearDirty();
+        changed = true;
+    }
+    
+    if (m_opacitySlider && m_opacitySlider->isDirty()) {
+        drawBackdrop(m_opacitySlider->getBounds(), panelColor);
+        m_opacitySlider->draw(m_layer);
+        m_opacitySlider->clearDirty();
+        changed = true;
+    }
+    
+    if (m_libraryDirty) {
+        sf::Vector2u windowSize = m_window.getSize();
+        drawBackdrop(sf::FloatRect(m_rightPanel.background.getPosition(),
+                                   {200, static_cast<float>(windowSize.y) - 30}),
+                     m_rightPanel.background.getFillColor());
+        drawLibrary(m_layer);
+        m_libraryDirty = false;
+        changed = true;
+    }
+    
+    if (m_sizeInfoDirty && m_sizeInfoText) {
+        sf::Vector2u windowSize = m_window.getSize();
+        drawBackdrop(sf::FloatRect({0, static_cast<float>(windowSize.y) - 72}, {250, 42}), panelColor);
+        m_layer.draw(*m_sizeInfoText);
+        Profiler::countDrawCall();
+        m_sizeInfoDirty = false;
+        changed = true;
+    }
+    
+    if (m_statusDirty && m_statusText) {
+        m_layer.draw(m_bottomBar);
+        m_layer.draw(*m_statusText);
+        Profiler::addCount(ProfileCounter::DrawCalls, 2);
+        m_statusDirty = false;
+        changed = true;
+    }
+    
+    if (changed) {
+        m_layer.display();
+    }
+}
+
+void GUI::drawLibrary(sf::RenderTarget& target) {
+    if (m_rightPanel.title) {
+        target.draw(*m_rightPanel.title);
+        Profiler::countDrawCall();
+    }
+    
     float maskStartY = 80;
     float maskX = m_rightPanel.background.getPosition().x + 10;
     float maskSpacing = 75;
@@ -539,16 +875,22 @@ void GUI::draw() {
                 highlight.setFillColor(sf::Color(50, 100, 150, 100));
                 highlight.setOutlineThickness(2);
                 highlight.setOutlineColor(sf::Color(100, 150, 200));
-                m_window.draw(highlight);
+                target.draw(highlight);
+                Profiler::countDrawCall();
             }
             
-            m_window.draw(m_maskSprites[i]);
+            target.draw(m_maskSprites[i]);
+            Profiler::countDrawCall();
         }
     }
-    
+}
 
-    if (m_statusText) m_window.draw(*m_statusText);
-    if (m_sizeInfoText) m_window.draw(*m_sizeInfoText);
+void GUI::drawBackdrop(const sf::FloatRect& bounds, const sf::Color& color) {
+    sf::RectangleShape backdrop(bounds.size);
+    backdrop.setPosition(bounds.position);
+    backdrop.setFillColor(color);
+    m_layer.draw(backdrop);
+    Profiler::countDrawCall();
 }
 
 void GUI::handleMouseClick(const sf::Vector2f& mousePos) {
@@ -601,6 +943,7 @@ void GUI::handleMouseClick(const sf::Vector2f& mousePos) {
         
         if (maskBounds.contains(mousePos)) {
             m_selectedMaskIndex = static_cast<int>(i);
+            m_libraryDirty = true;
             if (m_onMaskSelect) {
                 m_onMaskSelect(i);
             }
@@ -617,6 +960,9 @@ void GUI::handleMouseClick(const sf::Vector2f& mousePos) {
             }
         }
     }
+    
+    handleToleranceSlider(mousePos, true, false);
+    handleOpacitySlider(mousePos, true, false);
 }
 
 void GUI::handleMouseWheel(const sf::Vector2f& mousePos, float delta) {
@@ -625,6 +971,7 @@ void GUI::handleMouseWheel(const sf::Vector2f& mousePos, float delta) {
         m_maskScrollOffset = std::max(0.0f, m_maskScrollOffset);
         float maxScroll = std::max(0.0f, static_cast<float>(m_maskSprites.size()) * 75 - 400);
         m_maskScrollOffset = std::min(m_maskScrollOffset, maxScroll);
+        m_libraryDirty = true;
     }
 }
 
@@ -635,6 +982,10 @@ void GUI::handleResize() {
 void GUI::update() {
     sf::Vector2f mousePos = sf::Vector2f(sf::Mouse::getPosition(m_window));
     
+    if (m_perfOverlayVisible && m_perfOverlay) {
+        m_perfOverlay->update();
+    }
+    
     for (auto& btn : m_mainButtons) {
         btn.update(mousePos);
     }
@@ -652,6 +1003,9 @@ void GUI::update() {
             }
         }
     }
+    
+    handleToleranceSlider(mousePos, false, !sf::Mouse::isButtonPressed(sf::Mouse::Button::Left));
+    handleOpacitySlider(mousePos, false, !sf::Mouse::isButtonPressed(sf::Mouse::Button::Left));
 }
 
 void GUI::setOnLoadSource(std::function<void()> callback) {
@@ -678,6 +1032,14 @@ void GUI::setOnTransparentColorChange(std::function<void(const sf::Color&)> call
     m_onTransparentColorChange = callback;
 }
 
+void GUI::setOnToleranceChange(std::function<void(int)> callback) {
+    m_onToleranceChange = callback;
+}
+
+void GUI::setOnOpacityChange(std::function<void(int)> callback) {
+    m_onOpacityChange = callback;
+}
+
 void GUI::setOnUseAlphaChange(std::function<void(bool)> callback) {
     m_onUseAlphaChange = callback;
 }
@@ -720,6 +1082,20 @@ void GUI::setTransparentColor(const sf::Color& color) {
     }
 }
 
+void GUI::setTolerance(int tolerance) {
+    m_tolerance = tolerance;
+    if (m_toleranceSlider) {
+        m_toleranceSlider->setValue(static_cast<float>(tolerance));
+    }
+}
+
+void GUI::setOpacity(int opacity) {
+    m_opacity = opacity;
+    if (m_opacitySlider) {
+        m_opacitySlider->setValue(static_cast<float>(opacity));
+    }
+}
+
 void GUI::setUseAlpha(bool use) {
     m_useAlpha = use;
     m_mainButtons[4].setLabel(m_useAlpha ? "Uzyj kanalu alfa [X]" : "Uzyj kanalu alfa [ ]");
@@ -738,6 +1114,7 @@ void GUI::setSourceSize(const sf::Vector2u& size) {
     }
     if (m_sizeInfoText) {
         m_sizeInfoText->setString(ss.str());
+        m_sizeInfoDirty = true;
     }
 }
 
@@ -750,6 +1127,7 @@ void GUI::setMaskSize(const sf::Vector2u& size) {
     ss << "Maska: " << size.x << "x" << size.y;
     if (m_sizeInfoText) {
         m_sizeInfoText->setString(ss.str());
+        m_sizeInfoDirty = true;
     }
 }
 
@@ -771,6 +1149,7 @@ void GUI::setMaskThumbnails(const std::vector<std::pair<std::string, sf::Texture
         
         m_maskSprites.push_back(sprite);
     }
+    m_libraryDirty = true;
 }
 
 sf::FloatRect GUI::getPreviewArea() const {
@@ -781,9 +1160,30 @@ sf::FloatRect GUI::getPreviewArea() const {
     );
 }
 
+void GUI::setPerfOverlayVisible(bool visible) {
+    m_perfOverlayVisible = visible;
+}
+
+bool GUI::isPerfOverlayVisible() const {
+    return m_perfOverlayVisible;
+}
+
+void GUI::setResultStatistics(const BlendStatistics* statistics) {
+    if (m_perfOverlay) {
+        m_perfOverlay->setResultStatistics(statistics);
+    }
+}
+
+bool GUI::isInteracting() const {
+    return (m_colorPicker && m_colorPicker->isDragging()) ||
+           (m_toleranceSlider && m_toleranceSlider->isDragging()) ||
+           (m_opacitySlider && m_opacitySlider->isDragging());
+}
+
 void GUI::setStatusMessage(const std::string& message) {
     if (m_statusText) {
         m_statusText->setString(message);
+        m_statusDirty = true;
     }
 }
 
@@ -795,6 +1195,14 @@ sf::Color GUI::getTransparentColor() const {
     return m_transparentColor;
 }
 
+int GUI::getTolerance() const {
+    return m_tolerance;
+}
+
+int GUI::getOpacity() const {
+    return m_opacity;
+}
+
 bool GUI::getUseAlpha() const {
     return m_useAlpha;
 }
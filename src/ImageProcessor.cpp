@@ -1,26 +1,99 @@
 #include "ImageProcessor.h"
+#include "MaskAligner.h"
+#include "Profiler.h"
+#include "Tracer.h"
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
 
 namespace MaskOverlay {
 
+namespace {
+
+// Najkrotszy odcinek wiersza mieszany jednym wywolaniem przy powtarzanej masce - waskie
+// maski sa powielane w pamieci podrecznej do tej szerokosci
+constexpr unsigned int MinWrapSpan = 256;
+
+long long wrapIndex(long long index, long long size, bool mirror) {
+    const long long period = mirror ? 2 * size : size;
+    index %= period;
+    if (index < 0) {
+        index += period;
+    }
+    return index < size ? index : period - 1 - index;
+}
+
+}
+
 ImageProcessor::ImageProcessor()
-    : m_maskOffset(0, 0)
+    : m_maskFill(sf::Color::Transparent)
+    , m_sourceSize(0, 0)
+    , m_sourceReleased(false)
+    , m_keepSourceImage(true)
+    , m_sourceStatisticsGeneration(0)
+    , m_statisticsRevision(0)
+    , m_resultImageValid(false)
+    , m_resultPending(false)
+    , m_sourceGeneration(0)
+    , m_maskGeneration(0)
+    , m_originalMaskGeneration(0)
+    , m_resultGeneration(0)
+    , m_resultRevision(0)
+    , m_maskOffset(0, 0)
+    , m_keySoftness(0)
+    , m_keyDespill(false)
+    , m_keyFeather(0)
+    , m_linearLight(false)
+    , m_maskWrap(MaskWrap::None)
+    , m_collectStatistics(false)
     , m_hasSource(false)
     , m_hasMask(false)
     , m_hasResult(false)
+    , m_texturesEnabled(true)
+    , m_sourceTextureVisible(true)
+    , m_maskTextureVisible(true)
+    , m_resultTextureVisible(true)
+    , m_sourceTextureValid(false)
+    , m_maskTextureValid(false)
+    , m_textureBudget(std::size_t(256) << 20)
+    , m_threadPool(std::make_unique<ThreadPool>())
 {
 }
 
+ImageProcessor::~ImageProcessor() {
+    BufferPool::getShared().release(std::move(m_frontResult.pixels));
+    BufferPool::getShared().release(std::move(m_backResult.pixels));
+}
+
 bool ImageProcessor::loadSourceImage(const std::string& path) {
-    if (!m_sourceImage.loadFromFile(path)) {
+    TraceScope trace("loadSourceImage", "io");
+    trace.addArg("path", path);
+    bool loaded;
+    {
+        ProfileScope scope(ProfileStage::Decode);
+        loaded = m_sourceImage.loadFromFile(path);
+    }
+    
+    if (!loaded) {
         std::cerr << "Nie można wczytać obrazu źródłowego: " << path << std::endl;
         return false;
     }
     
+    m_sourcePath = path;
+    m_sourceSize = m_sourceImage.getSize();
+    m_sourceReleased = false;
     m_hasSource = true;
     m_hasResult = false;
+    m_frontResult.valid = false;
+    m_backResult.valid = false;
+    m_resultPending = false;
+    m_history.clear();
+    ++m_sourceGeneration;
     updateSourceTexture();
     
+    trace.addArg("width", m_sourceImage.getSize().x);
+    trace.addArg("height", m_sourceImage.getSize().y);
     std::cout << "Wczytano obraz źródłowy: " << path 
               << " (" << m_sourceImage.getSize().x << "x" << m_sourceImage.getSize().y << ")" << std::endl;
     
@@ -28,86 +101,594 @@ bool ImageProcessor::loadSourceImage(const std::string& path) {
 }
 
 bool ImageProcessor::loadMask(const std::string& path) {
-    if (!m_maskImage.loadFromFile(path)) {
+    TraceScope trace("loadMask", "io");
+    trace.addArg("path", path);
+    bool loaded;
+    {
+        ProfileScope scope(ProfileStage::Decode);
+        loaded = m_maskImage.loadFromFile(path);
+    }
+    
+    if (!loaded) {
         std::cerr << "Nie można wczytać maski: " << path << std::endl;
         return false;
     }
     
     m_hasMask = true;
     m_hasResult = false;
+    m_maskTransform = MaskTransform();
+    m_transformedMask = sf::Image();
+    ++m_maskGeneration;
+    ++m_originalMaskGeneration;
     updateMaskTexture();
     
 
     resetMaskOffset();
     
+    // Pokrycie klucza liczone od razu z ostatnimi ustawieniami, nie przy pierwszym mieszaniu
+    if (m_keyCoverage.valid) {
+        updateKeyCoverage(m_keyCoverage.key, m_keyCoverage.tolerance, m_keyCoverage.useAlpha);
+    }
+    
+    trace.addArg("width", m_maskImage.getSize().x);
+    trace.addArg("height", m_maskImage.getSize().y);
     std::cout << "Wczytano maskę: " << path 
               << " (" << m_maskImage.getSize().x << "x" << m_maskImage.getSize().y << ")" << std::endl;
     
     return true;
 }
 
+bool ImageProcessor::setSourceImage(const sf::Image& image) {
+    if (image.getSize().x == 0 || image.getSize().y == 0) {
+        std::cerr << "Pusty obraz źródłowy!" << std::endl;
+        return false;
+    }
+    
+    m_sourceImage = image;
+    m_sourcePath.clear();
+    m_sourceSize = m_sourceImage.getSize();
+    m_sourceReleased = false;
+    m_hasSource = true;
+    m_hasResult = false;
+    m_frontResult.valid = false;
+    m_backResult.valid = false;
+    m_resultPending = false;
+    m_history.clear();
+    ++m_sourceGeneration;
+    updateSourceTexture();
+    
+    return true;
+}
+
+bool ImageProcessor::setMask(const sf::Image& image) {
+    if (image.getSize().x == 0 || image.getSize().y == 0) {
+        std::cerr << "Pusta maska!" << std::endl;
+        return false;
+    }
+    
+    m_maskImage = image;
+    m_hasMask = true;
+    m_hasResult = false;
+    m_maskTransform = MaskTransform();
+    m_transformedMask = sf::Image();
+    ++m_maskGeneration;
+    ++m_originalMaskGeneration;
+    updateMaskTexture();
+    resetMaskOffset();
+    
+    if (m_keyCoverage.valid) {
+        updateKeyCoverage(m_keyCoverage.key, m_keyCoverage.tolerance, m_keyCoverage.useAlpha);
+    }
+    
+    return true;
+}
+
 void ImageProcessor::applyMask(BlendModeType mode, 
                                const sf::Color& transparentColor,
-                               bool useAlpha) {
+                               bool useAlpha,
+                               int tolerance,
+                               std::uint8_t opacity) {
+    if (computeMask(mode, transparentColor, useAlpha, tolerance, opacity)) {
+        publishResult();
+    }
+}
+
+bool ImageProcessor::computeMask(BlendModeType mode,
+                                 const sf::Color& transparentColor,
+                                 bool useAlpha,
+                                 int tolerance,
+                                 std::uint8_t opacity) {
     if (!m_hasSource || !m_hasMask) {
         std::cerr << "Brak obrazu źródłowego lub maski!" << std::endl;
-        return;
+        return false;
     }
     
-    sf::Vector2u sourceSize = m_sourceImage.getSize();
-    sf::Vector2u maskSize = m_maskImage.getSize();
+    if (!ensureSourceImage()) {
+        return false;
+    }
     
-
-    m_resultImage.resize(sf::Vector2u(sourceSize.x, sourceSize.y), sf::Color::Transparent);
+    const auto blendStart = std::chrono::steady_clock::now();
+    const sf::Vector2u sourceSize = m_sourceImage.getSize();
     
-
-    for (unsigned int y = 0; y < sourceSize.y; ++y) {
-        for (unsigned int x = 0; x < sourceSize.x; ++x) {
-            sf::Color sourcePixel = m_sourceImage.getPixel(sf::Vector2u(x, y));
+    TraceScope trace("applyMask", "blend");
+    trace.addArg("width", sourceSize.x);
+    trace.addArg("height", sourceSize.y);
+    trace.addArg("mode", BlendMode::getModeName(mode));
+    trace.addArg("threads", m_threadPool->getThreadCount());
+    trace.addArg("tolerance", static_cast<long long>(tolerance));
+    trace.addArg("opacity", static_cast<long long>(opacity));
+    trace.addArg("linear", static_cast<long long>(m_linearLight));
+    trace.addArg("wrap", static_cast<long long>(m_maskWrap));
+    trace.addArg("statistics", static_cast<long long>(m_collectStatistics));
+    
+    // Przy zerowym kryciu wynik to kopia zrodla - klasyfikacja klucza nie jest potrzebna
+    if (opacity > 0) {
+        updateKeyCoverage(transparentColor, tolerance, useAlpha);
+    }
+    
+    const sf::Vector2u maskSize = getActiveMask().getSize();
+    const std::size_t rowBytes = static_cast<std::size_t>(sourceSize.x) * 4;
+    const sf::Vector2i offset = m_maskOffset;
+    const sf::IntRect sourceRect({0, 0}, sf::Vector2i(sourceSize));
+    const bool wrapped = m_maskWrap != MaskWrap::None;
+    const std::optional<sf::IntRect> maskRect = wrapped ? std::optional<sf::IntRect>(sourceRect) :
+        sf::IntRect(-offset, sf::Vector2i(maskSize)).findIntersection(sourceRect);
+    
+    // Wynik jest liczony do bufora tylnego, a po zakończeniu zamieniany z przednim,
+    // z którego czytają tekstura, zapis i podgląd kafelkowy
+    ResultBuffer& target = m_backResult;
+    if (!target.pixels || target.size != sourceSize) {
+        BufferPool::getShared().release(std::move(target.pixels));
+        target.pixels = BufferPool::getShared().acquire(rowBytes * sourceSize.y);
+        target.size = sourceSize;
+        target.valid = false;
+    }
+    
+    // Przy niezmienionym źródle bufor różni się od źródła tylko w obszarze maski, z którym
+    // był liczony - przeliczany jest ten obszar i bieżący obszar maski
+    sf::IntRect region = sourceRect;
+    if (target.valid) {
+        DirtyRegion changed;
+        if (target.maskRect) {
+            changed.add(*target.maskRect);
+        }
+        if (maskRect) {
+            changed.add(*maskRect);
+        }
+        region = changed.getBounds().value_or(sf::IntRect());
+    }
+    
+    // Zmiana względem wyświetlanego wyniku - do wysłania na GPU po publishResult();
+    // bufor przedni nie jest tu modyfikowany
+    const bool previous = m_frontResult.valid && m_frontResult.size == sourceSize;
+    m_pendingDirty.clear();
+    if (previous) {
+        if (m_frontResult.maskRect) {
+            m_pendingDirty.add(*m_frontResult.maskRect);
+        }
+        if (maskRect) {
+            m_pendingDirty.add(*maskRect);
+        }
+        m_pendingRegion = m_pendingDirty.getBounds().value_or(sf::IntRect());
+    } else {
+        m_pendingDirty.addAll(sourceSize);
+        m_pendingRegion = sourceRect;
+    }
+    
+    target.maskRect = maskRect;
+    trace.addArg("regionWidth", region.size.x);
+    trace.addArg("regionHeight", region.size.y);
+    
+    const std::uint8_t* source = m_sourceImage.getPixelsPtr();
+    const std::uint8_t* mask = m_keyCoverage.despill ? m_keyCoverage.despilled.data() : getActiveMask().getPixelsPtr();
+    const std::uint8_t* coverage = m_keyCoverage.alpha.data();
+    std::uint8_t* result = target.pixels->data();
+    
+    // Powtarzana maska: przesuniecie jest faza kafelkowania, a wiersz wyniku dzielony jest na
+    // odcinki konczace sie na krawedzi okresu maski (lub jej powielonej kopii)
+    const bool mirror = m_maskWrap == MaskWrap::Mirror;
+    if (wrapped && opacity > 0) {
+        updateWrappedMask();
+    }
+    const bool strip = wrapped && m_wrappedMask.valid;
+    const std::uint8_t* wrapPixels = strip ? m_wrappedMask.pixels.data() : mask;
+    const std::uint8_t* wrapCoverage = strip ? m_wrappedMask.alpha.data() : coverage;
+    const long long wrapWidth = strip ? m_wrappedMask.width : maskSize.x;
+    
+    const long long regionBegin = region.position.x;
+    const long long regionEnd = region.position.x + region.size.x;
+    const long long spanBegin = std::clamp<long long>(-static_cast<long long>(offset.x), regionBegin, regionEnd);
+    const long long spanEnd = std::clamp<long long>(static_cast<long long>(maskSize.x) - offset.x, spanBegin, regionEnd);
+    
+    // Statystyki wyniku: kazdy pas wierszy zbiera wlasne roznice histogramow w blendRow(),
+    // laczone na koncu z histogramem zrodla
+    const std::size_t rows = static_cast<std::size_t>(std::max(0, region.size.y));
+    const std::size_t chunk = std::max<std::size_t>(1, rows / (m_threadPool->getThreadCount() * 4));
+    std::vector<BlendStatistics> partial(m_collectStatistics ? (rows + chunk - 1) / chunk : 0);
+    
+    m_threadPool->parallelFor(rows, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        TraceScope tile("tile", "blend");
+        tile.addArg("rowBegin", static_cast<long long>(region.position.y + rowBegin));
+        tile.addArg("rowEnd", static_cast<long long>(region.position.y + rowEnd));
+        BlendStatistics* statistics = partial.empty() ? nullptr : &partial[rowBegin / chunk];
+        
+        for (std::size_t row = rowBegin; row < rowEnd; ++row) {
+            const std::size_t y = static_cast<std::size_t>(region.position.y) + row;
+            const std::uint8_t* sourceRow = source + y * rowBytes;
+            std::uint8_t* resultRow = result + y * rowBytes;
+            const long long maskY = static_cast<long long>(y) + offset.y;
             
-
-            int maskX = static_cast<int>(x) + m_maskOffset.x;
-            int maskY = static_cast<int>(y) + m_maskOffset.y;
+            if (wrapped && opacity > 0) {
+                const std::size_t wrapY = static_cast<std::size_t>(wrapIndex(maskY, maskSize.y, mirror));
+                const std::uint8_t* maskRow = wrapPixels + wrapY * static_cast<std::size_t>(wrapWidth) * 4;
+                const std::uint8_t* coverageRow = wrapCoverage + wrapY * static_cast<std::size_t>(wrapWidth);
+                long long x = regionBegin;
+                long long wrapX = wrapIndex(x + offset.x, wrapWidth, false);
+                while (x < regionEnd) {
+                    const long long count = std::min(regionEnd - x, wrapWidth - wrapX);
+                    BlendMode::blendRow(sourceRow + x * 4, maskRow + wrapX * 4, coverageRow + wrapX,
+                                        resultRow + x * 4, static_cast<std::size_t>(count),
+                                        mode, opacity, m_linearLight, statistics);
+                    x += count;
+                    wrapX = 0;
+                }
+                continue;
+            }
+            
+            if (maskY < 0 || maskY >= static_cast<long long>(maskSize.y) || spanBegin == spanEnd || opacity == 0) {
+                std::memcpy(resultRow + regionBegin * 4, sourceRow + regionBegin * 4,
+                            static_cast<std::size_t>(regionEnd - regionBegin) * 4);
+                continue;
+            }
+            
+            const std::uint8_t* maskRow = mask + static_cast<std::size_t>(maskY) * maskSize.x * 4;
+            const std::uint8_t* coverageRow = coverage + static_cast<std::size_t>(maskY) * maskSize.x;
             
+            std::memcpy(resultRow + regionBegin * 4, sourceRow + regionBegin * 4,
+                        static_cast<std::size_t>(spanBegin - regionBegin) * 4);
+            BlendMode::blendRow(sourceRow + spanBegin * 4,
+                                maskRow + (spanBegin + offset.x) * 4,
+                                coverageRow + (spanBegin + offset.x),
+                                resultRow + spanBegin * 4,
+                                static_cast<std::size_t>(spanEnd - spanBegin),
+                                mode, opacity, m_linearLight, statistics);
+            std::memcpy(resultRow + spanEnd * 4, sourceRow + spanEnd * 4,
+                        static_cast<std::size_t>(regionEnd - spanEnd) * 4);
+        }
+    }, chunk);
+    
+    // Poza pikselami dotknietymi przez maske wynik jest zrodlem
+    m_pendingStatistics.reset();
+    if (m_collectStatistics) {
+        updateSourceStatistics();
+        m_pendingStatistics = m_sourceStatistics;
+        for (const BlendStatistics& statistics : partial) {
+            m_pendingStatistics->merge(statistics);
+        }
+    }
+    
+    if (Profiler::isEnabled()) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - blendStart;
+        Profiler::addSample(ProfileStage::Blend, elapsed.count());
+        Profiler::recordApply(static_cast<std::uint64_t>(sourceSize.x) * sourceSize.y, elapsed.count());
+    }
+    
+    // Historia zapisuje roznice wzgledem wyswietlanego wyniku; pierwszy wynik po wczytaniu
+    // zrodla rozni sie od zrodla tylko w obszarze maski
+    const std::optional<sf::IntRect> historyRegion = previous ? std::optional<sf::IntRect>(m_pendingRegion) : maskRect;
+    if (historyRegion) {
+        TraceScope history("recordHistory", "history");
+        m_history.record(previous ? m_frontResult.pixels->data() : source, result, sourceSize, *historyRegion,
+                         previous ? m_frontResult.maskRect : std::nullopt, maskRect, *m_threadPool);
+        history.addArg("bytes", static_cast<long long>(m_history.getBytes()));
+    }
+    
+    target.valid = true;
+    m_resultPending = true;
+    std::cout << "Zastosowano maskę w trybie: " << BlendMode::getModeName(mode) << std::endl;
+    return true;
+}
 
-            if (maskX >= 0 && maskX < static_cast<int>(maskSize.x) &&
-                maskY >= 0 && maskY < static_cast<int>(maskSize.y)) {
-                
-                sf::Color maskPixel = m_maskImage.getPixel(sf::Vector2u(
-                    static_cast<unsigned int>(maskX), 
-                    static_cast<unsigned int>(maskY)
-                ));
-                
-
-                sf::Color resultPixel = BlendMode::blend(
-                    sourcePixel, maskPixel, mode, transparentColor, useAlpha
-                );
-                
-                m_resultImage.setPixel(sf::Vector2u(x, y), resultPixel);
+void ImageProcessor::publishResult() {
+    if (!m_resultPending) {
+        return;
+    }
+    
+    m_resultPending = false;
+    std::swap(m_frontResult, m_backResult);
+    for (const auto& rect : m_pendingDirty.getRects()) {
+        m_resultDirty.add(rect);
+    }
+    m_lastApplyRegion = m_pendingRegion;
+    m_resultImageValid = false;
+    m_hasResult = true;
+    ++m_resultRevision;
+    m_statistics = std::move(m_pendingStatistics);
+    m_pendingStatistics.reset();
+    m_statisticsRevision = m_resultRevision;
+    updateResultTexture();
+    
+    if (!m_keepSourceImage) {
+        releaseSourceImage();
+    }
+}
+
+void ImageProcessor::updateKeyCoverage(const sf::Color& transparentColor, int tolerance, bool useAlpha) {
+    tolerance = BlendMode::clampTolerance(tolerance);
+    
+    // Klasyfikacja klucza zalezy tylko od maski i parametrow klucza - kolejne
+    // zastosowania z tymi samymi ustawieniami jej nie powtarzaja
+    if (m_keyCoverage.valid &&
+        m_keyCoverage.maskGeneration == m_maskGeneration &&
+        m_keyCoverage.key.r == transparentColor.r &&
+        m_keyCoverage.key.g == transparentColor.g &&
+        m_keyCoverage.key.b == transparentColor.b &&
+        m_keyCoverage.tolerance == tolerance &&
+        m_keyCoverage.softness == m_keySoftness &&
+        m_keyCoverage.despill == m_keyDespill &&
+        m_keyCoverage.feather == m_keyFeather &&
+        m_keyCoverage.useAlpha == useAlpha) {
+        return;
+    }
+    
+    TraceScope trace("classifyKey", "blend");
+    trace.addArg("softness", static_cast<long long>(m_keySoftness));
+    trace.addArg("feather", static_cast<long long>(m_keyFeather));
+    const sf::Image& maskImage = getActiveMask();
+    const sf::Vector2u maskSize = maskImage.getSize();
+    const std::uint8_t* mask = maskImage.getPixelsPtr();
+    m_keyCoverage.alpha.resize(static_cast<std::size_t>(maskSize.x) * maskSize.y);
+    std::uint8_t* coverage = m_keyCoverage.alpha.data();
+    
+    std::uint8_t* despilled = nullptr;
+    if (m_keyDespill) {
+        m_keyCoverage.despilled.resize(static_cast<std::size_t>(maskSize.x) * maskSize.y * 4);
+        despilled = m_keyCoverage.despilled.data();
+    } else {
+        std::vector<std::uint8_t>().swap(m_keyCoverage.despilled);
+    }
+    
+    // Twardy klucz - porownanie z tolerancja; miekki - krycie z odleglosci od klucza
+    // i opcjonalne odjecie koloru klucza w jednym przejsciu po masce
+    std::uint8_t ramp[256];
+    BlendMode::buildKeyRamp(tolerance, m_keySoftness, ramp);
+    const bool soft = m_keySoftness > 0 || despilled;
+    
+    m_threadPool->parallelFor(maskSize.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            if (soft) {
+                BlendMode::softKeyRow(mask + y * maskSize.x * 4, coverage + y * maskSize.x,
+                                      despilled ? despilled + y * maskSize.x * 4 : nullptr,
+                                      maskSize.x, transparentColor, ramp, useAlpha);
             } else {
+                BlendMode::classifyRow(mask + y * maskSize.x * 4, coverage + y * maskSize.x,
+                                       maskSize.x, transparentColor, tolerance, useAlpha);
+            }
+        }
+    });
+    
+    if (m_keyFeather > 0) {
+        featherKeyCoverage(m_keyFeather);
+    }
+    
+    m_keyCoverage.maskGeneration = m_maskGeneration;
+    m_keyCoverage.key = transparentColor;
+    m_keyCoverage.tolerance = tolerance;
+    m_keyCoverage.softness = m_keySoftness;
+    m_keyCoverage.despill = m_keyDespill;
+    m_keyCoverage.feather = m_keyFeather;
+    m_keyCoverage.useAlpha = useAlpha;
+    ++m_keyCoverage.revision;
+    m_keyCoverage.valid = true;
+}
+
+void ImageProcessor::updateWrappedMask() {
+    const sf::Vector2u maskSize = getActiveMask().getSize();
+    
+    // Szeroka maska powtarzana bez odbicia jest czytana wprost
+    if (m_maskWrap == MaskWrap::Repeat && maskSize.x >= MinWrapSpan) {
+        std::vector<std::uint8_t>().swap(m_wrappedMask.pixels);
+        std::vector<std::uint8_t>().swap(m_wrappedMask.alpha);
+        m_wrappedMask.valid = false;
+        return;
+    }
+    
+    if (m_wrappedMask.valid &&
+        m_wrappedMask.coverageRevision == m_keyCoverage.revision &&
+        m_wrappedMask.wrap == m_maskWrap) {
+        return;
+    }
+    
+    // Wiersz okresu (maska i jej odbicie) powielony do co najmniej MinWrapSpan pikseli
+    TraceScope trace("wrapMask", "blend");
+    const bool mirror = m_maskWrap == MaskWrap::Mirror;
+    const unsigned int width = maskSize.x;
+    const unsigned int period = mirror ? 2 * width : width;
+    const unsigned int copies = std::max(1u, (MinWrapSpan + period - 1) / period);
+    const std::size_t stripWidth = static_cast<std::size_t>(period) * copies;
+    m_wrappedMask.pixels.resize(stripWidth * maskSize.y * 4);
+    m_wrappedMask.alpha.resize(stripWidth * maskSize.y);
+    
+    const std::uint8_t* mask = m_keyCoverage.despill ? m_keyCoverage.despilled.data() : getActiveMask().getPixelsPtr();
+    const std::uint8_t* coverage = m_keyCoverage.alpha.data();
+    std::uint8_t* pixels = m_wrappedMask.pixels.data();
+    std::uint8_t* alpha = m_wrappedMask.alpha.data();
+    
+    m_threadPool->parallelFor(maskSize.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            const std::uint8_t* maskRow = mask + y * width * 4;
+            const std::uint8_t* coverageRow = coverage + y * width;
+            std::uint8_t* pixelRow = pixels + y * stripWidth * 4;
+            std::uint8_t* alphaRow = alpha + y * stripWidth;
+            
+            std::memcpy(pixelRow, maskRow, static_cast<std::size_t>(width) * 4);
+            std::memcpy(alphaRow, coverageRow, width);
+            if (mirror) {
+                for (unsigned int x = 0; x < width; ++x) {
+                    std::memcpy(pixelRow + (period - 1 - x) * 4, maskRow + x * 4, 4);
+                    alphaRow[period - 1 - x] = coverageRow[x];
+                }
+            }
+            for (unsigned int copy = 1; copy < copies; ++copy) {
+                std::memcpy(pixelRow + copy * period * 4, pixelRow, static_cast<std::size_t>(period) * 4);
+                std::memcpy(alphaRow + copy * period, alphaRow, period);
+            }
+        }
+    });
+    
+    m_wrappedMask.width = static_cast<unsigned int>(stripWidth);
+    m_wrappedMask.coverageRevision = m_keyCoverage.revision;
+    m_wrappedMask.wrap = m_maskWrap;
+    m_wrappedMask.valid = true;
+}
 
-                m_resultImage.setPixel(sf::Vector2u(x, y), sourcePixel);
+void ImageProcessor::updateSourceStatistics() {
+    if (m_sourceStatisticsGeneration == m_sourceGeneration) {
+        return;
+    }
+    
+    // Histogram zrodla liczony raz na obraz - kolejne zastosowania dodaja do niego tylko
+    // zmiany w pikselach dotknietych przez maske
+    TraceScope trace("sourceStatistics", "blend");
+    const sf::Vector2u size = m_sourceImage.getSize();
+    const std::size_t rowBytes = static_cast<std::size_t>(size.x) * 4;
+    const std::uint8_t* source = m_sourceImage.getPixelsPtr();
+    const std::size_t chunk = std::max<std::size_t>(1, size.y / (m_threadPool->getThreadCount() * 4));
+    std::vector<BlendStatistics> partial((size.y + chunk - 1) / chunk);
+    
+    m_threadPool->parallelFor(size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        auto& histogram = partial[rowBegin / chunk].histogram;
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            const std::uint8_t* row = source + y * rowBytes;
+            for (std::size_t x = 0; x < rowBytes; x += 4) {
+                ++histogram[0][row[x]];
+                ++histogram[1][row[x + 1]];
+                ++histogram[2][row[x + 2]];
+                ++histogram[3][row[x + 3]];
             }
         }
+    }, chunk);
+    
+    m_sourceStatistics.clear();
+    m_sourceStatistics.pixels = static_cast<long long>(size.x) * size.y;
+    for (const BlendStatistics& statistics : partial) {
+        m_sourceStatistics.merge(statistics);
     }
+    m_sourceStatisticsGeneration = m_sourceGeneration;
+}
+
+void ImageProcessor::featherKeyCoverage(int radius) {
+    TraceScope trace("featherKey", "blend");
+    const sf::Vector2u maskSize = getActiveMask().getSize();
+    const int width = static_cast<int>(maskSize.x);
+    const int height = static_cast<int>(maskSize.y);
+    const int window = 2 * radius + 1;
+    std::uint8_t* coverage = m_keyCoverage.alpha.data();
+    std::vector<std::uint8_t> blurred(m_keyCoverage.alpha.size());
     
-    m_hasResult = true;
-    updateResultTexture();
+    // Rozmycie pudelkowe rozdzielne: wiersze do bufora, potem kolumny z powrotem; krawedzie powielane.
+    // Wynik nie przekracza pierwotnego pokrycia - krawedz miekknie do wewnatrz, a piksele
+    // w kolorze klucza nie sa dolaczane
+    m_threadPool->parallelFor(maskSize.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            const std::uint8_t* in = coverage + y * maskSize.x;
+            std::uint8_t* out = blurred.data() + y * maskSize.x;
+            int sum = 0;
+            for (int i = -radius; i <= radius; ++i) {
+                sum += in[std::clamp(i, 0, width - 1)];
+            }
+            for (int x = 0; x < width; ++x) {
+                out[x] = static_cast<std::uint8_t>((sum + window / 2) / window);
+                sum += in[std::min(x + radius + 1, width - 1)] - in[std::max(x - radius, 0)];
+            }
+        }
+    });
     
-    std::cout << "Zastosowano maskę w trybie: " << BlendMode::getModeName(mode) << std::endl;
+    m_threadPool->parallelFor(maskSize.x, [&](std::size_t columnBegin, std::size_t columnEnd) {
+        const std::size_t columns = columnEnd - columnBegin;
+        std::vector<int> sums(columns, 0);
+        auto row = [&](int y) {
+            return blurred.data() + static_cast<std::size_t>(std::clamp(y, 0, height - 1)) * maskSize.x + columnBegin;
+        };
+        
+        for (int i = -radius; i <= radius; ++i) {
+            const std::uint8_t* in = row(i);
+            for (std::size_t x = 0; x < columns; ++x) {
+                sums[x] += in[x];
+            }
+        }
+        for (int y = 0; y < height; ++y) {
+            std::uint8_t* out = coverage + static_cast<std::size_t>(y) * maskSize.x + columnBegin;
+            const std::uint8_t* added = row(y + radius + 1);
+            const std::uint8_t* removed = row(y - radius);
+            for (std::size_t x = 0; x < columns; ++x) {
+                out[x] = std::min(out[x], static_cast<std::uint8_t>((sums[x] + window / 2) / window));
+                sums[x] += added[x] - removed[x];
+            }
+        }
+    }, 64);
+}
+
+void ImageProcessor::setSoftKey(int softness, bool despill, int feather) {
+    m_keySoftness = std::clamp(softness, 0, 255);
+    m_keyDespill = despill;
+    m_keyFeather = std::clamp(feather, 0, 64);
+}
+
+void ImageProcessor::setLinearLight(bool linear) {
+    m_linearLight = linear;
+}
+
+bool ImageProcessor::isLinearLight() const {
+    return m_linearLight;
+}
+
+void ImageProcessor::setMaskWrap(MaskWrap wrap) {
+    m_maskWrap = wrap;
+}
+
+MaskWrap ImageProcessor::getMaskWrap() const {
+    return m_maskWrap;
+}
+
+void ImageProcessor::setCollectStatistics(bool collect) {
+    m_collectStatistics = collect;
+}
+
+bool ImageProcessor::isCollectingStatistics() const {
+    return m_collectStatistics;
+}
+
+const BlendStatistics* ImageProcessor::getStatistics() const {
+    // Statystyki opisuja wynik, z ktorym zostaly policzone - po cofnieciu lub nowym zrodle ich nie ma
+    if (!m_hasResult || !m_statistics || m_statisticsRevision != m_resultRevision) {
+        return nullptr;
+    }
+    return &*m_statistics;
+}
+
+int ImageProcessor::getKeySoftness() const {
+    return m_keySoftness;
 }
 
 bool ImageProcessor::saveResult(const std::string& path) {
+    TraceScope trace("saveResult", "io");
+    trace.addArg("path", path);
+    
     if (!m_hasResult) {
         std::cerr << "Brak wyniku do zapisania!" << std::endl;
         return false;
     }
     
-    if (!m_resultImage.saveToFile(path)) {
+    if (!getResultImage().saveToFile(path)) {
         std::cerr << "Nie można zapisać wyniku do: " << path << std::endl;
         return false;
     }
     
+    // Kopia sf::Image jest potrzebna tylko do zapisu
+    m_resultImage = sf::Image();
+    m_resultImageValid = false;
+    
     std::cout << "Zapisano wynik do: " << path << std::endl;
     return true;
 }
@@ -125,12 +706,111 @@ void ImageProcessor::resetMaskOffset() {
     m_maskOffset = sf::Vector2i(0, 0);
 }
 
+bool ImageProcessor::alignMask(const sf::Color& transparentColor, int tolerance, std::atomic<int>* progress) {
+    if (!m_hasSource || !m_hasMask) {
+        std::cerr << "Brak obrazu źródłowego lub maski!" << std::endl;
+        return false;
+    }
+    
+    if (!ensureSourceImage()) {
+        return false;
+    }
+    
+    // Dopasowywana jest maska po transformacji - przesuniecie dotyczy jej
+    const std::optional<AlignResult> result =
+        MaskAligner::align(m_sourceImage, getActiveMask(), transparentColor, tolerance, *m_threadPool, progress);
+    if (!result) {
+        std::cerr << "Nie można dopasować położenia maski do obrazu" << std::endl;
+        return false;
+    }
+    
+    m_maskOffset = result->offset;
+    std::cout << "Dopasowano położenie maski: " << m_maskOffset.x << "," << m_maskOffset.y
+              << " (zgodność " << result->score << ")" << std::endl;
+    return true;
+}
+
+bool ImageProcessor::setMaskTransform(const MaskTransform& transform, const sf::Color& fill) {
+    MaskTransform clamped = transform;
+    clamped.scale = std::clamp(transform.scale, 0.01f, 16.0f);
+    
+    // Kolor wypelnienia ma znaczenie tylko dla obroconej maski
+    bool fillChanged = clamped.rotation != 0.0f && fill != m_maskFill;
+    if (!m_hasMask || (clamped == m_maskTransform && !fillChanged)) {
+        return false;
+    }
+    
+    m_maskTransform = clamped;
+    m_maskFill = fill;
+    if (!rebuildTransformedMask()) {
+        m_maskTransform = MaskTransform();
+        m_transformedMask = sf::Image();
+    }
+    
+    ++m_maskGeneration;
+    updateMaskTexture();
+    
+    if (m_keyCoverage.valid) {
+        updateKeyCoverage(m_keyCoverage.key, m_keyCoverage.tolerance, m_keyCoverage.useAlpha);
+    }
+    
+    return true;
+}
+
+MaskTransform ImageProcessor::getMaskTransform() const {
+    return m_maskTransform;
+}
+
+bool ImageProcessor::rebuildTransformedMask() {
+    if (m_maskTransform.isIdentity()) {
+        m_transformedMask = sf::Image();
+        return true;
+    }
+    
+    TraceScope trace("transformMask", "blend");
+    const sf::Image* source = &m_maskImage;
+    MaskTransform transform = m_maskTransform;
+    sf::Image reduced;
+    
+    // Pomniejszenie filtrem obszarowym usrednia wszystkie piksele zrodla; obrot
+    // wykonywany jest potem na pomniejszonej masce juz bez zmiany skali
+    if (transform.filter == ResampleFilter::Area && transform.scale < 1.0f) {
+        reduced = ImageResampler::resizeArea(m_maskImage, ImageResampler::transformedSize(m_maskImage.getSize(), transform));
+        if (transform.rotation == 0.0f) {
+            m_transformedMask = std::move(reduced);
+            return true;
+        }
+        source = &reduced;
+        transform.scale = 1.0f;
+        transform.filter = ResampleFilter::Bilinear;
+    }
+    
+    const sf::Vector2u sourceSize = source->getSize();
+    const sf::Vector2u size = ImageResampler::transformedSize(sourceSize, transform);
+    if (size.x > 32768 || size.y > 32768) {
+        std::cerr << "Przekształcona maska jest zbyt duża: " << size.x << "x" << size.y << std::endl;
+        return false;
+    }
+    
+    trace.addArg("width", size.x);
+    trace.addArg("height", size.y);
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+    const std::uint8_t* sourcePixels = source->getPixelsPtr();
+    m_threadPool->parallelFor(size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        ImageResampler::transformRows(sourcePixels, sourceSize, pixels.data(), size, transform, m_maskFill,
+                                      static_cast<unsigned int>(rowBegin), static_cast<unsigned int>(rowEnd));
+    });
+    
+    m_transformedMask = sf::Image(size, pixels.data());
+    return true;
+}
+
 sf::Vector2u ImageProcessor::getSourceSize() const {
-    return m_hasSource ? m_sourceImage.getSize() : sf::Vector2u(0, 0);
+    return m_hasSource ? m_sourceSize : sf::Vector2u(0, 0);
 }
 
 sf::Vector2u ImageProcessor::getMaskSize() const {
-    return m_hasMask ? m_maskImage.getSize() : sf::Vector2u(0, 0);
+    return m_hasMask ? getActiveMask().getSize() : sf::Vector2u(0, 0);
 }
 
 bool ImageProcessor::hasSourceImage() const {
@@ -153,33 +833,316 @@ const sf::Texture& ImageProcessor::getResultTexture() const {
     return m_resultTexture;
 }
 
+const sf::Image& ImageProcessor::getSourceImage() const {
+    return m_sourceImage;
+}
+
+const sf::Image& ImageProcessor::getMaskImage() const {
+    return getActiveMask();
+}
+
+const sf::Image& ImageProcessor::getOriginalMaskImage() const {
+    return m_maskImage;
+}
+
+const sf::Image& ImageProcessor::getActiveMask() const {
+    return m_maskTransform.isIdentity() ? m_maskImage : m_transformedMask;
+}
+
+const std::uint8_t* ImageProcessor::getResultPixels() const {
+    return m_frontResult.pixels ? m_frontResult.pixels->data() : nullptr;
+}
+
+sf::IntRect ImageProcessor::getLastApplyRegion() const {
+    return m_lastApplyRegion;
+}
+
+bool ImageProcessor::fitsInTexture(const sf::Vector2u& size) {
+    unsigned int maximum = sf::Texture::getMaximumSize();
+    return size.x <= maximum && size.y <= maximum;
+}
+
+std::uint64_t ImageProcessor::getSourceGeneration() const {
+    return m_sourceGeneration;
+}
+
+std::uint64_t ImageProcessor::getMaskGeneration() const {
+    return m_maskGeneration;
+}
+
+std::uint64_t ImageProcessor::getOriginalMaskGeneration() const {
+    return m_originalMaskGeneration;
+}
+
+std::uint64_t ImageProcessor::getResultGeneration() const {
+    return m_resultGeneration;
+}
+
+std::uint64_t ImageProcessor::getResultRevision() const {
+    return m_resultRevision;
+}
+
 bool ImageProcessor::hasResult() const {
     return m_hasResult;
 }
 
 const sf::Image& ImageProcessor::getResultImage() const {
+    if (m_hasResult && !m_resultImageValid) {
+        m_resultImage.resize(m_frontResult.size, m_frontResult.pixels->data());
+        m_resultImageValid = true;
+    }
     return m_resultImage;
 }
 
+bool ImageProcessor::undo() {
+    return stepHistory(false);
+}
+
+bool ImageProcessor::redo() {
+    return stepHistory(true);
+}
+
+bool ImageProcessor::stepHistory(bool forward) {
+    if (!m_frontResult.valid || !(forward ? m_history.canRedo() : m_history.canUndo())) {
+        return false;
+    }
+    
+    TraceScope trace(forward ? "redo" : "undo", "history");
+    
+    // Przywracane sa tylko zmienione kafelki; bufor tylny i jego obszar maski zostaja bez zmian
+    DirtyRegion changed;
+    std::optional<sf::IntRect> maskRect;
+    std::uint8_t* pixels = m_frontResult.pixels->data();
+    if (forward) {
+        m_history.redo(pixels, changed, maskRect, *m_threadPool);
+    } else {
+        m_history.undo(pixels, changed, maskRect, *m_threadPool);
+    }
+    
+    m_frontResult.maskRect = maskRect;
+    for (const auto& rect : changed.getRects()) {
+        m_resultDirty.add(rect);
+    }
+    m_lastApplyRegion = changed.getBounds().value_or(sf::IntRect());
+    trace.addArg("regionWidth", m_lastApplyRegion.size.x);
+    trace.addArg("regionHeight", m_lastApplyRegion.size.y);
+    
+    m_resultImageValid = false;
+    m_hasResult = true;
+    ++m_resultRevision;
+    updateResultTexture();
+    return true;
+}
+
+bool ImageProcessor::canUndo() const {
+    return m_frontResult.valid && m_history.canUndo();
+}
+
+bool ImageProcessor::canRedo() const {
+    return m_frontResult.valid && m_history.canRedo();
+}
+
+void ImageProcessor::closeHistoryStep() {
+    m_history.closeStep();
+}
+
+void ImageProcessor::setHistoryBudget(std::size_t bytes) {
+    m_history.setBudget(bytes);
+}
+
+std::size_t ImageProcessor::getHistoryBytes() const {
+    return m_history.getBytes();
+}
+
+void ImageProcessor::setThreadCount(unsigned int count) {
+    if (count == 0) {
+        count = ThreadPool::getHardwareThreadCount();
+    }
+    if (count != m_threadPool->getThreadCount()) {
+        m_threadPool = std::make_unique<ThreadPool>(count);
+    }
+}
+
+unsigned int ImageProcessor::getThreadCount() const {
+    return m_threadPool->getThreadCount();
+}
+
+void ImageProcessor::setTexturesEnabled(bool enabled) {
+    m_texturesEnabled = enabled;
+    syncTextures();
+}
+
 void ImageProcessor::updateSourceTexture() {
-    if (m_hasSource) {
+    m_sourceTextureValid = false;
+    syncTextures();
+}
+
+void ImageProcessor::updateMaskTexture() {
+    m_maskTextureValid = false;
+    syncTextures();
+}
+
+void ImageProcessor::syncTextures() {
+    if (!m_texturesEnabled) {
+        return;
+    }
+    
+    // Tekstury powstaja dopiero, gdy widok ich potrzebuje
+    if (m_sourceTextureVisible && m_hasSource && !m_sourceTextureValid &&
+        fitsInTexture(m_sourceSize) && ensureSourceImage()) {
+        ProfileScope scope(ProfileStage::Upload);
+        Profiler::addCount(ProfileCounter::UploadBytes, static_cast<std::uint64_t>(m_sourceSize.x) * m_sourceSize.y * 4);
         (void)m_sourceTexture.loadFromImage(m_sourceImage);
         m_sourceTexture.setSmooth(true);
+        m_sourceTextureValid = true;
+    }
+    
+    const sf::Image& maskImage = getActiveMask();
+    if (m_maskTextureVisible && m_hasMask && !m_maskTextureValid && fitsInTexture(maskImage.getSize())) {
+        ProfileScope scope(ProfileStage::Upload);
+        Profiler::addCount(ProfileCounter::UploadBytes, static_cast<std::uint64_t>(maskImage.getSize().x) * maskImage.getSize().y * 4);
+        (void)m_maskTexture.loadFromImage(maskImage);
+        m_maskTexture.setSmooth(true);
+        m_maskTextureValid = true;
+    }
+    
+    updateResultTexture();
+    releaseIdleTextures();
+}
+
+void ImageProcessor::releaseIdleTextures() {
+    auto textureBytes = [](const sf::Texture& texture) {
+        return static_cast<std::size_t>(texture.getSize().x) * texture.getSize().y * 4;
+    };
+    
+    // Niewidoczne tekstury zostaja, dopoki mieszcza sie w budzecie
+    if (getTextureBytes() > m_textureBudget && !m_maskTextureVisible && textureBytes(m_maskTexture) > 0) {
+        m_maskTexture = sf::Texture();
+        m_maskTextureValid = false;
+    }
+    if (getTextureBytes() > m_textureBudget && !m_sourceTextureVisible && textureBytes(m_sourceTexture) > 0) {
+        m_sourceTexture = sf::Texture();
+        m_sourceTextureValid = false;
+    }
+    if (getTextureBytes() > m_textureBudget && !m_resultTextureVisible && textureBytes(m_resultTexture) > 0) {
+        m_resultTexture = sf::Texture();
+        m_resultDirty.clear();
     }
 }
 
-void ImageProcessor::updateMaskTexture() {
-    if (m_hasMask) {
-        (void)m_maskTexture.loadFromImage(m_maskImage);
-        m_maskTexture.setSmooth(true);
+bool ImageProcessor::ensureSourceImage() {
+    if (!m_sourceReleased) {
+        return true;
+    }
+    
+    TraceScope trace("reloadSourceImage", "io");
+    bool loaded;
+    {
+        ProfileScope scope(ProfileStage::Decode);
+        loaded = m_sourceImage.loadFromFile(m_sourcePath);
+    }
+    
+    if (!loaded || m_sourceImage.getSize() != m_sourceSize) {
+        std::cerr << "Nie można ponownie wczytać obrazu źródłowego: " << m_sourcePath << std::endl;
+        return false;
+    }
+    
+    m_sourceReleased = false;
+    return true;
+}
+
+void ImageProcessor::releaseSourceImage() {
+    // Tylko obraz z pliku mozna odtworzyc przy kolejnym uzyciu
+    if (m_sourceReleased || m_sourcePath.empty()) {
+        return;
+    }
+    
+    m_sourceImage = sf::Image();
+    m_sourceReleased = true;
+}
+
+void ImageProcessor::setVisibleTextures(bool source, bool mask, bool result) {
+    if (source == m_sourceTextureVisible && mask == m_maskTextureVisible && result == m_resultTextureVisible) {
+        return;
+    }
+    
+    m_sourceTextureVisible = source;
+    m_maskTextureVisible = mask;
+    m_resultTextureVisible = result;
+    syncTextures();
+}
+
+void ImageProcessor::setTextureBudget(std::size_t bytes) {
+    m_textureBudget = bytes;
+    releaseIdleTextures();
+}
+
+std::size_t ImageProcessor::getTextureBytes() const {
+    std::size_t bytes = 0;
+    for (const sf::Texture* texture : {&m_sourceTexture, &m_maskTexture, &m_resultTexture}) {
+        bytes += static_cast<std::size_t>(texture->getSize().x) * texture->getSize().y * 4;
+    }
+    return bytes;
+}
+
+void ImageProcessor::setKeepSourceImage(bool keep) {
+    m_keepSourceImage = keep;
+    if (keep) {
+        ensureSourceImage();
     }
 }
 
 void ImageProcessor::updateResultTexture() {
-    if (m_hasResult) {
-        (void)m_resultTexture.loadFromImage(m_resultImage);
+    if (!m_hasResult || !m_texturesEnabled || !m_resultTextureVisible) {
+        return;
+    }
+    
+    // Zbyt duzy wynik jest wyswietlany kafelkami (TilePyramid) prosto z bufora pikseli
+    if (!fitsInTexture(m_frontResult.size)) {
+        m_resultDirty.clear();
+        return;
+    }
+    
+    TraceScope trace("updateResultTexture", "gpu");
+    ProfileScope scope(ProfileStage::Upload);
+    
+    if (m_resultTexture.getSize() != m_frontResult.size) {
+        if (!m_resultTexture.resize(m_frontResult.size)) {
+            std::cerr << "Nie można utworzyć tekstury wyniku!" << std::endl;
+            return;
+        }
         m_resultTexture.setSmooth(true);
+        m_resultDirty.addAll(m_frontResult.size);
+        ++m_resultGeneration;
+    }
+    
+    trace.addArg("bytes", m_resultDirty.getArea() * 4);
+    trace.addArg("rects", static_cast<long long>(m_resultDirty.getRects().size()));
+    Profiler::addCount(ProfileCounter::UploadBytes, static_cast<std::uint64_t>(m_resultDirty.getArea()) * 4);
+    
+    for (const auto& rect : m_resultDirty.getRects()) {
+        uploadResultRect(rect);
+    }
+    m_resultDirty.clear();
+}
+
+void ImageProcessor::uploadResultRect(const sf::IntRect& rect) {
+    const std::size_t rowBytes = static_cast<std::size_t>(m_frontResult.size.x) * 4;
+    const std::size_t rectRowBytes = static_cast<std::size_t>(rect.size.x) * 4;
+    const std::uint8_t* first = m_frontResult.pixels->data() + static_cast<std::size_t>(rect.position.y) * rowBytes
+                                                      + static_cast<std::size_t>(rect.position.x) * 4;
+    
+    // Pełne wiersze leżą w pamięci ciągiem, węższe prostokąty trzeba spakować
+    if (rectRowBytes == rowBytes) {
+        m_resultTexture.update(first, sf::Vector2u(rect.size), sf::Vector2u(rect.position));
+        return;
+    }
+    
+    m_uploadBuffer.resize(rectRowBytes * static_cast<std::size_t>(rect.size.y));
+    for (int row = 0; row < rect.size.y; ++row) {
+        std::memcpy(m_uploadBuffer.data() + row * rectRowBytes, first + row * rowBytes, rectRowBytes);
     }
+    m_resultTexture.update(m_uploadBuffer.data(), sf::Vector2u(rect.size), sf::Vector2u(rect.position));
 }
 
 }
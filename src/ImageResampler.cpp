@@ -0,0 +1,240 @@
+#include "ImageResampler.h"
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <optional>
+
+namespace MaskOverlay {
+
+bool MaskTransform::isIdentity() const {
+    return scale == 1.0f && rotation == 0.0f;
+}
+
+bool MaskTransform::operator==(const MaskTransform& other) const {
+    return scale == other.scale && rotation == other.rotation && filter == other.filter;
+}
+
+bool MaskTransform::operator!=(const MaskTransform& other) const {
+    return !(*this == other);
+}
+
+sf::Image ImageResampler::resizeArea(const sf::Image& image, const sf::Vector2u& size) {
+    sf::Vector2u sourceSize = image.getSize();
+    if (size == sourceSize || size.x == 0 || size.y == 0 || sourceSize.x == 0 || sourceSize.y == 0) {
+        return image;
+    }
+
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+    resizeArea(image.getPixelsPtr(), sourceSize, pixels.data(), size, sf::IntRect({0, 0}, sf::Vector2i(size)));
+    return sf::Image(size, pixels.data());
+}
+
+void ImageResampler::resizeArea(const std::uint8_t* source, const sf::Vector2u& sourceSize,
+                                std::uint8_t* target, const sf::Vector2u& size, const sf::IntRect& region) {
+    std::optional<sf::IntRect> clipped = region.findIntersection(sf::IntRect({0, 0}, sf::Vector2i(size)));
+    if (!clipped || sourceSize.x == 0 || sourceSize.y == 0) {
+        return;
+    }
+
+    const unsigned int left = static_cast<unsigned int>(clipped->position.x);
+    const unsigned int top = static_cast<unsigned int>(clipped->position.y);
+    const unsigned int width = static_cast<unsigned int>(clipped->size.x);
+    const unsigned int height = static_cast<unsigned int>(clipped->size.y);
+
+    // Granice kolumn zrodla dla kazdej kolumny wyniku; przy powiekszaniu co najmniej jedna kolumna
+    std::vector<unsigned int> columnBegin(width);
+    std::vector<unsigned int> columnEnd(width);
+    for (unsigned int i = 0; i < width; ++i) {
+        unsigned int x = left + i;
+        columnBegin[i] = static_cast<unsigned int>(static_cast<std::uint64_t>(x) * sourceSize.x / size.x);
+        columnEnd[i] = std::max(columnBegin[i] + 1,
+            static_cast<unsigned int>(static_cast<std::uint64_t>(x + 1) * sourceSize.x / size.x));
+    }
+
+    std::vector<std::uint32_t> sums(static_cast<std::size_t>(width) * 4);
+
+    for (unsigned int y = top; y < top + height; ++y) {
+        unsigned int rowBegin = static_cast<unsigned int>(static_cast<std::uint64_t>(y) * sourceSize.y / size.y);
+        unsigned int rowEnd = std::max(rowBegin + 1,
+            static_cast<unsigned int>(static_cast<std::uint64_t>(y + 1) * sourceSize.y / size.y));
+
+        std::fill(sums.begin(), sums.end(), 0);
+        for (unsigned int sy = rowBegin; sy < rowEnd; ++sy) {
+            const std::uint8_t* row = source + static_cast<std::size_t>(sy) * sourceSize.x * 4;
+            for (unsigned int i = 0; i < width; ++i) {
+                std::uint32_t* sum = &sums[static_cast<std::size_t>(i) * 4];
+                for (unsigned int sx = columnBegin[i]; sx < columnEnd[i]; ++sx) {
+                    const std::uint8_t* p = row + static_cast<std::size_t>(sx) * 4;
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                    sum[3] += p[3];
+                }
+            }
+        }
+
+        std::uint8_t* out = target + (static_cast<std::size_t>(y) * size.x + left) * 4;
+        for (unsigned int i = 0; i < width; ++i) {
+            std::uint32_t count = (rowEnd - rowBegin) * (columnEnd[i] - columnBegin[i]);
+            for (int c = 0; c < 4; ++c) {
+                out[i * 4 + c] = static_cast<std::uint8_t>((sums[static_cast<std::size_t>(i) * 4 + c] + count / 2) / count);
+            }
+        }
+    }
+}
+
+sf::IntRect ImageResampler::mapRegion(const sf::IntRect& rect, const sf::Vector2u& sourceSize, const sf::Vector2u& size) {
+    if (sourceSize.x == 0 || sourceSize.y == 0) {
+        return sf::IntRect();
+    }
+
+    // Piksele wyniku, ktorych obszar zrodla moze przecinac prostokat (z zapasem na zaokraglenia)
+    auto scaleDown = [](int value, unsigned int from, unsigned int to) {
+        return static_cast<int>(static_cast<std::int64_t>(value) * to / from) - 1;
+    };
+    auto scaleUp = [](int value, unsigned int from, unsigned int to) {
+        return static_cast<int>((static_cast<std::int64_t>(value) * to + from - 1) / from) + 1;
+    };
+
+    int left = std::max(0, scaleDown(rect.position.x, sourceSize.x, size.x));
+    int top = std::max(0, scaleDown(rect.position.y, sourceSize.y, size.y));
+    int right = std::min(static_cast<int>(size.x), scaleUp(rect.position.x + rect.size.x, sourceSize.x, size.x));
+    int bottom = std::min(static_cast<int>(size.y), scaleUp(rect.position.y + rect.size.y, sourceSize.y, size.y));
+    if (right <= left || bottom <= top) {
+        return sf::IntRect();
+    }
+    return sf::IntRect({left, top}, {right - left, bottom - top});
+}
+
+sf::Image ImageResampler::resizeNearest(const sf::Image& image, const sf::Vector2u& size) {
+    sf::Vector2u sourceSize = image.getSize();
+    if (size == sourceSize || size.x == 0 || size.y == 0 || sourceSize.x == 0 || sourceSize.y == 0) {
+        return image;
+    }
+
+    // Probka ze srodka obszaru zrodla odpowiadajacego pikselowi wyniku
+    std::vector<unsigned int> columns(size.x);
+    for (unsigned int x = 0; x < size.x; ++x) {
+        columns[x] = static_cast<unsigned int>((static_cast<std::uint64_t>(2 * x + 1) * sourceSize.x) / (2ull * size.x));
+    }
+
+    const std::uint8_t* source = image.getPixelsPtr();
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+
+    for (unsigned int y = 0; y < size.y; ++y) {
+        unsigned int sy = static_cast<unsigned int>((static_cast<std::uint64_t>(2 * y + 1) * sourceSize.y) / (2ull * size.y));
+        const std::uint8_t* row = source + static_cast<std::size_t>(sy) * sourceSize.x * 4;
+        std::uint8_t* out = &pixels[static_cast<std::size_t>(y) * size.x * 4];
+        for (unsigned int x = 0; x < size.x; ++x) {
+            const std::uint8_t* p = row + static_cast<std::size_t>(columns[x]) * 4;
+            out[x * 4 + 0] = p[0];
+            out[x * 4 + 1] = p[1];
+            out[x * 4 + 2] = p[2];
+            out[x * 4 + 3] = p[3];
+        }
+    }
+
+    return sf::Image(size, pixels.data());
+}
+
+sf::Vector2u ImageResampler::transformedSize(const sf::Vector2u& size, const MaskTransform& transform) {
+    double width = size.x;
+    double height = size.y;
+    double scale = transform.scale;
+
+    // Filtr obszarowy najpierw pomniejsza maske, obrot dziala juz na pomniejszonej
+    if (transform.filter == ResampleFilter::Area && scale < 1.0) {
+        width = std::max(1.0, std::round(width * scale));
+        height = std::max(1.0, std::round(height * scale));
+        scale = 1.0;
+    }
+
+    if (transform.rotation == 0.0f) {
+        return sf::Vector2u(
+            static_cast<unsigned int>(std::max(1.0, std::round(width * scale))),
+            static_cast<unsigned int>(std::max(1.0, std::round(height * scale))));
+    }
+
+    const double radians = transform.rotation * 3.14159265358979323846 / 180.0;
+    const double cosA = std::abs(std::cos(radians));
+    const double sinA = std::abs(std::sin(radians));
+    return sf::Vector2u(
+        static_cast<unsigned int>(std::max(1.0, std::round((width * cosA + height * sinA) * scale))),
+        static_cast<unsigned int>(std::max(1.0, std::round((width * sinA + height * cosA) * scale))));
+}
+
+void ImageResampler::transformRows(const std::uint8_t* source, const sf::Vector2u& sourceSize,
+                                   std::uint8_t* target, const sf::Vector2u& size,
+                                   const MaskTransform& transform, const sf::Color& fill,
+                                   unsigned int rowBegin, unsigned int rowEnd) {
+    const bool bilinear = transform.filter != ResampleFilter::Nearest;
+    const std::uint8_t fillPixel[4] = {fill.r, fill.g, fill.b, fill.a};
+    const long long width = sourceSize.x;
+    const long long height = sourceSize.y;
+
+    // Odwzorowanie odwrotne: srodek piksela wyniku -> punkt zrodla, w stalym przecinku 16.16;
+    // wzdluz wiersza punkt zrodla przesuwa sie o staly krok
+    const double radians = transform.rotation * 3.14159265358979323846 / 180.0;
+    const double cosA = std::cos(radians) / transform.scale;
+    const double sinA = std::sin(radians) / transform.scale;
+    // Dla dwuliniowego polowa kroku wagi (128 / 65536) wiecej: wagi 8-bitowe sa zaokraglane, nie obcinane
+    const double bias = bilinear ? 0.5 - 128.0 / 65536.0 : 0.0;
+    const long long stepU = std::llround(cosA * 65536.0);
+    const long long stepV = std::llround(-sinA * 65536.0);
+    const double firstX = 0.5 - size.x / 2.0;
+
+    // Poza maska probkowany jest kolor wypelnienia, wiec krawedz obroconej maski przechodzi w niego plynnie
+    auto pixel = [&](long long x, long long y) -> const std::uint8_t* {
+        if (x < 0 || y < 0 || x >= width || y >= height) {
+            return fillPixel;
+        }
+        return source + (static_cast<std::size_t>(y) * sourceSize.x + static_cast<std::size_t>(x)) * 4;
+    };
+
+    for (unsigned int y = rowBegin; y < rowEnd; ++y) {
+        const double dy = y + 0.5 - size.y / 2.0;
+        long long u = std::llround((sourceSize.x / 2.0 + cosA * firstX + sinA * dy - bias) * 65536.0);
+        long long v = std::llround((sourceSize.y / 2.0 - sinA * firstX + cosA * dy - bias) * 65536.0);
+        std::uint8_t* out = target + static_cast<std::size_t>(y) * size.x * 4;
+
+        for (unsigned int x = 0; x < size.x; ++x, u += stepU, v += stepV, out += 4) {
+            const long long sx = u >> 16;
+            const long long sy = v >> 16;
+
+            if (!bilinear) {
+                const std::uint8_t* p = pixel(sx, sy);
+                out[0] = p[0];
+                out[1] = p[1];
+                out[2] = p[2];
+                out[3] = p[3];
+                continue;
+            }
+
+            const std::uint32_t wx = static_cast<std::uint32_t>((u >> 8) & 255);
+            const std::uint32_t wy = static_cast<std::uint32_t>((v >> 8) & 255);
+            const std::uint8_t* p00 = pixel(sx, sy);
+            const std::uint8_t* p10 = pixel(sx + 1, sy);
+            const std::uint8_t* p01 = pixel(sx, sy + 1);
+            const std::uint8_t* p11 = pixel(sx + 1, sy + 1);
+            for (int c = 0; c < 4; ++c) {
+                std::uint32_t top = p00[c] * (256 - wx) + p10[c] * wx;
+                std::uint32_t bottom = p01[c] * (256 - wx) + p11[c] * wx;
+                out[c] = static_cast<std::uint8_t>((top * (256 - wy) + bottom * wy + 32768) >> 16);
+            }
+        }
+    }
+}
+
+sf::Vector2u ImageResampler::fitSize(const sf::Vector2u& size, const sf::Vector2f& bounds) {
+    if (size.x == 0 || size.y == 0) {
+        return size;
+    }
+
+    float scale = std::min(bounds.x / size.x, bounds.y / size.y);
+    return sf::Vector2u(
+        std::max(1u, static_cast<unsigned int>(std::lround(size.x * scale))),
+        std::max(1u, static_cast<unsigned int>(std::lround(size.y * scale))));
+}
+
+}
@@ -0,0 +1,613 @@
+#include "MaskAligner.h"
+#include "BlendMode.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace MaskOverlay {
+
+namespace {
+
+using Complex = std::complex<float>;
+
+std::size_t nextPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Wspolczynniki exp(-2*pi*i*k/count) dla k < count/2, sprzezone dla transformaty odwrotnej
+std::vector<Complex> twiddles(std::size_t count, bool inverse) {
+    std::vector<Complex> table(count / 2);
+    const double step = (inverse ? 2.0 : -2.0) * 3.14159265358979323846 / static_cast<double>(count);
+    for (std::size_t k = 0; k < table.size(); ++k) {
+        table[k] = Complex(static_cast<float>(std::cos(step * k)), static_cast<float>(std::sin(step * k)));
+    }
+    return table;
+}
+
+// Radix-2 w miejscu: permutacja odwrocenia bitow, potem motylki kolejnych rzedow
+void transform(Complex* data, std::size_t count, const std::vector<Complex>& table) {
+    for (std::size_t i = 1, j = 0; i < count; ++i) {
+        std::size_t bit = count >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (std::size_t length = 2; length <= count; length <<= 1) {
+        const std::size_t half = length / 2;
+        const std::size_t stride = count / length;
+        for (std::size_t begin = 0; begin < count; begin += length) {
+            for (std::size_t k = 0; k < half; ++k) {
+                const Complex odd = data[begin + k + half] * table[k * stride];
+                data[begin + k + half] = data[begin + k] - odd;
+                data[begin + k] += odd;
+            }
+        }
+    }
+}
+
+int luma(const std::uint8_t* pixel) {
+    return (77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8;
+}
+
+// Przedzial zrodla korelowany jedna transformata i polozenia maski, za ktore odpowiada
+struct TileSpan {
+    int begin;
+    int end;
+    int ownBegin;
+    int ownEnd;
+};
+
+// Podzial jednej osi: calosc, gdy transformata miesci sie w MaxTransformSize, inaczej kafelki
+// z zakladka maska-1 (overlap-save). Kafelek odpowiada tylko za polozenia, w ktorych maska
+// nie wychodzi poza niego (pierwszy i ostatni takze za te czesciowo poza zrodlem), wiec sumy
+// na czesci wspolnej sa takie jak przy jednej transformacie calego zrodla
+std::vector<TileSpan> tileSpans(unsigned int source, unsigned int mask) {
+    const int sourceSize = static_cast<int>(source);
+    const int maskSize = static_cast<int>(mask);
+    const std::size_t whole = nextPowerOfTwo(static_cast<std::size_t>(source) + mask);
+    const std::size_t tile = std::max<std::size_t>(MaskAligner::TileSize, nextPowerOfTwo(static_cast<std::size_t>(mask) * 8));
+    if (whole <= MaskAligner::MaxTransformSize || tile >= whole) {
+        return {{0, sourceSize, 1 - maskSize, sourceSize}};
+    }
+
+    const int extent = static_cast<int>(tile) - maskSize;
+    const int step = extent - maskSize + 1;
+    std::vector<TileSpan> spans;
+    for (int begin = 0;; begin += step) {
+        const bool last = begin + extent >= sourceSize;
+        spans.push_back({begin, std::min(begin + extent, sourceSize), begin == 0 ? 1 - maskSize : begin,
+                         last ? sourceSize : begin + step});
+        if (last) {
+            return spans;
+        }
+    }
+}
+
+}
+
+void MaskAligner::fft2D(std::vector<Complex>& data, const sf::Vector2u& size, bool inverse, ThreadPool& pool) {
+    const std::vector<Complex> rowTable = twiddles(size.x, inverse);
+    const std::vector<Complex> columnTable = twiddles(size.y, inverse);
+
+    pool.parallelFor(size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            transform(data.data() + y * size.x, size.x, rowTable);
+        }
+    });
+
+    // Kolumny przez bufor - kilka naraz, zeby odczyt wierszy byl ciagly
+    constexpr std::size_t Batch = 8;
+    pool.parallelFor((size.x + Batch - 1) / Batch, [&](std::size_t batchBegin, std::size_t batchEnd) {
+        std::vector<Complex> columns(Batch * size.y);
+        for (std::size_t batch = batchBegin; batch < batchEnd; ++batch) {
+            const std::size_t x0 = batch * Batch;
+            const std::size_t width = std::min<std::size_t>(Batch, size.x - x0);
+            for (std::size_t y = 0; y < size.y; ++y) {
+                for (std::size_t i = 0; i < width; ++i) {
+                    columns[i * size.y + y] = data[y * size.x + x0 + i];
+                }
+            }
+            for (std::size_t i = 0; i < width; ++i) {
+                transform(columns.data() + i * size.y, size.y, columnTable);
+            }
+            for (std::size_t y = 0; y < size.y; ++y) {
+                for (std::size_t i = 0; i < width; ++i) {
+                    data[y * size.x + x0 + i] = columns[i * size.y + y];
+                }
+            }
+        }
+    });
+
+    if (inverse) {
+        const float scale = 1.0f / (static_cast<float>(size.x) * static_cast<float>(size.y));
+        for (Complex& value : data) {
+            value *= scale;
+        }
+    }
+}
+
+std::optional<AlignResult> MaskAligner::align(const sf::Image& source,
+                                              const sf::Image& mask,
+                                              const sf::Color& transparentColor,
+                                              int tolerance,
+                                              ThreadPool& pool,
+                                              std::atomic<int>* progress) {
+    const sf::Vector2u sourceSize = source.getSize();
+    const sf::Vector2u maskSize = mask.getSize();
+    if (sourceSize.x == 0 || sourceSize.y == 0 || maskSize.x == 0 || maskSize.y == 0) {
+        return std::nullopt;
+    }
+
+    TraceScope trace("alignMask", "align");
+
+    // Najgrubszy poziom piramidy: wieksze z obrazow ok. CoarseSize pikseli, ale maska
+    // nie mniejsza niz MinCoarseMask - inaczej korelacja nie ma na czym sie oprzec
+    const unsigned int largest = std::max({sourceSize.x, sourceSize.y, maskSize.x, maskSize.y});
+    const unsigned int smallestMask = std::min(maskSize.x, maskSize.y);
+    unsigned int levels = 0;
+    while ((largest >> levels) > CoarseSize && (smallestMask >> (levels + 1)) >= MinCoarseMask &&
+           (std::min(sourceSize.x, sourceSize.y) >> (levels + 1)) > 0) {
+        ++levels;
+    }
+    trace.addArg("levels", static_cast<long long>(levels));
+
+    auto levelRect = [](const sf::Vector2u& size, unsigned int level) {
+        return sf::IntRect({0, 0}, sf::Vector2i(static_cast<int>(size.x >> level), static_cast<int>(size.y >> level)));
+    };
+    auto minOverlap = [&](const Plane& maskPlane, unsigned int level) {
+        const sf::IntRect rect = levelRect(sourceSize, level);
+        const long long area = static_cast<long long>(rect.size.x) * rect.size.y;
+        return std::max(4LL, std::min(countCovered(maskPlane), area) / 2);
+    };
+
+    // Korelacje przez FFT na najgrubszym poziomie daja kilka kandydatow; kazdy jest poprawiany
+    // znormalizowana korelacja w otoczeniu 3x3 i dalej ida tylko te bliskie najlepszemu
+    std::vector<Match> matches;
+    {
+        Plane sourcePlane = buildPlane(source, levels, levelRect(sourceSize, levels), nullptr, tolerance, pool);
+        Plane maskPlane = buildPlane(mask, levels, levelRect(maskSize, levels), &transparentColor, tolerance, pool);
+        if (countCovered(maskPlane) == 0) {
+            return std::nullopt;
+        }
+
+        const long long overlap = minOverlap(maskPlane, levels);
+        for (const sf::Vector2i& candidate : correlate(sourcePlane, maskPlane, overlap, pool, progress)) {
+            matches.push_back(refine(sourcePlane, maskPlane, candidate, overlap, pool));
+        }
+        prune(matches);
+    }
+
+    // Kolejne poziomy az do pelnej rozdzielczosci: polozenie x2 i poprawka o najwyzej piksel;
+    // zrodlo potrzebne jest tylko pod maska
+    for (unsigned int level = levels; !matches.empty() && level-- > 0;) {
+        Plane maskPlane = buildPlane(mask, level, levelRect(maskSize, level), &transparentColor, tolerance, pool);
+        const long long overlap = minOverlap(maskPlane, level);
+        for (Match& match : matches) {
+            const sf::Vector2i position = match.position * 2;
+            const std::optional<sf::IntRect> window =
+                sf::IntRect(position - sf::Vector2i(1, 1), sf::Vector2i(maskPlane.size) + sf::Vector2i(2, 2))
+                    .findIntersection(levelRect(sourceSize, level));
+            match = window ? refine(buildPlane(source, level, *window, nullptr, tolerance, pool),
+                                    maskPlane, position, overlap, pool) : Match();
+        }
+        prune(matches);
+    }
+
+    if (matches.empty()) {
+        return std::nullopt;
+    }
+    const Match& best = matches.front();
+    if (progress) {
+        *progress = 100;
+    }
+
+    trace.addArg("score", best.score);
+    AlignResult result;
+    result.offset = -best.position;
+    result.score = best.score;
+    return result;
+}
+
+MaskAligner::Plane MaskAligner::buildPlane(const sf::Image& image, unsigned int level, const sf::IntRect& region,
+                                           const sf::Color* transparentColor, int tolerance, ThreadPool& pool) {
+    Plane plane;
+    plane.origin = region.position;
+    plane.size = sf::Vector2u(region.size);
+    plane.luma.resize(static_cast<std::size_t>(plane.size.x) * plane.size.y);
+    if (transparentColor) {
+        plane.covered.resize(plane.luma.size());
+    }
+
+    // Piksel poziomu to srednia jasnosci bloku 2^level x 2^level; w masce liczone sa tylko
+    // piksele poza kluczem, a piksel jest pokryty, gdy jest ich co najmniej polowa
+    const unsigned int block = 1u << level;
+    const std::size_t rowPixels = static_cast<std::size_t>(plane.size.x) * block;
+    const std::uint8_t* pixels = image.getPixelsPtr();
+    const std::size_t stride = static_cast<std::size_t>(image.getSize().x) * 4;
+
+    pool.parallelFor(plane.size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        std::vector<std::uint8_t> coverage(transparentColor ? rowPixels : 0);
+        std::vector<std::uint32_t> sums(plane.size.x);
+        std::vector<std::uint32_t> counts(plane.size.x);
+
+        for (std::size_t row = rowBegin; row < rowEnd; ++row) {
+            std::fill(sums.begin(), sums.end(), 0);
+            std::fill(counts.begin(), counts.end(), 0);
+            for (unsigned int sub = 0; sub < block; ++sub) {
+                const std::size_t y = (static_cast<std::size_t>(plane.origin.y) + row) * block + sub;
+                const std::uint8_t* line = pixels + y * stride + static_cast<std::size_t>(plane.origin.x) * block * 4;
+                if (transparentColor) {
+                    BlendMode::classifyRow(line, coverage.data(), rowPixels, *transparentColor, tolerance, true);
+                }
+                for (std::size_t i = 0; i < rowPixels; ++i) {
+                    if (!transparentColor || coverage[i] >= 128) {
+                        sums[i / block] += static_cast<std::uint32_t>(luma(line + i * 4));
+                        ++counts[i / block];
+                    }
+                }
+            }
+
+            std::uint8_t* out = plane.luma.data() + row * plane.size.x;
+            for (unsigned int x = 0; x < plane.size.x; ++x) {
+                out[x] = static_cast<std::uint8_t>(counts[x] ? (sums[x] + counts[x] / 2) / counts[x] : 0);
+            }
+            if (transparentColor) {
+                std::uint8_t* covered = plane.covered.data() + row * plane.size.x;
+                for (unsigned int x = 0; x < plane.size.x; ++x) {
+                    covered[x] = counts[x] * 2 >= block * block;
+                }
+            }
+        }
+    });
+
+    return plane;
+}
+
+std::vector<sf::Vector2i> MaskAligner::correlate(const Plane& source, const Plane& mask, long long minOverlap,
+                                                 ThreadPool& pool, std::atomic<int>* progress) {
+    TraceScope trace("correlate", "align");
+
+    // Mala maska nie pozwala zejsc z duzym zrodlem do CoarseSize - wtedy zrodlo idzie kafelkami
+    // z jednym rozmiarem transformaty (bez zawijania dla przesuniec od -(maska-1) do kafelek-1),
+    // a pamiec nie zalezy od rozmiaru zrodla
+    const std::vector<TileSpan> columns = tileSpans(source.size.x, mask.size.x);
+    const std::vector<TileSpan> rows = tileSpans(source.size.y, mask.size.y);
+    const sf::Vector2u size(static_cast<unsigned int>(nextPowerOfTwo(columns.front().end + mask.size.x)),
+                            static_cast<unsigned int>(nextPowerOfTwo(rows.front().end + mask.size.y)));
+    const std::size_t count = static_cast<std::size_t>(size.x) * size.y;
+    trace.addArg("width", size.x);
+    trace.addArg("height", size.y);
+    trace.addArg("tiles", static_cast<long long>(columns.size() * rows.size()));
+
+    // Jasnosci wzgledem srednich, zeby bledy transformaty (proporcjonalne do energii calego
+    // sygnalu) nie zagluszaly lokalnych sum
+    double maskMean = 0.0;
+    for (std::size_t i = 0; i < mask.luma.size(); ++i) {
+        maskMean += mask.covered[i] ? mask.luma[i] : 0;
+    }
+    maskMean /= static_cast<double>(std::max(1LL, countCovered(mask)));
+
+    // Pary sygnalow rzeczywistych w jednej transformacie zespolonej: zrodlo i jego kwadrat,
+    // maska (zero w kluczu) i jej pokrycie, obszar zrodla i kwadrat maski. Widmo maski jest
+    // wspolne dla wszystkich kafelkow, obszaru - zmienia sie tylko na brzegowych
+    std::vector<Complex> maskData(count);
+    std::vector<Complex> areaData(count);
+    for (unsigned int y = 0; y < mask.size.y; ++y) {
+        for (unsigned int x = 0; x < mask.size.x; ++x) {
+            const std::size_t i = static_cast<std::size_t>(y) * mask.size.x + x;
+            if (mask.covered[i]) {
+                const float value = static_cast<float>((mask.luma[i] - maskMean) / 255.0);
+                maskData[static_cast<std::size_t>(y) * size.x + x] = Complex(value, 1.0f);
+            }
+        }
+    }
+    fft2D(maskData, size, false, pool);
+
+    std::vector<Complex> sourceData(count);
+    std::vector<Complex> crossSums(count);
+    std::vector<Complex> sourceSums(count);
+    std::vector<Complex> maskSums(count);
+    std::vector<Complex> phase(count);
+    std::vector<float> phaseSurface(count);
+    std::vector<float> normalizedSurface(count);
+    const long long width = size.x;
+    const long long height = size.y;
+    const float lowest = -std::numeric_limits<float>::infinity();
+    sf::Vector2i areaExtent;
+
+    struct Peak {
+        float score;
+        sf::Vector2i position;
+    };
+    auto lower = [](const Peak& a, const Peak& b) { return a.score > b.score; };
+    std::vector<Peak> peaks[2];
+    std::size_t tilesDone = 0;
+
+    for (const TileSpan& row : rows) {
+        for (const TileSpan& column : columns) {
+            const sf::Vector2i origin(column.begin, row.begin);
+            const sf::Vector2i extent(column.end - column.begin, row.end - row.begin);
+            const sf::IntRect positions({column.ownBegin, row.ownBegin},
+                                        {column.ownEnd - column.ownBegin, row.ownEnd - row.ownBegin});
+
+            if (extent != areaExtent) {
+                std::fill(areaData.begin(), areaData.end(), Complex());
+                for (int y = 0; y < extent.y; ++y) {
+                    for (int x = 0; x < extent.x; ++x) {
+                        areaData[static_cast<std::size_t>(y) * size.x + x].real(1.0f);
+                    }
+                }
+                for (unsigned int y = 0; y < mask.size.y; ++y) {
+                    for (unsigned int x = 0; x < mask.size.x; ++x) {
+                        const std::size_t i = static_cast<std::size_t>(y) * mask.size.x + x;
+                        if (mask.covered[i]) {
+                            const float value = static_cast<float>((mask.luma[i] - maskMean) / 255.0);
+                            areaData[static_cast<std::size_t>(y) * size.x + x].imag(value * value);
+                        }
+                    }
+                }
+                fft2D(areaData, size, false, pool);
+                areaExtent = extent;
+            }
+
+            auto sourceRow = [&](int y) {
+                return source.luma.data() + static_cast<std::size_t>(origin.y + y) * source.size.x + origin.x;
+            };
+            double sourceMean = 0.0;
+            for (int y = 0; y < extent.y; ++y) {
+                const std::uint8_t* line = sourceRow(y);
+                for (int x = 0; x < extent.x; ++x) {
+                    sourceMean += line[x];
+                }
+            }
+            sourceMean /= static_cast<double>(extent.x) * extent.y;
+            std::fill(sourceData.begin(), sourceData.end(), Complex());
+            for (int y = 0; y < extent.y; ++y) {
+                const std::uint8_t* line = sourceRow(y);
+                for (int x = 0; x < extent.x; ++x) {
+                    const float value = static_cast<float>((line[x] - sourceMean) / 255.0);
+                    sourceData[static_cast<std::size_t>(y) * size.x + x] = Complex(value, value * value);
+                }
+            }
+            fft2D(sourceData, size, false, pool);
+
+            // Widma skladowych z symetrii transformaty sygnalu rzeczywistego:
+            // a = (Z[k] + conj(Z[-k])) / 2, b = (Z[k] - conj(Z[-k])) / 2i. Korelacja a z b to
+            // iloczyn A * conj(B); dwie korelacje wracaja jedna transformata odwrotna
+            pool.parallelFor(size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+                const Complex i(0.0f, 1.0f);
+                auto split = [](const std::vector<Complex>& data, std::size_t k, std::size_t mirror, Complex& a, Complex& b) {
+                    const Complex conjugate = std::conj(data[mirror]);
+                    a = (data[k] + conjugate) * 0.5f;
+                    b = (data[k] - conjugate) * Complex(0.0f, -0.5f);
+                };
+                for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+                    const std::size_t mirrorY = (size.y - y) % size.y;
+                    for (std::size_t x = 0; x < size.x; ++x) {
+                        const std::size_t k = y * size.x + x;
+                        const std::size_t mirror = mirrorY * size.x + (size.x - x) % size.x;
+                        Complex s, s2, m, w, area, m2;
+                        split(sourceData, k, mirror, s, s2);
+                        split(maskData, k, mirror, m, w);
+                        split(areaData, k, mirror, area, m2);
+                        const Complex cross = s * std::conj(m);
+                        crossSums[k] = cross + i * (s * std::conj(w));
+                        sourceSums[k] = s2 * std::conj(w) + i * (area * std::conj(w));
+                        maskSums[k] = area * std::conj(m) + i * (area * std::conj(m2));
+
+                        // Korelacja fazowa z czesciowym wybieleniem widma (pierwiastek modulu);
+                        // modul z norm() - std::abs() liczy hypot, kilka razy wolniej
+                        const float magnitude = std::sqrt(std::norm(cross));
+                        phase[k] = magnitude > 1e-12f ? cross / std::sqrt(magnitude) : Complex();
+                    }
+                }
+            });
+            for (std::vector<Complex>* data : {&crossSums, &sourceSums, &maskSums, &phase}) {
+                fft2D(*data, size, true, pool);
+            }
+
+            // Dwie powierzchnie: korelacja fazowa i znormalizowana korelacja wzajemna liczona
+            // tylko na czesci wspolnej maski poza kluczem i zrodla; brane sa tylko polozenia
+            // kafelka (we wspolrzednych poziomu) z czescia wspolna co najmniej minOverlap
+            auto position = [&](long long index, long long wrap, int fragment, int begin) {
+                return static_cast<int>((index < fragment ? index : index - wrap) + begin);
+            };
+            std::fill(phaseSurface.begin(), phaseSurface.end(), lowest);
+            std::fill(normalizedSurface.begin(), normalizedSurface.end(), lowest);
+            pool.parallelFor(size.y, [&](std::size_t rowBegin, std::size_t rowEnd) {
+                for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+                    const int py = position(static_cast<long long>(y), height, extent.y, origin.y);
+                    if (py < positions.position.y || py >= positions.position.y + positions.size.y) {
+                        continue;
+                    }
+                    for (std::size_t x = 0; x < size.x; ++x) {
+                        const int px = position(static_cast<long long>(x), width, extent.x, origin.x);
+                        if (px < positions.position.x || px >= positions.position.x + positions.size.x) {
+                            continue;
+                        }
+                        const std::size_t k = y * size.x + x;
+                        const double overlap = std::round(sourceSums[k].imag());
+                        if (overlap < static_cast<double>(std::max(2LL, minOverlap))) {
+                            continue;
+                        }
+                        phaseSurface[k] = phase[k].real();
+
+                        const double sumS = crossSums[k].imag();
+                        const double sumM = maskSums[k].real();
+                        const double sourceVariance = sourceSums[k].real() - sumS * sumS / overlap;
+                        const double maskVariance = maskSums[k].imag() - sumM * sumM / overlap;
+                        if (sourceVariance > 1e-5 * overlap && maskVariance > 1e-5 * overlap) {
+                            normalizedSurface[k] = static_cast<float>((crossSums[k].real() - sumS * sumM / overlap) /
+                                                                      std::sqrt(sourceVariance * maskVariance));
+                        }
+                    }
+                }
+            });
+
+            // Najwyzsze maksima kazdej powierzchni ze wszystkich kafelkow, w kopcu z najnizszym
+            // na szczycie; otoczenie znalezionego jest wygaszane, a kolejne maksima kafelka sa coraz
+            // nizsze, wiec pierwsze nie lepsze od najnizszego w pelnym kopcu konczy kafelek
+            constexpr long long Suppress = 2;
+            for (int s = 0; s < 2; ++s) {
+                std::vector<float>* surface = s == 0 ? &normalizedSurface : &phaseSurface;
+                std::vector<Peak>& best = peaks[s];
+                for (int i = 0; i < Candidates / 2; ++i) {
+                    const auto peak = std::max_element(surface->begin(), surface->end());
+                    const bool full = best.size() == static_cast<std::size_t>(Candidates / 2);
+                    if (*peak == lowest || (full && *peak <= best.front().score)) {
+                        break;
+                    }
+                    if (full) {
+                        std::pop_heap(best.begin(), best.end(), lower);
+                        best.pop_back();
+                    }
+                    const long long index = peak - surface->begin();
+                    const long long px = index % width;
+                    const long long py = index / width;
+                    best.push_back({*peak, sf::Vector2i(position(px, width, extent.x, origin.x),
+                                                        position(py, height, extent.y, origin.y))});
+                    std::push_heap(best.begin(), best.end(), lower);
+                    for (long long dy = -Suppress; dy <= Suppress; ++dy) {
+                        for (long long dx = -Suppress; dx <= Suppress; ++dx) {
+                            (*surface)[((py + dy + height) % height) * width + (px + dx + width) % width] = lowest;
+                        }
+                    }
+                }
+            }
+
+            // Kafelki to prawie caly czas wyrownania; 100% dopiero po dopasowaniu w pelnej rozdzielczosci
+            if (progress) {
+                *progress = static_cast<int>(99 * ++tilesDone / (rows.size() * columns.size()));
+            }
+        }
+    }
+
+    // Kandydaci z obu powierzchni, kazda od najlepszego
+    std::vector<sf::Vector2i> candidates;
+    for (std::vector<Peak>& best : peaks) {
+        std::sort_heap(best.begin(), best.end(), lower);
+        for (const Peak& peak : best) {
+            candidates.push_back(peak.position);
+        }
+    }
+    return candidates;
+}
+
+MaskAligner::Match MaskAligner::refine(const Plane& source, const Plane& mask, const sf::Vector2i& position,
+                                       long long minOverlap, ThreadPool& pool) {
+    // Znormalizowana korelacja wzajemna pikseli maski poza kluczem z zakrytym zrodlem
+    // dla 9 polozen wokol position; sumy calkowite na pas wierszy, laczone na koncu
+    using Sums = std::array<long long, 6>;
+    const std::size_t rows = mask.size.y;
+    const std::size_t chunk = std::max<std::size_t>(1, rows / 64);
+    const std::size_t chunks = (rows + chunk - 1) / chunk;
+    std::vector<std::array<Sums, 9>> partial(chunks);
+
+    pool.parallelFor(rows, [&](std::size_t rowBegin, std::size_t rowEnd) {
+        std::array<Sums, 9>& sums = partial[rowBegin / chunk];
+        for (Sums& entry : sums) {
+            entry.fill(0);
+        }
+        for (std::size_t y = rowBegin; y < rowEnd; ++y) {
+            const std::uint8_t* maskRow = mask.luma.data() + y * mask.size.x;
+            const std::uint8_t* coveredRow = mask.covered.data() + y * mask.size.x;
+            for (int dy = -1; dy <= 1; ++dy) {
+                const long long sy = static_cast<long long>(position.y) + dy + static_cast<long long>(y) - source.origin.y;
+                if (sy < 0 || sy >= static_cast<long long>(source.size.y)) {
+                    continue;
+                }
+                const std::uint8_t* sourceRow = source.luma.data() + sy * source.size.x;
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const long long shift = static_cast<long long>(position.x) + dx - source.origin.x;
+                    const long long begin = std::max(0LL, -shift);
+                    const long long end = std::min(static_cast<long long>(mask.size.x),
+                                                   static_cast<long long>(source.size.x) - shift);
+                    long long n = 0, sm = 0, ss = 0, smm = 0, sss = 0, sms = 0;
+                    for (long long x = begin; x < end; ++x) {
+                        if (coveredRow[x]) {
+                            const long long m = maskRow[x];
+                            const long long s = sourceRow[x + shift];
+                            ++n;
+                            sm += m;
+                            ss += s;
+                            smm += m * m;
+                            sss += s * s;
+                            sms += m * s;
+                        }
+                    }
+                    Sums& entry = sums[(dy + 1) * 3 + dx + 1];
+                    entry[0] += n;
+                    entry[1] += sm;
+                    entry[2] += ss;
+                    entry[3] += smm;
+                    entry[4] += sss;
+                    entry[5] += sms;
+                }
+            }
+        }
+    }, chunk);
+
+    Match best;
+    for (int shift = 0; shift < 9; ++shift) {
+        Sums total = {0, 0, 0, 0, 0, 0};
+        for (const auto& sums : partial) {
+            for (int i = 0; i < 6; ++i) {
+                total[i] += sums[shift][i];
+            }
+        }
+
+        // Plaskie obszary (odchylenie ponizej pol poziomu jasnosci) nie sa porownywane
+        const double n = static_cast<double>(total[0]);
+        if (total[0] < std::max(2LL, minOverlap)) {
+            continue;
+        }
+        const double maskVariance = n * total[3] - static_cast<double>(total[1]) * total[1];
+        const double sourceVariance = n * total[4] - static_cast<double>(total[2]) * total[2];
+        if (maskVariance <= n * n * 0.25 || sourceVariance <= n * n * 0.25) {
+            continue;
+        }
+        const double score = (n * total[5] - static_cast<double>(total[1]) * total[2]) /
+                             std::sqrt(maskVariance * sourceVariance);
+        if (!best.valid || score > best.score) {
+            best.position = position + sf::Vector2i(shift % 3 - 1, shift / 3 - 1);
+            best.score = score;
+            best.valid = true;
+        }
+    }
+
+    return best;
+}
+
+void MaskAligner::prune(std::vector<Match>& matches) {
+    // Najlepsze pierwsze; to samo polozenie z kilku kandydatow liczy sie raz
+    matches.erase(std::remove_if(matches.begin(), matches.end(), [](const Match& match) { return !match.valid; }),
+                  matches.end());
+    std::stable_sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) { return a.score > b.score; });
+    std::vector<Match> kept;
+    for (const Match& match : matches) {
+        const bool duplicate = std::any_of(kept.begin(), kept.end(), [&](const Match& other) {
+            return other.position == match.position;
+        });
+        if (!duplicate && match.score >= matches.front().score - PruneMargin) {
+            kept.push_back(match);
+        }
+    }
+    matches = std::move(kept);
+}
+
+long long MaskAligner::countCovered(const Plane& plane) {
+    return std::count(plane.covered.begin(), plane.covered.end(), std::uint8_t(1));
+}
+
+}
@@ -1,4 +1,5 @@
 #include "MaskLibrary.h"
+#include "Tracer.h"
 #include <iostream>
 #include <algorithm>
 
@@ -10,6 +11,9 @@ MaskLibrary::MaskLibrary()
 }
 
 void MaskLibrary::scanDirectory(const std::string& directory) {
+    TraceScope trace("scanDirectory", "io");
+    trace.addArg("directory", directory);
+    
     try {
         if (!std::filesystem::exists(directory)) {
             std::cerr << "Katalog nie istnieje: " << directory << std::endl;
@@ -28,6 +32,7 @@ void MaskLibrary::scanDirectory(const std::string& directory) {
                 return a.name < b.name;
             });
         
+        trace.addArg("count", static_cast<long long>(m_masks.size()));
         std::cout << "Znaleziono " << m_masks.size() << " masek w katalogu: " << directory << std::endl;
         
     } catch (const std::exception& e) {
@@ -52,6 +57,9 @@ void MaskLibrary::addMask(const std::string& path) {
 }
 
 void MaskLibrary::loadThumbnail(MaskEntry& entry) {
+    TraceScope trace("thumbnail", "io");
+    trace.addArg("name", entry.name);
+    
     sf::Image image;
     if (!image.loadFromFile(entry.path)) {
         std::cerr << "Nie można wczytać miniaturki: " << entry.path << std::endl;
@@ -0,0 +1,386 @@
+#include "PreciseImage.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace MaskOverlay {
+
+namespace {
+
+// Naglowki Netpbm: tokeny rozdzielone bialymi znakami, komentarze od '#' do konca linii;
+// po ostatnim tokenie pochlaniany jest dokladnie jeden bialy znak
+bool readToken(std::istream& in, std::string& token) {
+    token.clear();
+    int c;
+    while ((c = in.get()) != EOF) {
+        if (c == '#' && token.empty()) {
+            while ((c = in.get()) != EOF && c != '\n') {
+            }
+            continue;
+        }
+        if (std::isspace(c)) {
+            if (!token.empty()) {
+                return true;
+            }
+            continue;
+        }
+        token.push_back(static_cast<char>(c));
+    }
+    return !token.empty();
+}
+
+bool readNumber(std::istream& in, long& value) {
+    std::string token;
+    if (!readToken(in, token)) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtol(token.c_str(), &end, 10);
+    return end != token.c_str() && *end == '\0';
+}
+
+bool isHostLittleEndian() {
+    const std::uint32_t probe = 1;
+    std::uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+std::uint16_t toUInt16(float value) {
+    return static_cast<std::uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+}
+
+PreciseImage::PreciseImage()
+    : m_size(0, 0)
+    , m_format(PixelFormat::UInt16)
+{
+}
+
+void PreciseImage::create(const sf::Vector2u& size, PixelFormat format) {
+    const std::size_t count = static_cast<std::size_t>(size.x) * size.y * 4;
+    m_size = size;
+    m_format = format;
+    if (format == PixelFormat::UInt16) {
+        m_pixels16.assign(count, 0);
+        std::vector<float>().swap(m_pixelsFloat);
+    } else {
+        m_pixelsFloat.assign(count, 0.0f);
+        std::vector<std::uint16_t>().swap(m_pixels16);
+    }
+}
+
+void PreciseImage::assign(const sf::Image& image, PixelFormat format) {
+    create(image.getSize(), format);
+    const std::uint8_t* pixels = image.getPixelsPtr();
+    const std::size_t count = static_cast<std::size_t>(m_size.x) * m_size.y * 4;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (format == PixelFormat::UInt16) {
+            m_pixels16[i] = static_cast<std::uint16_t>(pixels[i] * 257);
+        } else {
+            m_pixelsFloat[i] = pixels[i] / 255.0f;
+        }
+    }
+}
+
+void PreciseImage::convert(PixelFormat format) {
+    if (format == m_format || isEmpty()) {
+        m_format = format;
+        return;
+    }
+
+    PreciseImage converted;
+    converted.create(m_size, format);
+    std::vector<float> row(static_cast<std::size_t>(m_size.x) * 4);
+    for (unsigned int y = 0; y < m_size.y; ++y) {
+        readRow(y, 0, m_size.x, row.data());
+        converted.writeRow(y, 0, m_size.x, row.data());
+    }
+    *this = std::move(converted);
+}
+
+bool PreciseImage::loadFromFile(const std::string& path) {
+    if (!isPreciseFile(path)) {
+        sf::Image image;
+        if (!image.loadFromFile(path)) {
+            std::cerr << "Nie można wczytać obrazu: " << path << std::endl;
+            return false;
+        }
+        // Inne formaty dekoduje SFML z 8 bitami na kanal - dodatkowa precyzja dotyczy tylko obliczen
+        std::cerr << "Uwaga: " << path << " nie jest plikiem PGM/PPM/PAM/PFM - wczytano 8 bitów na kanał" << std::endl;
+        assign(image, PixelFormat::UInt16);
+        return true;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    bool loaded = false;
+    if (file && readToken(file, magic)) {
+        if (magic == "P5" || magic == "P6" || magic == "P7") {
+            loaded = loadNetpbm(file, magic);
+        } else if (magic == "PF" || magic == "Pf") {
+            loaded = loadPfm(file, magic == "PF");
+        }
+    }
+
+    if (!loaded) {
+        std::cerr << "Nie można wczytać obrazu (oczekiwano PGM/PPM/PAM/PFM): " << path << std::endl;
+    }
+    return loaded;
+}
+
+bool PreciseImage::loadNetpbm(std::istream& file, const std::string& magic) {
+    long width = 0, height = 0, maxValue = 0;
+    long channels = magic == "P5" ? 1 : 3;
+
+    if (magic == "P7") {
+        std::string key;
+        while (readToken(file, key) && key != "ENDHDR") {
+            if (key == "TUPLTYPE") {
+                std::string type;
+                readToken(file, type);
+                continue;
+            }
+            long value = 0;
+            if (!readNumber(file, value)) {
+                return false;
+            }
+            if (key == "WIDTH") {
+                width = value;
+            } else if (key == "HEIGHT") {
+                height = value;
+            } else if (key == "DEPTH") {
+                channels = value;
+            } else if (key == "MAXVAL") {
+                maxValue = value;
+            }
+        }
+    } else if (!readNumber(file, width) || !readNumber(file, height) || !readNumber(file, maxValue)) {
+        return false;
+    }
+
+    if (width <= 0 || height <= 0 || width > 65535 || height > 65535 ||
+        maxValue <= 0 || maxValue > 65535 || channels < 1 || channels > 4) {
+        return false;
+    }
+
+    // Probki 8- lub 16-bitowe (big-endian), skalowane do pelnego zakresu 16 bitow
+    const std::size_t bytesPerSample = maxValue < 256 ? 1 : 2;
+    const std::size_t samples = static_cast<std::size_t>(width) * height * channels;
+    std::vector<std::uint8_t> data(samples * bytesPerSample);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return false;
+    }
+
+    create(sf::Vector2u(static_cast<unsigned int>(width), static_cast<unsigned int>(height)), PixelFormat::UInt16);
+    auto sample = [&](std::size_t index) {
+        std::uint32_t value = bytesPerSample == 1
+            ? data[index]
+            : static_cast<std::uint32_t>(data[index * 2] << 8 | data[index * 2 + 1]);
+        return static_cast<std::uint16_t>((std::min<std::uint32_t>(value, maxValue) * 65535u + maxValue / 2) / maxValue);
+    };
+
+    const std::size_t pixels = static_cast<std::size_t>(width) * height;
+    for (std::size_t i = 0; i < pixels; ++i) {
+        const std::size_t in = i * channels;
+        std::uint16_t* out = &m_pixels16[i * 4];
+        if (channels < 3) {
+            out[0] = out[1] = out[2] = sample(in);
+            out[3] = channels == 2 ? sample(in + 1) : 65535;
+        } else {
+            out[0] = sample(in);
+            out[1] = sample(in + 1);
+            out[2] = sample(in + 2);
+            out[3] = channels == 4 ? sample(in + 3) : 65535;
+        }
+    }
+    return true;
+}
+
+bool PreciseImage::loadPfm(std::istream& file, bool color) {
+    long width = 0, height = 0;
+    std::string scaleToken;
+    if (!readNumber(file, width) || !readNumber(file, height) || !readToken(file, scaleToken) ||
+        width <= 0 || height <= 0 || width > 65535 || height > 65535) {
+        return false;
+    }
+
+    // Ujemna skala oznacza little-endian; wiersze zapisane sa od dolu
+    const bool littleEndian = std::strtod(scaleToken.c_str(), nullptr) < 0;
+    const std::size_t channels = color ? 3 : 1;
+    const std::size_t samples = static_cast<std::size_t>(width) * height * channels;
+    std::vector<std::uint8_t> data(samples * 4);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return false;
+    }
+
+    if (littleEndian != isHostLittleEndian()) {
+        for (std::size_t i = 0; i < samples; ++i) {
+            std::reverse(data.begin() + i * 4, data.begin() + i * 4 + 4);
+        }
+    }
+
+    create(sf::Vector2u(static_cast<unsigned int>(width), static_cast<unsigned int>(height)), PixelFormat::Float32);
+    for (long y = 0; y < height; ++y) {
+        const std::uint8_t* row = data.data() + static_cast<std::size_t>(height - 1 - y) * width * channels * 4;
+        float* out = &m_pixelsFloat[static_cast<std::size_t>(y) * width * 4];
+        for (long x = 0; x < width; ++x) {
+            float values[3];
+            std::memcpy(values, row + static_cast<std::size_t>(x) * channels * 4, channels * 4);
+            out[x * 4 + 0] = values[0];
+            out[x * 4 + 1] = color ? values[1] : values[0];
+            out[x * 4 + 2] = color ? values[2] : values[0];
+            out[x * 4 + 3] = 1.0f;
+        }
+    }
+    return true;
+}
+
+bool PreciseImage::saveToFile(const std::string& path) const {
+    if (isEmpty()) {
+        return false;
+    }
+
+    std::string ext = extension(path);
+    bool saved;
+    if (ext == ".pfm") {
+        saved = savePfm(path);
+    } else if (ext == ".ppm" || ext == ".pnm" || ext == ".pam") {
+        saved = saveNetpbm(path, ext == ".pam");
+    } else {
+        saved = toImage().saveToFile(path);
+    }
+
+    if (!saved) {
+        std::cerr << "Nie można zapisać obrazu: " << path << std::endl;
+    }
+    return saved;
+}
+
+bool PreciseImage::saveNetpbm(const std::string& path, bool alpha) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    if (alpha) {
+        file << "P7\nWIDTH " << m_size.x << "\nHEIGHT " << m_size.y
+             << "\nDEPTH 4\nMAXVAL 65535\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+    } else {
+        file << "P6\n" << m_size.x << " " << m_size.y << "\n65535\n";
+    }
+
+    const std::size_t channels = alpha ? 4 : 3;
+    std::vector<float> row(static_cast<std::size_t>(m_size.x) * 4);
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(m_size.x) * channels * 2);
+    for (unsigned int y = 0; y < m_size.y; ++y) {
+        readRow(y, 0, m_size.x, row.data());
+        for (std::size_t x = 0; x < m_size.x; ++x) {
+            for (std::size_t c = 0; c < channels; ++c) {
+                std::uint16_t value = toUInt16(row[x * 4 + c]);
+                bytes[(x * channels + c) * 2] = static_cast<std::uint8_t>(value >> 8);
+                bytes[(x * channels + c) * 2 + 1] = static_cast<std::uint8_t>(value & 0xFF);
+            }
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+bool PreciseImage::savePfm(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    const bool littleEndian = isHostLittleEndian();
+    file << "PF\n" << m_size.x << " " << m_size.y << "\n" << (littleEndian ? "-1.0" : "1.0") << "\n";
+
+    std::vector<float> row(static_cast<std::size_t>(m_size.x) * 4);
+    std::vector<float> values(static_cast<std::size_t>(m_size.x) * 3);
+    for (unsigned int y = m_size.y; y-- > 0;) {
+        readRow(y, 0, m_size.x, row.data());
+        for (std::size_t x = 0; x < m_size.x; ++x) {
+            values[x * 3 + 0] = row[x * 4 + 0];
+            values[x * 3 + 1] = row[x * 4 + 1];
+            values[x * 3 + 2] = row[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(float)));
+    }
+    return static_cast<bool>(file);
+}
+
+sf::Image PreciseImage::toImage() const {
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(m_size.x) * m_size.y * 4);
+    std::vector<float> row(static_cast<std::size_t>(m_size.x) * 4);
+    for (unsigned int y = 0; y < m_size.y; ++y) {
+        readRow(y, 0, m_size.x, row.data());
+        std::uint8_t* out = &pixels[static_cast<std::size_t>(y) * m_size.x * 4];
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            out[i] = static_cast<std::uint8_t>(std::clamp(row[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+    return sf::Image(m_size, pixels.data());
+}
+
+sf::Vector2u PreciseImage::getSize() const {
+    return m_size;
+}
+
+PixelFormat PreciseImage::getFormat() const {
+    return m_format;
+}
+
+bool PreciseImage::isEmpty() const {
+    return m_size.x == 0 || m_size.y == 0;
+}
+
+void PreciseImage::readRow(unsigned int y, unsigned int x, std::size_t count, float* pixels) const {
+    const std::size_t begin = (static_cast<std::size_t>(y) * m_size.x + x) * 4;
+    if (m_format == PixelFormat::Float32) {
+        std::memcpy(pixels, &m_pixelsFloat[begin], count * 4 * sizeof(float));
+        return;
+    }
+
+    const std::uint16_t* in = &m_pixels16[begin];
+    for (std::size_t i = 0; i < count * 4; ++i) {
+        pixels[i] = in[i] * (1.0f / 65535.0f);
+    }
+}
+
+void PreciseImage::writeRow(unsigned int y, unsigned int x, std::size_t count, const float* pixels) {
+    const std::size_t begin = (static_cast<std::size_t>(y) * m_size.x + x) * 4;
+    if (m_format == PixelFormat::Float32) {
+        std::memcpy(&m_pixelsFloat[begin], pixels, count * 4 * sizeof(float));
+        return;
+    }
+
+    std::uint16_t* out = &m_pixels16[begin];
+    for (std::size_t i = 0; i < count * 4; ++i) {
+        out[i] = toUInt16(pixels[i]);
+    }
+}
+
+bool PreciseImage::isPreciseFile(const std::string& path) {
+    std::string ext = extension(path);
+    return ext == ".pgm" || ext == ".ppm" || ext == ".pnm" || ext == ".pam" || ext == ".pfm";
+}
+
+std::string PreciseImage::extension(const std::string& path) {
+    std::size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) {
+        return "";
+    }
+    std::string ext = path.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return ext;
+}
+
+}
@@ -0,0 +1,165 @@
+#include "PreciseProcessor.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace MaskOverlay {
+
+PreciseProcessor::PreciseProcessor(PixelFormat format)
+    : m_format(format)
+    , m_maskOffset(0, 0)
+    , m_hasResult(false)
+    , m_threadPool(std::make_unique<ThreadPool>())
+{
+}
+
+bool PreciseProcessor::loadSourceImage(const std::string& path) {
+    PreciseImage image;
+    if (!image.loadFromFile(path)) {
+        std::cerr << "Nie można wczytać obrazu źródłowego: " << path << std::endl;
+        return false;
+    }
+    return setSourceImage(image);
+}
+
+bool PreciseProcessor::loadMask(const std::string& path) {
+    PreciseImage image;
+    if (!image.loadFromFile(path)) {
+        std::cerr << "Nie można wczytać maski: " << path << std::endl;
+        return false;
+    }
+    return setMask(image);
+}
+
+bool PreciseProcessor::setSourceImage(const PreciseImage& image) {
+    if (image.isEmpty()) {
+        return false;
+    }
+    
+    m_sourceImage = image;
+    m_sourceImage.convert(m_format);
+    m_hasResult = false;
+    return true;
+}
+
+bool PreciseProcessor::setMask(const PreciseImage& image) {
+    if (image.isEmpty()) {
+        return false;
+    }
+    
+    // Maska jest tylko czytana - zostaje w formacie, w ktorym ja wczytano
+    m_maskImage = image;
+    m_hasResult = false;
+    return true;
+}
+
+void PreciseProcessor::applyMask(BlendModeType mode,
+                                 const sf::Color& transparentColor,
+                                 bool useAlpha,
+                                 int tolerance,
+                                 std::uint8_t opacity) {
+    if (m_sourceImage.isEmpty() || m_maskImage.isEmpty()) {
+        std::cerr << "Brak obrazu źródłowego lub maski!" << std::endl;
+        return;
+    }
+    
+    const sf::Vector2u sourceSize = m_sourceImage.getSize();
+    const sf::Vector2u maskSize = m_maskImage.getSize();
+    const sf::Vector2i offset = m_maskOffset;
+    
+    TraceScope trace("applyMaskPrecise", "blend");
+    trace.addArg("width", sourceSize.x);
+    trace.addArg("height", sourceSize.y);
+    trace.addArg("mode", BlendMode::getModeName(mode));
+    trace.addArg("threads", m_threadPool->getThreadCount());
+    trace.addArg("format", m_format == PixelFormat::Float32 ? "float" : "16");
+    
+    // Poza obszarem maski wynik jest kopia zrodla
+    m_resultImage = m_sourceImage;
+    m_hasResult = true;
+    
+    const long long rowBegin = std::clamp<long long>(-static_cast<long long>(offset.y), 0, sourceSize.y);
+    const long long rowEnd = std::clamp<long long>(static_cast<long long>(maskSize.y) - offset.y, rowBegin, sourceSize.y);
+    const long long spanBegin = std::clamp<long long>(-static_cast<long long>(offset.x), 0, sourceSize.x);
+    const long long spanEnd = std::clamp<long long>(static_cast<long long>(maskSize.x) - offset.x, spanBegin, sourceSize.x);
+    const std::size_t span = static_cast<std::size_t>(spanEnd - spanBegin);
+    
+    if (span == 0 || rowBegin == rowEnd || opacity == 0) {
+        return;
+    }
+    
+    m_threadPool->parallelFor(static_cast<std::size_t>(rowEnd - rowBegin), [&](std::size_t begin, std::size_t end) {
+        TraceScope tile("tile", "blend");
+        tile.addArg("rowBegin", static_cast<long long>(rowBegin + begin));
+        tile.addArg("rowEnd", static_cast<long long>(rowBegin + end));
+        
+        // Bufory wierszy w float - ta sama sciezka dla 16 bitow i float
+        std::vector<float> source(span * 4);
+        std::vector<float> mask(span * 4);
+        std::vector<float> coverage(span);
+        std::vector<float> result(span * 4);
+        
+        for (std::size_t row = begin; row < end; ++row) {
+            const unsigned int y = static_cast<unsigned int>(rowBegin + row);
+            const unsigned int maskY = static_cast<unsigned int>(y + offset.y);
+            
+            m_sourceImage.readRow(y, static_cast<unsigned int>(spanBegin), span, source.data());
+            m_maskImage.readRow(maskY, static_cast<unsigned int>(spanBegin + offset.x), span, mask.data());
+            BlendMode::classifyRowFloat(mask.data(), coverage.data(), span, transparentColor, tolerance, useAlpha);
+            BlendMode::blendRowFloat(source.data(), mask.data(), coverage.data(), result.data(), span, mode, opacity);
+            m_resultImage.writeRow(y, static_cast<unsigned int>(spanBegin), span, result.data());
+        }
+    });
+}
+
+bool PreciseProcessor::saveResult(const std::string& path) const {
+    if (!m_hasResult) {
+        std::cerr << "Brak wyniku do zapisania!" << std::endl;
+        return false;
+    }
+    return m_resultImage.saveToFile(path);
+}
+
+void PreciseProcessor::setMaskOffset(int x, int y) {
+    m_maskOffset = sf::Vector2i(x, y);
+}
+
+sf::Vector2i PreciseProcessor::getMaskOffset() const {
+    return m_maskOffset;
+}
+
+sf::Vector2u PreciseProcessor::getSourceSize() const {
+    return m_sourceImage.getSize();
+}
+
+sf::Vector2u PreciseProcessor::getMaskSize() const {
+    return m_maskImage.getSize();
+}
+
+PixelFormat PreciseProcessor::getFormat() const {
+    return m_format;
+}
+
+bool PreciseProcessor::hasResult() const {
+    return m_hasResult;
+}
+
+const PreciseImage& PreciseProcessor::getResult() const {
+    return m_resultImage;
+}
+
+void PreciseProcessor::setThreadCount(unsigned int count) {
+    if (count == 0) {
+        count = ThreadPool::getHardwareThreadCount();
+    }
+    if (count != m_threadPool->getThreadCount()) {
+        m_threadPool = std::make_unique<ThreadPool>(count);
+    }
+}
+
+unsigned int PreciseProcessor::getThreadCount() const {
+    return m_threadPool->getThreadCount();
+}
+
+}
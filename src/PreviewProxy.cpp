@@ -0,0 +1,118 @@
+#include "PreviewProxy.h"
+#include "ImageResampler.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace MaskOverlay {
+
+PreviewProxy::PreviewProxy()
+    : m_scale(1.0f)
+    , m_active(false)
+    , m_proxySize(0, 0)
+    , m_sourceGeneration(0)
+    , m_maskGeneration(0)
+{
+    // Proxy jest wyswietlane tylko jako wynik; historia cofania dotyczy tylko pelnego wyniku
+    m_processor.setVisibleTextures(false, false, true);
+    m_processor.setHistoryBudget(0);
+}
+
+bool PreviewProxy::update(const ImageProcessor& processor, const sf::Vector2f& previewSize) {
+    if (!processor.hasSourceImage() || !processor.hasMask()) {
+        m_active = false;
+        return false;
+    }
+
+    sf::Vector2u sourceSize = processor.getSourceSize();
+    sf::Vector2u proxySize = ImageResampler::fitSize(sourceSize, previewSize);
+
+    // Podglad i tak pokazuje obraz w pelnej rozdzielczosci - proxy nic nie da
+    if (proxySize.x >= sourceSize.x || proxySize.y >= sourceSize.y) {
+        m_active = false;
+        return false;
+    }
+
+    bool resized = proxySize != m_proxySize;
+    bool sourceChanged = resized || processor.getSourceGeneration() != m_sourceGeneration;
+    bool maskChanged = resized || processor.getOriginalMaskGeneration() != m_maskGeneration;
+
+    if (sourceChanged || maskChanged) {
+        TraceScope trace("buildProxy", "proxy");
+        trace.addArg("width", proxySize.x);
+        trace.addArg("height", proxySize.y);
+
+        m_scale = static_cast<float>(proxySize.x) / sourceSize.x;
+        m_proxySize = proxySize;
+
+        if (sourceChanged) {
+            m_processor.setSourceImage(ImageResampler::resizeArea(processor.getSourceImage(), proxySize));
+            m_sourceGeneration = processor.getSourceGeneration();
+        }
+
+        if (maskChanged) {
+            // Najblizszy sasiad zachowuje dokladny kolor przezroczysty na krawedziach maski;
+            // skala i obrot sa nakladane na maske proxy, w rozdzielczosci podgladu
+            const sf::Image& mask = processor.getOriginalMaskImage();
+            sf::Vector2u proxyMaskSize(
+                std::max(1u, static_cast<unsigned int>(std::lround(mask.getSize().x * m_scale))),
+                std::max(1u, static_cast<unsigned int>(std::lround(mask.getSize().y * m_scale))));
+            m_processor.setMask(ImageResampler::resizeNearest(mask, proxyMaskSize));
+            m_maskGeneration = processor.getOriginalMaskGeneration();
+        }
+    }
+
+    m_active = true;
+    return true;
+}
+
+bool PreviewProxy::isActive() const {
+    return m_active;
+}
+
+void PreviewProxy::applyMask(const sf::Vector2i& maskOffset,
+                             BlendModeType mode,
+                             const sf::Color& transparentColor,
+                             bool useAlpha,
+                             int tolerance,
+                             std::uint8_t opacity) {
+    if (!m_active) {
+        return;
+    }
+
+    m_processor.setMaskOffset(static_cast<int>(std::lround(maskOffset.x * m_scale)),
+                              static_cast<int>(std::lround(maskOffset.y * m_scale)));
+    // Podczas interakcji wystarczy filtr dwuliniowy - pelna jakosc daje przeliczenie oryginalu
+    MaskTransform transform = m_maskTransform;
+    if (transform.filter == ResampleFilter::Area) {
+        transform.filter = ResampleFilter::Bilinear;
+    }
+    m_processor.setMaskTransform(transform, transparentColor);
+    m_processor.applyMask(mode, transparentColor, useAlpha, tolerance, opacity);
+}
+
+void PreviewProxy::setSoftKey(int softness, bool despill, int feather) {
+    m_processor.setSoftKey(softness, despill, feather);
+}
+
+void PreviewProxy::setMaskTransform(const MaskTransform& transform) {
+    m_maskTransform = transform;
+}
+
+void PreviewProxy::setLinearLight(bool linear) {
+    m_processor.setLinearLight(linear);
+}
+
+void PreviewProxy::setMaskWrap(MaskWrap wrap) {
+    m_processor.setMaskWrap(wrap);
+}
+
+float PreviewProxy::getScale() const {
+    return m_scale;
+}
+
+const ImageProcessor& PreviewProxy::getProcessor() const {
+    return m_processor;
+}
+
+}
@@ -0,0 +1,147 @@
+#include "Profiler.h"
+#include <mutex>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace MaskOverlay {
+
+namespace {
+
+constexpr std::size_t HistorySize = 240;
+
+template <typename T>
+struct History {
+    std::array<T, HistorySize> values{};
+    std::size_t count = 0;
+    std::size_t next = 0;
+
+    void push(T value) {
+        values[next] = value;
+        next = (next + 1) % HistorySize;
+        count = std::min(count + 1, HistorySize);
+    }
+
+    T last() const {
+        return count == 0 ? T() : values[(next + HistorySize - 1) % HistorySize];
+    }
+};
+
+struct ProfilerState {
+    std::mutex mutex;
+    History<double> stages[static_cast<int>(ProfileStage::Count)];
+    History<std::uint64_t> counters[static_cast<int>(ProfileCounter::Count)];
+    double lastApplyMegapixelsPerSecond = 0;
+};
+
+ProfilerState& state() {
+    static ProfilerState instance;
+    return instance;
+}
+
+double percentile(std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+}
+
+void Profiler::setEnabled(bool enabled) {
+    if (enabled && !isEnabled()) {
+        for (auto& counter : s_frameCounters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::addSample(ProfileStage stage, double milliseconds) {
+    if (!isEnabled()) {
+        return;
+    }
+    
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.stages[static_cast<int>(stage)].push(milliseconds);
+}
+
+void Profiler::recordApply(std::uint64_t pixels, double milliseconds) {
+    if (!isEnabled() || milliseconds <= 0) {
+        return;
+    }
+    
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.lastApplyMegapixelsPerSecond = pixels / (milliseconds * 1000.0);
+}
+
+void Profiler::endFrame() {
+    if (!isEnabled()) {
+        return;
+    }
+    
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    for (int i = 0; i < static_cast<int>(ProfileCounter::Count); ++i) {
+        s.counters[i].push(s_frameCounters[i].exchange(0, std::memory_order_relaxed));
+    }
+}
+
+StageStatistics Profiler::getStageStatistics(ProfileStage stage) {
+    ProfilerState& s = state();
+    std::vector<double> samples;
+    StageStatistics stats;
+    
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const auto& history = s.stages[static_cast<int>(stage)];
+        samples.assign(history.values.begin(), history.values.begin() + history.count);
+        stats.last = history.last();
+    }
+    
+    std::sort(samples.begin(), samples.end());
+    stats.p50 = percentile(samples, 0.50);
+    stats.p95 = percentile(samples, 0.95);
+    stats.p99 = percentile(samples, 0.99);
+    return stats;
+}
+
+CounterStatistics Profiler::getCounterStatistics(ProfileCounter counter) {
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    const auto& history = s.counters[static_cast<int>(counter)];
+    
+    CounterStatistics stats;
+    stats.last = history.last();
+    if (history.count > 0) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < history.count; ++i) {
+            sum += history.values[i];
+            stats.peak = std::max(stats.peak, history.values[i]);
+        }
+        stats.average = static_cast<double>(sum) / history.count;
+    }
+    return stats;
+}
+
+double Profiler::getLastApplyMegapixelsPerSecond() {
+    ProfilerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.lastApplyMegapixelsPerSecond;
+}
+
+std::string Profiler::getStageName(ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::Decode: return "Dekodowanie";
+        case ProfileStage::Blend:  return "Mieszanie";
+        case ProfileStage::Upload: return "Wysylanie tekstur";
+        case ProfileStage::Render: return "Renderowanie";
+        case ProfileStage::Frame:  return "Klatka";
+        default:                   return "Nieznany";
+    }
+}
+
+}
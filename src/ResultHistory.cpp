@@ -0,0 +1,317 @@
+#include "ResultHistory.h"
+#include <algorithm>
+
+namespace MaskOverlay {
+
+namespace {
+
+// Serie zer krotsze niz ta liczba bajtow zostaja w literale - naglowek nowej serii kosztowalby wiecej
+constexpr std::size_t MinZeroRun = 8;
+
+void writeVarint(std::vector<std::uint8_t>& out, std::size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::size_t readVarint(const std::uint8_t*& data) {
+    std::size_t value = 0;
+    int shift = 0;
+    while (*data & 0x80) {
+        value |= static_cast<std::size_t>(*data++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= static_cast<std::size_t>(*data++) << shift;
+    return value;
+}
+
+}
+
+ResultHistory::ResultHistory(std::size_t budget)
+    : m_position(0)
+    , m_bytes(0)
+    , m_budget(budget)
+    , m_size(0, 0)
+    , m_open(false)
+{
+}
+
+void ResultHistory::record(const std::uint8_t* before,
+                           const std::uint8_t* after,
+                           const sf::Vector2u& size,
+                           const sf::IntRect& region,
+                           const std::optional<sf::IntRect>& beforeMaskRect,
+                           const std::optional<sf::IntRect>& afterMaskRect,
+                           ThreadPool& pool) {
+    if (m_budget == 0) {
+        return;
+    }
+    if (size != m_size) {
+        clear();
+        m_size = size;
+    }
+    
+    const std::optional<sf::IntRect> clipped = region.findIntersection(sf::IntRect({0, 0}, sf::Vector2i(size)));
+    if (!clipped) {
+        return;
+    }
+    
+    // Nowa zmiana po cofnieciu usuwa kroki do ponowienia
+    for (std::size_t i = m_position; i < m_steps.size(); ++i) {
+        m_bytes -= m_steps[i].bytes;
+    }
+    m_steps.erase(m_steps.begin() + static_cast<std::ptrdiff_t>(m_position), m_steps.end());
+    
+    // Otwarty krok (np. przeciaganie maski) laczy kolejne roznice: XOR roznic A->B i B->C daje A->C
+    Step* open = m_open && m_position > 0 ? &m_steps[m_position - 1] : nullptr;
+    
+    const int columns = (static_cast<int>(size.x) + TileSize - 1) / TileSize;
+    const int tileLeft = clipped->position.x / TileSize;
+    const int tileTop = clipped->position.y / TileSize;
+    const int tileRight = (clipped->position.x + clipped->size.x - 1) / TileSize;
+    const int tileBottom = (clipped->position.y + clipped->size.y - 1) / TileSize;
+    const std::size_t tileColumns = static_cast<std::size_t>(tileRight - tileLeft + 1);
+    const std::size_t stride = static_cast<std::size_t>(size.x) * 4;
+    std::vector<Tile> encoded(tileColumns * static_cast<std::size_t>(tileBottom - tileTop + 1));
+    
+    pool.parallelFor(static_cast<std::size_t>(tileBottom - tileTop + 1), [&](std::size_t rowBegin, std::size_t rowEnd) {
+        std::vector<std::uint8_t> delta(static_cast<std::size_t>(TileSize) * TileSize * 4);
+        
+        for (std::size_t row = rowBegin; row < rowEnd; ++row) {
+            for (std::size_t column = 0; column < tileColumns; ++column) {
+                const std::uint32_t index = static_cast<std::uint32_t>((tileTop + static_cast<int>(row)) * columns +
+                                                                       tileLeft + static_cast<int>(column));
+                const sf::IntRect rect = tileRect(index);
+                const std::size_t rowBytes = static_cast<std::size_t>(rect.size.x) * 4;
+                
+                std::uint8_t differs = 0;
+                for (int y = 0; y < rect.size.y; ++y) {
+                    const std::size_t offset = static_cast<std::size_t>(rect.position.y + y) * stride +
+                                               static_cast<std::size_t>(rect.position.x) * 4;
+                    std::uint8_t* d = delta.data() + static_cast<std::size_t>(y) * rowBytes;
+                    for (std::size_t i = 0; i < rowBytes; ++i) {
+                        d[i] = before[offset + i] ^ after[offset + i];
+                        differs |= d[i];
+                    }
+                }
+                
+                const Tile* previous = nullptr;
+                if (open) {
+                    auto it = std::lower_bound(open->tiles.begin(), open->tiles.end(), index,
+                                               [](const Tile& tile, std::uint32_t value) { return tile.index < value; });
+                    if (it != open->tiles.end() && it->index == index) {
+                        previous = &*it;
+                    }
+                }
+                if (previous) {
+                    apply(previous->data, delta.data(), rowBytes, sf::IntRect({0, 0}, rect.size));
+                } else if (!differs) {
+                    continue;
+                }
+                
+                Tile& tile = encoded[row * tileColumns + column];
+                tile.index = index;
+                encode(delta.data(), rowBytes * static_cast<std::size_t>(rect.size.y), tile.data);
+                tile.data.shrink_to_fit();
+            }
+        }
+    });
+    
+    Step step;
+    step.beforeMaskRect = open ? open->beforeMaskRect : beforeMaskRect;
+    step.afterMaskRect = afterMaskRect;
+    if (open) {
+        // Kafelki poza obszarem zmiany przechodza bez zmian
+        for (Tile& tile : open->tiles) {
+            const int x = static_cast<int>(tile.index) % columns;
+            const int y = static_cast<int>(tile.index) / columns;
+            if (x < tileLeft || x > tileRight || y < tileTop || y > tileBottom) {
+                step.tiles.push_back(std::move(tile));
+            }
+        }
+    }
+    for (Tile& tile : encoded) {
+        if (!tile.data.empty()) {
+            step.tiles.push_back(std::move(tile));
+        }
+    }
+    std::sort(step.tiles.begin(), step.tiles.end(), [](const Tile& a, const Tile& b) { return a.index < b.index; });
+    
+    if (!open && step.tiles.empty()) {
+        return;
+    }
+    
+    step.bytes = sizeof(Step);
+    for (const Tile& tile : step.tiles) {
+        step.bytes += sizeof(Tile) + tile.data.capacity();
+    }
+    
+    if (open) {
+        m_bytes -= open->bytes;
+        *open = std::move(step);
+        m_bytes += open->bytes;
+    } else {
+        m_bytes += step.bytes;
+        m_steps.push_back(std::move(step));
+        ++m_position;
+        m_open = true;
+    }
+    trimToBudget();
+}
+
+void ResultHistory::closeStep() {
+    // Krok, ktory po polaczeniu roznic nic nie zmienia, nie jest zachowywany
+    if (m_open && m_position > 0 && m_steps[m_position - 1].tiles.empty()) {
+        m_bytes -= m_steps[m_position - 1].bytes;
+        m_steps.erase(m_steps.begin() + static_cast<std::ptrdiff_t>(m_position - 1));
+        --m_position;
+    }
+    m_open = false;
+}
+
+bool ResultHistory::undo(std::uint8_t* pixels, DirtyRegion& changed, std::optional<sf::IntRect>& maskRect, ThreadPool& pool) {
+    if (!canUndo()) {
+        return false;
+    }
+    
+    m_open = false;
+    const Step& step = m_steps[--m_position];
+    applyStep(step, pixels, changed, pool);
+    maskRect = step.beforeMaskRect;
+    return true;
+}
+
+bool ResultHistory::redo(std::uint8_t* pixels, DirtyRegion& changed, std::optional<sf::IntRect>& maskRect, ThreadPool& pool) {
+    if (!canRedo()) {
+        return false;
+    }
+    
+    m_open = false;
+    const Step& step = m_steps[m_position++];
+    applyStep(step, pixels, changed, pool);
+    maskRect = step.afterMaskRect;
+    return true;
+}
+
+bool ResultHistory::canUndo() const {
+    return m_position > 0;
+}
+
+bool ResultHistory::canRedo() const {
+    return m_position < m_steps.size();
+}
+
+void ResultHistory::clear() {
+    m_steps.clear();
+    m_position = 0;
+    m_bytes = 0;
+    m_open = false;
+}
+
+void ResultHistory::setBudget(std::size_t bytes) {
+    m_budget = bytes;
+    if (m_budget == 0) {
+        clear();
+    } else {
+        trimToBudget();
+    }
+}
+
+std::size_t ResultHistory::getBudget() const {
+    return m_budget;
+}
+
+std::size_t ResultHistory::getBytes() const {
+    return m_bytes;
+}
+
+sf::IntRect ResultHistory::tileRect(std::uint32_t index) const {
+    const int columns = (static_cast<int>(m_size.x) + TileSize - 1) / TileSize;
+    const int x = static_cast<int>(index) % columns * TileSize;
+    const int y = static_cast<int>(index) / columns * TileSize;
+    return sf::IntRect({x, y}, {std::min(TileSize, static_cast<int>(m_size.x) - x),
+                                std::min(TileSize, static_cast<int>(m_size.y) - y)});
+}
+
+void ResultHistory::applyStep(const Step& step, std::uint8_t* pixels, DirtyRegion& changed, ThreadPool& pool) const {
+    // Ta sama roznica XOR cofa i ponawia krok; kafelki sa rozlaczne, wiec watki nie koliduja
+    const std::size_t stride = static_cast<std::size_t>(m_size.x) * 4;
+    pool.parallelFor(step.tiles.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            apply(step.tiles[i].data, pixels, stride, tileRect(step.tiles[i].index));
+        }
+    });
+    
+    for (const Tile& tile : step.tiles) {
+        changed.add(tileRect(tile.index));
+    }
+}
+
+void ResultHistory::trimToBudget() {
+    // Najstarsze kroki odpadaja pierwsze
+    while (m_bytes > m_budget && m_position > 0) {
+        m_bytes -= m_steps.front().bytes;
+        m_steps.pop_front();
+        --m_position;
+    }
+    if (m_position == 0) {
+        m_open = false;
+    }
+}
+
+void ResultHistory::encode(const std::uint8_t* delta, std::size_t count, std::vector<std::uint8_t>& out) {
+    // Pary (dlugosc serii zer, literal); koncowe zera sa pomijane
+    out.clear();
+    std::size_t i = 0;
+    while (i < count) {
+        const std::size_t zeroBegin = i;
+        while (i < count && delta[i] == 0) {
+            ++i;
+        }
+        if (i == count) {
+            break;
+        }
+        
+        const std::size_t literalBegin = i;
+        std::size_t zeros = 0;
+        while (i < count && zeros < MinZeroRun) {
+            zeros = delta[i] == 0 ? zeros + 1 : 0;
+            ++i;
+        }
+        const std::size_t literalEnd = i - zeros;
+        
+        writeVarint(out, literalBegin - zeroBegin);
+        writeVarint(out, literalEnd - literalBegin);
+        out.insert(out.end(), delta + literalBegin, delta + literalEnd);
+        i = literalEnd;
+    }
+}
+
+void ResultHistory::apply(const std::vector<std::uint8_t>& data, std::uint8_t* pixels, std::size_t stride, const sf::IntRect& rect) {
+    const std::size_t rowBytes = static_cast<std::size_t>(rect.size.x) * 4;
+    const std::uint8_t* in = data.data();
+    const std::uint8_t* end = in + data.size();
+    std::size_t position = 0;
+    
+    while (in < end) {
+        position += readVarint(in);
+        std::size_t length = readVarint(in);
+        while (length > 0) {
+            const std::size_t row = position / rowBytes;
+            const std::size_t column = position % rowBytes;
+            const std::size_t chunk = std::min(length, rowBytes - column);
+            std::uint8_t* out = pixels + (static_cast<std::size_t>(rect.position.y) + row) * stride +
+                                static_cast<std::size_t>(rect.position.x) * 4 + column;
+            for (std::size_t i = 0; i < chunk; ++i) {
+                out[i] ^= in[i];
+            }
+            in += chunk;
+            position += chunk;
+            length -= chunk;
+        }
+    }
+}
+
+}
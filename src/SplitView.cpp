@@ -0,0 +1,187 @@
+#include "SplitView.h"
+#include "ImageResampler.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace MaskOverlay {
+
+SplitView::SplitView()
+    : m_size(0, 0)
+    , m_divider(0.5f)
+    , m_sourceGeneration(0)
+    , m_resultProcessor(nullptr)
+    , m_resultGeneration(0)
+    , m_resultRevision(0)
+{
+}
+
+void SplitView::update(const ImageProcessor& source, const ImageProcessor& result, const sf::FloatRect& area) {
+    if (!source.hasSourceImage() || source.getSourceImage().getSize().x == 0) {
+        clear();
+        return;
+    }
+
+    sf::Vector2u sourceSize = source.getSourceSize();
+    sf::Vector2u fitted = ImageResampler::fitSize(sourceSize, area.size);
+
+    // Pamiec podreczna nie jest wieksza niz zrodlo - male obrazy powieksza GPU
+    sf::Vector2u size(std::min(fitted.x, sourceSize.x), std::min(fitted.y, sourceSize.y));
+    bool resized = size != m_size || area != m_area;
+
+    if (resized) {
+        m_size = size;
+        m_area = area;
+        m_imageRect = sf::FloatRect(
+            area.position + (area.size - sf::Vector2f(fitted)) / 2.0f, sf::Vector2f(fitted));
+        m_source.valid = false;
+        m_result.valid = false;
+    }
+
+    const std::size_t bytes = static_cast<std::size_t>(size.x) * size.y * 4;
+    const sf::IntRect full({0, 0}, sf::Vector2i(size));
+
+    if (!m_source.valid || source.getSourceGeneration() != m_sourceGeneration) {
+        TraceScope trace("scaleSplitSource", "split");
+        m_source.pixels.resize(bytes);
+        ImageResampler::resizeArea(source.getSourceImage().getPixelsPtr(), sourceSize, m_source.pixels.data(), size, full);
+        uploadLayer(m_source);
+        m_sourceGeneration = source.getSourceGeneration();
+        m_result.valid = false;
+    }
+
+    const std::uint8_t* resultPixels = result.getResultPixels();
+    if (!result.hasResult() || !resultPixels) {
+        m_result.valid = false;
+        m_resultProcessor = nullptr;
+        return;
+    }
+
+    bool sameResult = m_result.valid && m_resultProcessor == &result &&
+                      m_resultGeneration == result.getResultGeneration();
+    if (sameResult && m_resultRevision == result.getResultRevision()) {
+        return;
+    }
+
+    TraceScope trace("scaleSplitResult", "split");
+    sf::IntRect region = full;
+    sf::Vector2u resultSize = result.getSourceSize();
+
+    // Jedno mieszanie od ostatniej synchronizacji - przeskalowany zostaje tylko jego obszar
+    if (sameResult && m_resultRevision + 1 == result.getResultRevision()) {
+        region = ImageResampler::mapRegion(result.getLastApplyRegion(), resultSize, size);
+    } else {
+        m_result.pixels.resize(bytes);
+    }
+    trace.addArg("width", region.size.x);
+    trace.addArg("height", region.size.y);
+
+    ImageResampler::resizeArea(resultPixels, resultSize, m_result.pixels.data(), size, region);
+    uploadLayer(m_result);
+
+    m_resultProcessor = &result;
+    m_resultGeneration = result.getResultGeneration();
+    m_resultRevision = result.getResultRevision();
+}
+
+void SplitView::draw(sf::RenderTarget& target) {
+    if (!m_source.valid) {
+        return;
+    }
+
+    const sf::Vector2f scale(m_imageRect.size.x / m_size.x, m_imageRect.size.y / m_size.y);
+    const int dividerColumn = m_result.valid
+        ? static_cast<int>(std::lround(m_divider * m_size.x))
+        : static_cast<int>(m_size.x);
+    const int height = static_cast<int>(m_size.y);
+
+    // Obie strony wycinane z tych samych tekstur - przesuwanie dzielnika nic nie przelicza
+    if (dividerColumn > 0) {
+        sf::Sprite before(m_source.texture, sf::IntRect({0, 0}, {dividerColumn, height}));
+        before.setScale(scale);
+        before.setPosition(m_imageRect.position);
+        target.draw(before);
+        Profiler::countDrawCall();
+    }
+
+    if (!m_result.valid) {
+        return;
+    }
+
+    if (dividerColumn < static_cast<int>(m_size.x)) {
+        sf::Sprite after(m_result.texture, sf::IntRect({dividerColumn, 0}, {static_cast<int>(m_size.x) - dividerColumn, height}));
+        after.setScale(scale);
+        after.setPosition(sf::Vector2f(m_imageRect.position.x + dividerColumn * scale.x, m_imageRect.position.y));
+        target.draw(after);
+        Profiler::countDrawCall();
+    }
+
+    sf::RectangleShape line(sf::Vector2f(2, m_imageRect.size.y));
+    line.setPosition(sf::Vector2f(m_imageRect.position.x + dividerColumn * scale.x - 1, m_imageRect.position.y));
+    line.setFillColor(sf::Color(255, 255, 255, 200));
+    target.draw(line);
+
+    sf::RectangleShape handle(sf::Vector2f(10, 30));
+    handle.setPosition(sf::Vector2f(line.getPosition().x - 4, m_imageRect.position.y + (m_imageRect.size.y - 30) / 2));
+    handle.setFillColor(sf::Color(230, 230, 230));
+    handle.setOutlineColor(sf::Color(60, 60, 65));
+    handle.setOutlineThickness(1);
+    target.draw(handle);
+    Profiler::countDrawCall();
+}
+
+void SplitView::clear() {
+    m_source = Layer();
+    m_result = Layer();
+    m_size = sf::Vector2u(0, 0);
+    m_resultProcessor = nullptr;
+}
+
+void SplitView::setDivider(float position) {
+    m_divider = std::clamp(position, 0.0f, 1.0f);
+}
+
+void SplitView::setDividerFromPoint(float x) {
+    if (m_imageRect.size.x > 0) {
+        setDivider((x - m_imageRect.position.x) / m_imageRect.size.x);
+    }
+}
+
+float SplitView::getDivider() const {
+    return m_divider;
+}
+
+bool SplitView::isOnDivider(const sf::Vector2f& point) const {
+    if (!m_result.valid) {
+        return false;
+    }
+
+    float x = m_imageRect.position.x + m_divider * m_imageRect.size.x;
+    return std::abs(point.x - x) <= 8 &&
+           point.y >= m_imageRect.position.y && point.y <= m_imageRect.position.y + m_imageRect.size.y;
+}
+
+sf::FloatRect SplitView::getImageRect() const {
+    return m_imageRect;
+}
+
+void SplitView::uploadLayer(Layer& layer) {
+    ProfileScope scope(ProfileStage::Upload);
+
+    if (layer.texture.getSize() != m_size) {
+        if (!layer.texture.resize(m_size)) {
+            std::cerr << "Nie można utworzyć tekstury podglądu " << m_size.x << "x" << m_size.y << std::endl;
+            layer.valid = false;
+            return;
+        }
+        layer.texture.setSmooth(true);
+    }
+
+    layer.texture.update(layer.pixels.data(), m_size, sf::Vector2u(0, 0));
+    Profiler::addCount(ProfileCounter::UploadBytes, static_cast<std::uint64_t>(layer.pixels.size()));
+    layer.valid = true;
+}
+
+}
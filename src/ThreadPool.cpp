@@ -0,0 +1,119 @@
+#include "ThreadPool.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <string>
+
+namespace MaskOverlay {
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : m_task(nullptr)
+    , m_count(0)
+    , m_chunkSize(1)
+    , m_nextIndex(0)
+    , m_busyWorkers(0)
+    , m_generation(0)
+    , m_stopping(false)
+{
+    if (threadCount == 0) {
+        threadCount = getHardwareThreadCount();
+    }
+    
+
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        m_workers.emplace_back([this, i]() {
+            Tracer::setThreadName("Watek roboczy " + std::to_string(i));
+            workerLoop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_all();
+    
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::getThreadCount() const {
+    return static_cast<unsigned int>(m_workers.size()) + 1;
+}
+
+unsigned int ThreadPool::getHardwareThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::parallelFor(std::size_t count,
+                             const std::function<void(std::size_t, std::size_t)>& task,
+                             std::size_t chunkSize) {
+    if (count == 0) {
+        return;
+    }
+    
+    if (chunkSize == 0) {
+        chunkSize = std::max<std::size_t>(1, count / (getThreadCount() * 4));
+    }
+    
+    if (m_workers.empty() || count <= chunkSize) {
+        for (std::size_t begin = 0; begin < count; begin += chunkSize) {
+            task(begin, std::min(count, begin + chunkSize));
+        }
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_chunkSize = chunkSize;
+        m_nextIndex.store(0, std::memory_order_relaxed);
+        m_busyWorkers = static_cast<unsigned int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wakeCondition.notify_all();
+    
+    runChunks();
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    std::uint64_t seenGeneration = 0;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [&]() { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+        
+        runChunks();
+        
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_busyWorkers;
+        }
+        m_doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::runChunks() {
+    while (true) {
+        std::size_t begin = m_nextIndex.fetch_add(m_chunkSize, std::memory_order_relaxed);
+        if (begin >= m_count) {
+            break;
+        }
+        (*m_task)(begin, std::min(m_count, begin + m_chunkSize));
+    }
+}
+
+}
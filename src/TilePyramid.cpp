@@ -0,0 +1,270 @@
+#include "TilePyramid.h"
+#include "Profiler.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace MaskOverlay {
+
+TilePyramid::TilePyramid(unsigned int tileSize)
+    : m_pixels(nullptr)
+    , m_size(0, 0)
+    , m_tileSize(std::max(16u, tileSize))
+    , m_maxTiles(96)
+    , m_frame(0)
+{
+}
+
+void TilePyramid::setImage(const std::uint8_t* pixels, const sf::Vector2u& size) {
+    if (size != m_size) {
+        clear();
+        m_size = size;
+
+        Level base;
+        base.size = size;
+        base.built = true;
+        m_levels.push_back(std::move(base));
+
+        while (m_levels.back().size.x > m_tileSize || m_levels.back().size.y > m_tileSize) {
+            Level level;
+            level.size = sf::Vector2u((m_levels.back().size.x + 1) / 2, (m_levels.back().size.y + 1) / 2);
+            m_levels.push_back(std::move(level));
+        }
+    }
+
+    // Bufor poziomu 0 nalezy do wywolujacego; zmienione obszary zglasza invalidate()
+    m_pixels = pixels;
+}
+
+void TilePyramid::invalidate(const sf::IntRect& rect) {
+    std::optional<sf::IntRect> clipped = rect.findIntersection(sf::IntRect({0, 0}, sf::Vector2i(m_size)));
+    if (!clipped) {
+        return;
+    }
+
+    for (unsigned int level = 1; level < m_levels.size(); ++level) {
+        Level& current = m_levels[level];
+        if (!current.built) {
+            continue;
+        }
+
+        int scale = 1 << level;
+        int left = clipped->position.x / scale;
+        int top = clipped->position.y / scale;
+        int right = std::min(static_cast<int>(current.size.x), (clipped->position.x + clipped->size.x + scale - 1) / scale);
+        int bottom = std::min(static_cast<int>(current.size.y), (clipped->position.y + clipped->size.y + scale - 1) / scale);
+        current.dirty.add(sf::IntRect({left, top}, {right - left, bottom - top}));
+    }
+
+    for (auto& entry : m_tiles) {
+        Tile& tile = entry.second;
+        int scale = 1 << tile.level;
+        sf::IntRect baseRect(tile.rect.position * scale, tile.rect.size * scale);
+        if (baseRect.findIntersection(*clipped)) {
+            tile.stale = true;
+        }
+    }
+}
+
+void TilePyramid::invalidateAll() {
+    for (unsigned int level = 1; level < m_levels.size(); ++level) {
+        m_levels[level].built = false;
+        m_levels[level].dirty.clear();
+    }
+    for (auto& entry : m_tiles) {
+        entry.second.stale = true;
+    }
+}
+
+void TilePyramid::clear() {
+    m_levels.clear();
+    m_tiles.clear();
+    m_pixels = nullptr;
+    m_size = sf::Vector2u(0, 0);
+}
+
+void TilePyramid::draw(sf::RenderTarget& target, const sf::FloatRect& area, const sf::Vector2f& center, float zoom) {
+    if (!m_pixels || m_levels.empty() || zoom <= 0) {
+        return;
+    }
+
+    TraceScope trace("drawTiles", "gpu");
+    ++m_frame;
+
+    // Najmniejszy poziom, ktory nie jest pomniejszany na ekranie wiecej niz 2x
+    unsigned int level = 0;
+    while (level + 1 < m_levels.size() && static_cast<float>(1u << (level + 1)) * zoom <= 1.0f) {
+        ++level;
+    }
+    ensureLevel(level);
+
+    const Level& current = m_levels[level];
+    const float levelScale = static_cast<float>(1u << level);
+    const sf::Vector2f areaCenter = area.position + area.size / 2.0f;
+    const sf::Vector2f halfSize(area.size.x / (2 * zoom), area.size.y / (2 * zoom));
+
+    const int tilesX = static_cast<int>((current.size.x + m_tileSize - 1) / m_tileSize);
+    const int tilesY = static_cast<int>((current.size.y + m_tileSize - 1) / m_tileSize);
+    const float tileExtent = m_tileSize * levelScale;
+    const int firstX = std::max(0, static_cast<int>(std::floor((center.x - halfSize.x) / tileExtent)));
+    const int firstY = std::max(0, static_cast<int>(std::floor((center.y - halfSize.y) / tileExtent)));
+    const int lastX = std::min(tilesX - 1, static_cast<int>(std::floor((center.x + halfSize.x) / tileExtent)));
+    const int lastY = std::min(tilesY - 1, static_cast<int>(std::floor((center.y + halfSize.y) / tileExtent)));
+
+    trace.addArg("level", static_cast<long long>(level));
+    trace.addArg("tiles", static_cast<long long>(std::max(0, lastX - firstX + 1)) * std::max(0, lastY - firstY + 1));
+
+    for (int ty = firstY; ty <= lastY; ++ty) {
+        for (int tx = firstX; tx <= lastX; ++tx) {
+            Tile& tile = m_tiles[tileKey(level, static_cast<unsigned int>(tx), static_cast<unsigned int>(ty))];
+            if (tile.stale) {
+                sf::Vector2i position(tx * static_cast<int>(m_tileSize), ty * static_cast<int>(m_tileSize));
+                sf::IntRect rect(position, sf::Vector2i(
+                    std::min(static_cast<int>(m_tileSize), static_cast<int>(current.size.x) - position.x),
+                    std::min(static_cast<int>(m_tileSize), static_cast<int>(current.size.y) - position.y)));
+                uploadTile(tile, level, rect);
+            }
+            tile.lastUsed = m_frame;
+
+            sf::Sprite sprite(tile.texture);
+            sprite.setScale(sf::Vector2f(zoom * levelScale, zoom * levelScale));
+            sprite.setPosition(areaCenter + (sf::Vector2f(tile.rect.position) * levelScale - center) * zoom);
+            target.draw(sprite);
+            Profiler::countDrawCall();
+        }
+    }
+
+    evictTiles();
+}
+
+sf::Vector2u TilePyramid::getSize() const {
+    return m_size;
+}
+
+unsigned int TilePyramid::getLevelCount() const {
+    return static_cast<unsigned int>(m_levels.size());
+}
+
+void TilePyramid::setMaxTiles(std::size_t maxTiles) {
+    m_maxTiles = std::max<std::size_t>(1, maxTiles);
+}
+
+sf::Vector2u TilePyramid::getLevelSize(unsigned int level) const {
+    return m_levels[level].size;
+}
+
+const std::uint8_t* TilePyramid::getLevelPixels(unsigned int level) {
+    // Poziom jest najpierw dobudowywany z zalegle uniewaznionych obszarow
+    ensureLevel(level);
+    return level == 0 ? m_pixels : m_levels[level].pixels.data();
+}
+
+void TilePyramid::ensureLevel(unsigned int level) {
+    if (level == 0) {
+        return;
+    }
+
+    Level& current = m_levels[level];
+    if (current.built && current.dirty.isEmpty()) {
+        return;
+    }
+
+    ensureLevel(level - 1);
+
+    if (!current.built) {
+        TraceScope trace("buildLevel", "gpu");
+        trace.addArg("level", static_cast<long long>(level));
+        current.pixels.resize(static_cast<std::size_t>(current.size.x) * current.size.y * 4);
+        downsample(level, sf::IntRect({0, 0}, sf::Vector2i(current.size)));
+        current.built = true;
+    } else {
+        for (const auto& rect : current.dirty.getRects()) {
+            downsample(level, rect);
+        }
+    }
+    current.dirty.clear();
+}
+
+void TilePyramid::downsample(unsigned int level, const sf::IntRect& rect) {
+    const Level& previous = m_levels[level - 1];
+    Level& current = m_levels[level];
+    const std::uint8_t* source = getLevelPixels(level - 1);
+    std::uint8_t* result = current.pixels.data();
+    const std::size_t sourceStride = static_cast<std::size_t>(previous.size.x) * 4;
+    const unsigned int lastX = previous.size.x - 1;
+    const unsigned int lastY = previous.size.y - 1;
+
+    for (int y = rect.position.y; y < rect.position.y + rect.size.y; ++y) {
+        const std::uint8_t* row0 = source + std::min(2u * y, lastY) * sourceStride;
+        const std::uint8_t* row1 = source + std::min(2u * y + 1, lastY) * sourceStride;
+        std::uint8_t* out = result + (static_cast<std::size_t>(y) * current.size.x + rect.position.x) * 4;
+
+        for (int x = rect.position.x; x < rect.position.x + rect.size.x; ++x) {
+            const std::size_t left = static_cast<std::size_t>(std::min(2u * x, lastX)) * 4;
+            const std::size_t right = static_cast<std::size_t>(std::min(2u * x + 1, lastX)) * 4;
+            for (int c = 0; c < 4; ++c) {
+                unsigned int sum = row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c];
+                out[c] = static_cast<std::uint8_t>((sum + 2) / 4);
+            }
+            out += 4;
+        }
+    }
+}
+
+void TilePyramid::uploadTile(Tile& tile, unsigned int level, const sf::IntRect& rect) {
+    sf::Vector2u size(rect.size);
+    if (tile.texture.getSize() != size) {
+        if (!tile.texture.resize(size)) {
+            std::cerr << "Nie można utworzyć kafelka " << size.x << "x" << size.y << std::endl;
+            return;
+        }
+        tile.texture.setSmooth(true);
+    }
+
+    const std::uint8_t* pixels = getLevelPixels(level);
+    const std::size_t stride = static_cast<std::size_t>(m_levels[level].size.x) * 4;
+    const std::size_t rowBytes = static_cast<std::size_t>(size.x) * 4;
+    m_uploadBuffer.resize(rowBytes * size.y);
+
+    for (unsigned int y = 0; y < size.y; ++y) {
+        std::memcpy(&m_uploadBuffer[y * rowBytes],
+                    pixels + (static_cast<std::size_t>(rect.position.y) + y) * stride + static_cast<std::size_t>(rect.position.x) * 4,
+                    rowBytes);
+    }
+
+    tile.texture.update(m_uploadBuffer.data(), size, sf::Vector2u(0, 0));
+    Profiler::addCount(ProfileCounter::UploadBytes, static_cast<std::uint64_t>(m_uploadBuffer.size()));
+
+    tile.level = level;
+    tile.rect = rect;
+    tile.stale = false;
+}
+
+void TilePyramid::evictTiles() {
+    if (m_tiles.size() <= m_maxTiles) {
+        return;
+    }
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> candidates;
+    for (const auto& entry : m_tiles) {
+        if (entry.second.lastUsed < m_frame) {
+            candidates.emplace_back(entry.second.lastUsed, entry.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& candidate : candidates) {
+        if (m_tiles.size() <= m_maxTiles) {
+            break;
+        }
+        m_tiles.erase(candidate.second);
+    }
+}
+
+std::uint64_t TilePyramid::tileKey(unsigned int level, unsigned int x, unsigned int y) {
+    return (static_cast<std::uint64_t>(level) << 48) | (static_cast<std::uint64_t>(y) << 24) | x;
+}
+
+}
@@ -0,0 +1,184 @@
+#include "Tracer.h"
+#include <mutex>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace MaskOverlay {
+
+namespace {
+
+struct TracerState {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::size_t capacity = 65536;
+    std::size_t next = 0;
+    std::map<std::uint32_t, std::string> threadNames;
+};
+
+TracerState& state() {
+    static TracerState instance;
+    return instance;
+}
+
+std::atomic<std::uint32_t> g_nextThreadId{1};
+
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+}
+
+void Tracer::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::setCapacity(std::size_t capacity) {
+    TracerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.capacity = std::max<std::size_t>(1, capacity);
+    s.events.clear();
+    s.next = 0;
+}
+
+void Tracer::record(TraceEvent&& event) {
+    TracerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    
+    if (s.events.size() < s.capacity) {
+        s.events.push_back(std::move(event));
+        return;
+    }
+    
+    s.events[s.next] = std::move(event);
+    s.next = (s.next + 1) % s.capacity;
+}
+
+void Tracer::clear() {
+    TracerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.events.clear();
+    s.next = 0;
+}
+
+bool Tracer::dumpChromeTrace(const std::string& path) {
+    std::vector<TraceEvent> events;
+    std::map<std::uint32_t, std::string> threadNames;
+    
+    {
+        TracerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        events.reserve(s.events.size());
+        for (std::size_t i = 0; i < s.events.size(); ++i) {
+            events.push_back(s.events[(s.next + i) % s.events.size()]);
+        }
+        threadNames = s.threadNames;
+    }
+    
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Nie można zapisać śladu do: " << path << std::endl;
+        return false;
+    }
+    
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    
+    bool first = true;
+    for (const auto& thread : threadNames) {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.first
+             << ",\"args\":{\"name\":\"" << escapeJson(thread.second) << "\"}}";
+        first = false;
+    }
+    
+    for (const auto& event : events) {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"" << escapeJson(event.name) << "\""
+             << ",\"cat\":\"" << escapeJson(event.category) << "\""
+             << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+             << ",\"ts\":" << event.start
+             << ",\"dur\":" << event.duration
+             << ",\"args\":{" << event.args << "}}";
+        first = false;
+    }
+    
+    file << "\n]}\n";
+    
+    std::cout << "Zapisano ślad (" << events.size() << " zdarzeń) do: " << path << std::endl;
+    return true;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    TracerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.threadNames[getThreadId()] = name;
+}
+
+std::uint32_t Tracer::getThreadId() {
+    thread_local std::uint32_t id = g_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+std::int64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+TraceScope::TraceScope(const char* name, const char* category)
+    : m_active(Tracer::isEnabled())
+{
+    if (m_active) {
+        m_event.name = name;
+        m_event.category = category;
+        m_event.threadId = Tracer::getThreadId();
+        m_event.start = Tracer::now();
+    }
+}
+
+TraceScope::~TraceScope() {
+    if (m_active) {
+        m_event.duration = Tracer::now() - m_event.start;
+        Tracer::record(std::move(m_event));
+    }
+}
+
+void TraceScope::addArg(const char* key, long long value) {
+    if (!m_active) {
+        return;
+    }
+    if (!m_event.args.empty()) {
+        m_event.args += ",";
+    }
+    m_event.args += "\"" + escapeJson(key) + "\":" + std::to_string(value);
+}
+
+void TraceScope::addArg(const char* key, const std::string& value) {
+    if (!m_active) {
+        return;
+    }
+    if (!m_event.args.empty()) {
+        m_event.args += ",";
+    }
+    m_event.args += "\"" + escapeJson(key) + "\":\"" + escapeJson(value) + "\"";
+}
+
+}
@@ -1,7 +1,13 @@
 #include "Application.h"
+#include "CommandLine.h"
 #include <iostream>
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (MaskOverlay::CommandLine::isHeadless(argc, argv)) {
+        MaskOverlay::CommandLine commandLine(argc, argv);
+        return commandLine.run();
+    }
+    
     std::cout << "=== Nakładanie masek ===" << std::endl;
     std::cout << "Projekt - Interfejsy użytkownika i biblioteki graficzne" << std::endl;
     std::cout << std::endl;
@@ -0,0 +1,1305 @@
+#include "ImageProcessor.h"
+#include "BlendMode.h"
+#include "PreciseProcessor.h"
+#include "ImageResampler.h"
+#include "TilePyramid.h"
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <vector>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+using namespace MaskOverlay;
+
+namespace {
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+};
+
+class Random {
+public:
+    explicit Random(std::uint32_t seed) : m_state(seed ? seed : 1) {}
+
+    std::uint32_t next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    int range(int min, int max) {
+        return min + static_cast<int>(next() % static_cast<std::uint32_t>(max - min + 1));
+    }
+
+    std::uint8_t byte() {
+        return static_cast<std::uint8_t>(next() >> 24);
+    }
+
+private:
+    std::uint32_t m_state;
+};
+
+struct Engine {
+    std::string name;
+    std::function<void(ImageProcessor&)> configure;
+    bool incremental = false;
+};
+
+struct Deviation {
+    int channel[4] = {0, 0, 0, 0};
+    long long pixels = 0;
+
+    int max() const {
+        return *std::max_element(channel, channel + 4);
+    }
+
+    void merge(const Deviation& other) {
+        for (int c = 0; c < 4; ++c) {
+            channel[c] = std::max(channel[c], other.channel[c]);
+        }
+        pixels += other.pixels;
+    }
+};
+
+struct Case {
+    sf::Image source;
+    sf::Image mask;
+    sf::Vector2i offset;
+    BlendModeType mode;
+    sf::Color key;
+    bool useAlpha;
+    int tolerance = BlendMode::DefaultTolerance;
+    std::uint8_t opacity = 255;
+    bool linear = false;
+    MaskWrap wrap = MaskWrap::None;
+    int softness = 0;
+    bool despill = false;
+    int feather = 0;
+};
+
+// Wspolrzedna w masce powtarzanej: modulo na kazdym pikselu
+int wrapCoordinate(int coordinate, int size, bool mirror) {
+    int period = mirror ? 2 * size : size;
+    int index = ((coordinate % period) + period) % period;
+    return index < size ? index : period - 1 - index;
+}
+
+// Wyrocznia niezalezna od BlendMode: zamrozona kopia wzorow kanalow w skali 0..one
+// (255 z gamma, 4095 w swietle liniowym); zmiana w BlendMode nie zmienia referencji
+constexpr int OracleLinearOne = 4095;
+
+int oracleChannel(BlendModeType mode, int base, int blend, int one) {
+    switch (mode) {
+        case BlendModeType::Replace:
+            return blend;
+        case BlendModeType::Add:
+            return base + blend;
+        case BlendModeType::Multiply:
+            return (base * blend) / one;
+        case BlendModeType::Screen:
+            return one - ((one - base) * (one - blend)) / one;
+        case BlendModeType::Overlay:
+            return 2 * base <= one ? (2 * base * blend) / one : one - (2 * (one - base) * (one - blend)) / one;
+        case BlendModeType::Difference:
+            return std::abs(base - blend);
+        case BlendModeType::SoftLight: {
+            float b = static_cast<float>(base) / static_cast<float>(one);
+            float l = static_cast<float>(blend) / static_cast<float>(one);
+            float result;
+            if (l < 0.5f) {
+                result = b - (1 - 2 * l) * b * (1 - b);
+            } else {
+                float d = (b <= 0.25f) ? ((16 * b - 12) * b + 4) * b : std::sqrt(b);
+                result = b + (2 * l - 1) * (d - b);
+            }
+            return static_cast<int>(result * static_cast<float>(one));
+        }
+        case BlendModeType::HardLight:
+            return 2 * blend <= one ? (2 * base * blend) / one : one - (2 * (one - base) * (one - blend)) / one;
+        case BlendModeType::Darken:
+            return std::min(base, blend);
+        case BlendModeType::Lighten:
+            return std::max(base, blend);
+        case BlendModeType::ColorDodge:
+            return base <= 0 ? 0 : blend >= one ? one : (base * one) / (one - blend);
+        case BlendModeType::ColorBurn:
+            return base >= one ? one : blend <= 0 ? 0 : one - ((one - base) * one) / blend;
+        case BlendModeType::LinearBurn:
+            return base + blend - one;
+        case BlendModeType::Exclusion:
+            return base + blend - (2 * base * blend) / one;
+        case BlendModeType::Subtract:
+            return base - blend;
+    }
+    return blend;
+}
+
+int oracleToLinear(int value) {
+    double c = value / 255.0;
+    double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    return static_cast<int>(std::lround(linear * OracleLinearOne));
+}
+
+std::uint8_t oracleFromLinear(int value) {
+    double linear = static_cast<double>(std::clamp(value, 0, OracleLinearOne)) / OracleLinearOne;
+    double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+    return static_cast<std::uint8_t>(std::clamp(static_cast<int>(std::lround(c * 255)), 0, 255));
+}
+
+// Tolerancja spoza zakresu liczy sie jak obcieta do 0..255
+bool oracleTransparent(const sf::Color& mask, const Case& test) {
+    const int tolerance = std::clamp(test.tolerance, 0, 255);
+    return mask.a == 0 ||
+           (std::abs(mask.r - test.key.r) <= tolerance &&
+            std::abs(mask.g - test.key.g) <= tolerance &&
+            std::abs(mask.b - test.key.b) <= tolerance);
+}
+
+// Krycie po kryciu warstwy; 0 - piksel maski nie zmienia zrodla
+int oracleCoverage(const sf::Color& mask, const Case& test) {
+    if (oracleTransparent(mask, test)) {
+        return 0;
+    }
+    return ((test.useAlpha ? mask.a : 255) * test.opacity + 127) / 255;
+}
+
+// Wynik trybu przed mieszaniem z kryciem; clipped - funkcja kanalu wyszla poza zakres
+sf::Color oracleMode(const sf::Color& source, const sf::Color& mask, const Case& test, bool* clipped = nullptr) {
+    const int one = test.linear ? OracleLinearOne : 255;
+    std::uint8_t result[3];
+    const std::uint8_t base[3] = {source.r, source.g, source.b};
+    const std::uint8_t blend[3] = {mask.r, mask.g, mask.b};
+    for (int c = 0; c < 3; ++c) {
+        const int value = test.linear
+            ? oracleChannel(test.mode, oracleToLinear(base[c]), oracleToLinear(blend[c]), one)
+            : oracleChannel(test.mode, base[c], blend[c], one);
+        if (clipped) {
+            *clipped |= value < 0 || value > one;
+        }
+        result[c] = test.linear ? oracleFromLinear(value) : static_cast<std::uint8_t>(std::clamp(value, 0, 255));
+    }
+    return sf::Color(result[0], result[1], result[2], 255);
+}
+
+// Wynik trybu zmieszany ze zrodlem przy pokryciu po kryciu warstwy
+sf::Color oracleMix(const sf::Color& source, const sf::Color& blended, int coverage, const Case& test) {
+    if (coverage == 0) {
+        return source;
+    }
+    if (coverage == 255) {
+        return blended;
+    }
+
+    auto mix = [&](std::uint8_t s, std::uint8_t b) {
+        if (test.linear) {
+            return oracleFromLinear((oracleToLinear(s) * (255 - coverage) + oracleToLinear(b) * coverage + 127) / 255);
+        }
+        float a = coverage / 255.0f;
+        return static_cast<std::uint8_t>(std::clamp(static_cast<int>(s * (1 - a) + b * a), 0, 255));
+    };
+    return sf::Color(mix(source.r, blended.r), mix(source.g, blended.g), mix(source.b, blended.b), 255);
+}
+
+sf::Color oracleBlend(const sf::Color& source, const sf::Color& mask, const Case& test) {
+    const int coverage = oracleCoverage(mask, test);
+    return coverage == 0 ? source : oracleMix(source, oracleMode(source, mask, test), coverage, test);
+}
+
+// Pierwotny algorytm applyMask: piksel po pikselu przez wyrocznie
+sf::Image referenceApplyMask(const Case& test) {
+    sf::Vector2u sourceSize = test.source.getSize();
+    sf::Vector2u maskSize = test.mask.getSize();
+    sf::Image result(sourceSize, sf::Color::Transparent);
+
+    for (unsigned int y = 0; y < sourceSize.y; ++y) {
+        for (unsigned int x = 0; x < sourceSize.x; ++x) {
+            sf::Color sourcePixel = test.source.getPixel(sf::Vector2u(x, y));
+            int maskX = static_cast<int>(x) + test.offset.x;
+            int maskY = static_cast<int>(y) + test.offset.y;
+            if (test.wrap != MaskWrap::None) {
+                maskX = wrapCoordinate(maskX, static_cast<int>(maskSize.x), test.wrap == MaskWrap::Mirror);
+                maskY = wrapCoordinate(maskY, static_cast<int>(maskSize.y), test.wrap == MaskWrap::Mirror);
+            }
+
+            if (maskX >= 0 && maskX < static_cast<int>(maskSize.x) &&
+                maskY >= 0 && maskY < static_cast<int>(maskSize.y)) {
+                sf::Color maskPixel = test.mask.getPixel(sf::Vector2u(
+                    static_cast<unsigned int>(maskX), static_cast<unsigned int>(maskY)));
+                result.setPixel(sf::Vector2u(x, y), oracleBlend(sourcePixel, maskPixel, test));
+            } else {
+                result.setPixel(sf::Vector2u(x, y), sourcePixel);
+            }
+        }
+    }
+
+    return result;
+}
+
+Deviation compare(const sf::Image& expected, const sf::Image& actual) {
+    Deviation deviation;
+    if (expected.getSize() != actual.getSize()) {
+        for (int c = 0; c < 4; ++c) {
+            deviation.channel[c] = 255;
+        }
+        return deviation;
+    }
+
+    const std::uint8_t* e = expected.getPixelsPtr();
+    const std::uint8_t* a = actual.getPixelsPtr();
+    std::size_t count = static_cast<std::size_t>(expected.getSize().x) * expected.getSize().y;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        bool differs = false;
+        for (int c = 0; c < 4; ++c) {
+            int d = std::abs(static_cast<int>(e[i * 4 + c]) - static_cast<int>(a[i * 4 + c]));
+            deviation.channel[c] = std::max(deviation.channel[c], d);
+            differs |= d != 0;
+        }
+        if (differs) {
+            ++deviation.pixels;
+        }
+    }
+
+    return deviation;
+}
+
+Deviation runCase(ImageProcessor& processor, const Engine& engine, const Case& test, const sf::Image& expected) {
+    engine.configure(processor);
+    processor.setLinearLight(test.linear);
+    processor.setSourceImage(test.source);
+    processor.setMask(test.mask);
+    processor.setMaskWrap(test.wrap);
+    
+    if (engine.incremental) {
+        // Dwa poprzednie wyniki z innymi przesunieciami i trybami - kolejne zastosowanie liczy tylko
+        // zmieniony obszar, a bufor tylny i przedni pamietaja rozne obszary maski; druga
+        // rozni sie od testu tylko tolerancja, wiec pokrycie klucza musi zostac przeliczone
+        // Pierwszy z nich z innym sposobem powtarzania maski
+        processor.setMaskWrap(test.wrap == MaskWrap::None ? MaskWrap::Repeat : MaskWrap::None);
+        processor.setMaskOffset(test.offset.x / 2 - 7, test.offset.y / 3 + 5);
+        processor.applyMask(BlendModeType::Difference, sf::Color::Black, !test.useAlpha);
+        processor.setMaskWrap(test.wrap);
+        processor.setMaskOffset(test.offset.x + 11, test.offset.y - 13);
+        processor.applyMask(BlendModeType::Screen, test.key, test.useAlpha, test.tolerance + 3);
+    }
+    
+    processor.setMaskOffset(test.offset.x, test.offset.y);
+    processor.applyMask(test.mode, test.key, test.useAlpha, test.tolerance, test.opacity);
+    return compare(expected, processor.getResultImage());
+}
+
+// Sciezka 16-bit/float liczy w innym kwantowaniu - po zaokragleniu do 8 bitow ma sie
+// roznic od referencji najwyzej o tyle poziomow
+constexpr int PreciseTolerance = 2;
+
+Deviation runPreciseCase(PreciseProcessor& processor, const Case& test, const sf::Image& expected) {
+    PreciseImage source;
+    PreciseImage mask;
+    source.assign(test.source, processor.getFormat());
+    mask.assign(test.mask, processor.getFormat());
+    processor.setSourceImage(source);
+    processor.setMask(mask);
+    processor.setMaskOffset(test.offset.x, test.offset.y);
+    processor.applyMask(test.mode, test.key, test.useAlpha, test.tolerance, test.opacity);
+    return compare(expected, processor.getResult().toImage());
+}
+
+// Wszystkie pary (zrodlo, maska) 256x256 dla kazdego kanalu
+std::vector<Case> exhaustiveCases() {
+    std::vector<Case> cases;
+    const std::uint8_t alphas[] = {255, 254, 128, 1};
+
+    for (BlendModeType mode : BlendMode::getAllModes()) {
+        for (std::uint8_t alpha : alphas) {
+            for (bool useAlpha : {true, false}) {
+                if (!useAlpha && alpha != 128) {
+                    continue;
+                }
+
+                Case test;
+                test.source.resize(sf::Vector2u(256, 256));
+                test.mask.resize(sf::Vector2u(256, 256));
+                for (unsigned int y = 0; y < 256; ++y) {
+                    for (unsigned int x = 0; x < 256; ++x) {
+                        test.source.setPixel(sf::Vector2u(x, y), sf::Color(
+                            static_cast<std::uint8_t>(x), static_cast<std::uint8_t>(y),
+                            static_cast<std::uint8_t>(255 - x), 255));
+                        test.mask.setPixel(sf::Vector2u(x, y), sf::Color(
+                            static_cast<std::uint8_t>(y), static_cast<std::uint8_t>(x),
+                            static_cast<std::uint8_t>(255 - y), alpha));
+                    }
+                }
+                test.offset = sf::Vector2i(0, 0);
+                test.mode = mode;
+                test.key = sf::Color::Magenta;
+                test.useAlpha = useAlpha;
+
+                // Maska przesunieta poza lewy gorny i poza prawy dolny rog - obciecie zakresu kolumn i wierszy
+                if (useAlpha && alpha == 255) {
+                    for (sf::Vector2i offset : {sf::Vector2i(-37, -91), sf::Vector2i(83, 140)}) {
+                        Case shifted = test;
+                        shifted.offset = offset;
+                        cases.push_back(std::move(shifted));
+                    }
+                }
+
+                // Swiatlo liniowe dla pelnego krycia i mieszania z alfa
+                if (useAlpha && (alpha == 255 || alpha == 128)) {
+                    Case linear = test;
+                    linear.linear = true;
+                    cases.push_back(std::move(linear));
+                }
+                cases.push_back(std::move(test));
+            }
+        }
+    }
+
+    return cases;
+}
+
+std::vector<Case> randomCases(int count) {
+    std::vector<Case> cases;
+    Random random(2024);
+    auto modes = BlendMode::getAllModes();
+
+    for (int i = 0; i < count; ++i) {
+        Case test;
+        sf::Vector2u sourceSize(random.range(1, 300), random.range(1, 200));
+        sf::Vector2u maskSize(random.range(1, 400), random.range(1, 300));
+
+        test.key = sf::Color(random.byte(), random.byte(), random.byte());
+        test.mode = modes[random.next() % modes.size()];
+        test.useAlpha = random.next() % 2 == 0;
+        test.offset = sf::Vector2i(random.range(-static_cast<int>(sourceSize.x), static_cast<int>(maskSize.x)),
+                                   random.range(-static_cast<int>(sourceSize.y), static_cast<int>(maskSize.y)));
+
+        test.source.resize(sourceSize);
+        for (unsigned int y = 0; y < sourceSize.y; ++y) {
+            for (unsigned int x = 0; x < sourceSize.x; ++x) {
+                test.source.setPixel(sf::Vector2u(x, y),
+                    sf::Color(random.byte(), random.byte(), random.byte(), random.byte()));
+            }
+        }
+
+        test.mask.resize(maskSize);
+        for (unsigned int y = 0; y < maskSize.y; ++y) {
+            for (unsigned int x = 0; x < maskSize.x; ++x) {
+                sf::Color color(random.byte(), random.byte(), random.byte(), 255);
+                switch (random.next() % 6) {
+                    case 0:
+                        color = sf::Color(test.key.r, test.key.g, test.key.b, color.a);
+                        break;
+                    case 1:
+                        color.r = static_cast<std::uint8_t>(std::clamp(test.key.r + random.range(-12, 12), 0, 255));
+                        color.g = static_cast<std::uint8_t>(std::clamp(test.key.g + random.range(-12, 12), 0, 255));
+                        color.b = static_cast<std::uint8_t>(std::clamp(test.key.b + random.range(-12, 12), 0, 255));
+                        break;
+                    case 2:
+                        color.a = random.byte();
+                        break;
+                    case 3:
+                        color.a = 0;
+                        break;
+                    default:
+                        break;
+                }
+                test.mask.setPixel(sf::Vector2u(x, y), color);
+            }
+        }
+
+        // Domyslna tolerancja, dokladny klucz, szeroki zakres albo wartosc spoza 0..255
+        const int tolerances[] = {BlendMode::DefaultTolerance, 0, 4, 25, -5, 300};
+        test.tolerance = tolerances[random.next() % 6];
+
+        // Pelne krycie (sciezka bez skalowania), zerowe (kopia zrodla) albo dowolne
+        switch (random.next() % 4) {
+            case 0:
+                test.opacity = 0;
+                break;
+            case 1:
+                test.opacity = random.byte();
+                break;
+            default:
+                test.opacity = 255;
+                break;
+        }
+
+        test.linear = random.next() % 3 == 0;
+
+        cases.push_back(std::move(test));
+    }
+
+    return cases;
+}
+
+// Maski powtarzane i odbijane: waskie (powielane w pamieci podrecznej) i szerokie,
+// z przesunieciami wiekszymi niz maska w obu kierunkach
+std::vector<Case> wrappedCases(int count) {
+    std::vector<Case> cases;
+    Random random(4096);
+    auto modes = BlendMode::getAllModes();
+
+    for (int i = 0; i < count; ++i) {
+        Case test;
+        sf::Vector2u sourceSize(random.range(1, 700), random.range(1, 120));
+        sf::Vector2u maskSize(random.next() % 2 ? random.range(1, 40) : random.range(200, 300), random.range(1, 50));
+
+        test.key = sf::Color(random.byte(), random.byte(), random.byte());
+        test.mode = modes[random.next() % modes.size()];
+        test.useAlpha = random.next() % 2 == 0;
+        test.wrap = random.next() % 2 ? MaskWrap::Repeat : MaskWrap::Mirror;
+        test.offset = sf::Vector2i(random.range(-1000, 1000), random.range(-1000, 1000));
+        test.opacity = random.next() % 4 == 0 ? random.byte() : 255;
+        test.linear = random.next() % 3 == 0;
+
+        test.source.resize(sourceSize);
+        for (unsigned int y = 0; y < sourceSize.y; ++y) {
+            for (unsigned int x = 0; x < sourceSize.x; ++x) {
+                test.source.setPixel(sf::Vector2u(x, y),
+                    sf::Color(random.byte(), random.byte(), random.byte(), random.byte()));
+            }
+        }
+
+        test.mask.resize(maskSize);
+        for (unsigned int y = 0; y < maskSize.y; ++y) {
+            for (unsigned int x = 0; x < maskSize.x; ++x) {
+                sf::Color color(random.byte(), random.byte(), random.byte(), random.byte());
+                if (random.next() % 4 == 0) {
+                    color = sf::Color(test.key.r, test.key.g, test.key.b, 255);
+                }
+                test.mask.setPixel(sf::Vector2u(x, y), color);
+            }
+        }
+
+        cases.push_back(std::move(test));
+    }
+
+    return cases;
+}
+
+// Kolejne wyniki na jednym zrodle; cofanie i ponawianie ma je odtworzyc co do bajtu
+bool checkHistory(const std::vector<Case>& cases, std::ostream& console) {
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+    processor.setThreadCount(3);
+    const sf::Image& source = cases[0].source;
+    processor.setSourceImage(source);
+
+    std::vector<sf::Image> states = {source};
+    for (size_t i = 1; i < cases.size(); ++i) {
+        const Case& test = cases[i];
+        processor.setMask(test.mask);
+        processor.setMaskOffset(test.offset.x / 2, test.offset.y / 2);
+        if (i % 3 == 0) {
+            // Dwa zastosowania bez zamkniecia kroku - jeden krok historii
+            processor.applyMask(BlendModeType::Difference, test.key, test.useAlpha, test.tolerance);
+        }
+        processor.applyMask(test.mode, test.key, test.useAlpha, test.tolerance, test.opacity);
+        processor.closeHistoryStep();
+        if (compare(states.back(), processor.getResultImage()).max() != 0) {
+            states.push_back(processor.getResultImage());
+        }
+    }
+
+    int failures = 0;
+    for (size_t i = states.size() - 1; i-- > 0;) {
+        failures += !processor.undo() || compare(states[i], processor.getResultImage()).max() != 0;
+    }
+    failures += processor.canUndo();
+    for (size_t i = 1; i < states.size(); ++i) {
+        failures += !processor.redo() || compare(states[i], processor.getResultImage()).max() != 0;
+    }
+    failures += processor.canRedo();
+
+    // Zmiana po cofnieciu usuwa kroki do ponowienia; przy zbyt malym budzecie historia jest pusta
+    processor.undo();
+    processor.setMaskOffset(1, 1);
+    processor.applyMask(BlendModeType::Replace, cases[0].key);
+    failures += processor.canRedo();
+    processor.setHistoryBudget(16);
+    failures += processor.canUndo();
+
+    console << std::left << std::setw(28) << "historia cofania"
+            << std::setw(22) << (std::to_string(states.size() - 1) + " krokow")
+            << failures << " bledow" << (failures == 0 ? "" : "  BLAD") << std::endl;
+    return failures == 0;
+}
+
+// Pojedynczy piksel przez BlendMode::blend() - ta sama klasyfikacja klucza co w sciezkach wierszowych
+bool checkScalarBlend(const std::vector<Case>& cases, std::ostream& console) {
+    int failures = 0;
+    for (const Case& test : cases) {
+        const sf::Vector2u size = test.mask.getSize();
+        for (unsigned int y = 0; y < size.y; ++y) {
+            for (unsigned int x = 0; x < size.x; ++x) {
+                const sf::Color source = test.source.getPixel(sf::Vector2u(x % test.source.getSize().x,
+                                                                           y % test.source.getSize().y));
+                const sf::Color mask = test.mask.getPixel(sf::Vector2u(x, y));
+                failures += BlendMode::blend(source, mask, test.mode, test.key, test.useAlpha,
+                                             test.tolerance, test.opacity, test.linear) !=
+                            oracleBlend(source, mask, test);
+            }
+        }
+    }
+
+    console << std::left << std::setw(28) << "sciezka skalarna"
+            << std::setw(22) << (std::to_string(cases.size()) + " przypadkow")
+            << failures << " bledow" << (failures == 0 ? "" : "  BLAD") << std::endl;
+    return failures == 0;
+}
+
+// Obraz z prostokatami roznej wielkosci i gladkim szumem - kazdy fragment jest rozpoznawalny
+sf::Image alignmentScene(const sf::Vector2u& size, Random& random) {
+    sf::Image image(size, sf::Color(90, 100, 110));
+    for (unsigned int i = 0; i < size.x * size.y / 400; ++i) {
+        const int extent = 3 << random.range(0, 5);
+        const sf::Vector2i position(random.range(0, static_cast<int>(size.x) - 1), random.range(0, static_cast<int>(size.y) - 1));
+        const sf::Vector2i rectSize(random.range(3, extent), random.range(3, extent));
+        const sf::Color color(random.byte(), random.byte(), random.byte());
+        for (int y = position.y; y < std::min(static_cast<int>(size.y), position.y + rectSize.y); ++y) {
+            for (int x = position.x; x < std::min(static_cast<int>(size.x), position.x + rectSize.x); ++x) {
+                image.setPixel(sf::Vector2u(static_cast<unsigned int>(x), static_cast<unsigned int>(y)), color);
+            }
+        }
+    }
+
+    const unsigned int gridWidth = size.x / 8 + 2;
+    std::vector<int> grid(static_cast<std::size_t>(gridWidth) * (size.y / 8 + 2));
+    for (int& value : grid) {
+        value = random.range(-30, 30);
+    }
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            const unsigned int gx = x / 8;
+            const unsigned int gy = y / 8;
+            const int fx = static_cast<int>(x % 8);
+            const int fy = static_cast<int>(y % 8);
+            const int noise = (grid[gy * gridWidth + gx] * (8 - fx) * (8 - fy) + grid[gy * gridWidth + gx + 1] * fx * (8 - fy) +
+                               grid[(gy + 1) * gridWidth + gx] * (8 - fx) * fy + grid[(gy + 1) * gridWidth + gx + 1] * fx * fy) / 64;
+            sf::Color color = image.getPixel(sf::Vector2u(x, y));
+            color.r = static_cast<std::uint8_t>(std::clamp(color.r + noise, 0, 255));
+            color.g = static_cast<std::uint8_t>(std::clamp(color.g + noise, 0, 255));
+            color.b = static_cast<std::uint8_t>(std::clamp(color.b - noise, 0, 255));
+            image.setPixel(sf::Vector2u(x, y), color);
+        }
+    }
+    return image;
+}
+
+sf::Image crop(const sf::Image& image, const sf::IntRect& rect) {
+    sf::Image result(sf::Vector2u(rect.size));
+    for (int y = 0; y < rect.size.y; ++y) {
+        for (int x = 0; x < rect.size.x; ++x) {
+            result.setPixel(sf::Vector2u(static_cast<unsigned int>(x), static_cast<unsigned int>(y)),
+                            image.getPixel(sf::Vector2u(rect.position + sf::Vector2i(x, y))));
+        }
+    }
+    return result;
+}
+
+// Automatyczne wyrownanie ma znalezc dokladne polozenie wycinka obrazu: z dziurami w kolorze
+// klucza, malego i wiekszego niz obraz (obraz jest wtedy wycinkiem maski). Maski wezsze niz
+// 2 * MinCoarseMask na duzym obrazie ida kafelkami - na granicy kafelkow i czesciowo poza obrazem
+bool checkAlignment(std::ostream& console) {
+    Random random(77);
+    const sf::Image scene = alignmentScene(sf::Vector2u(640, 480), random);
+    const sf::Image wide = alignmentScene(sf::Vector2u(1600, 1200), random);
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+    processor.setThreadCount(3);
+
+    struct AlignCase {
+        sf::Image source;
+        sf::Image mask;
+        sf::Vector2i offset;
+    };
+    std::vector<AlignCase> cases;
+
+    AlignCase holes{scene, crop(scene, sf::IntRect({213, 147}, {160, 120})), {-213, -147}};
+    for (unsigned int y = 0; y < holes.mask.getSize().y; ++y) {
+        for (unsigned int x = 0; x < holes.mask.getSize().x; ++x) {
+            if ((x / 13 + y / 9) % 3 == 0) {
+                holes.mask.setPixel(sf::Vector2u(x, y), sf::Color::Magenta);
+            }
+        }
+    }
+    cases.push_back(holes);
+    cases.push_back({scene, crop(scene, sf::IntRect({401, 301}, {24, 24})), {-401, -301}});
+    cases.push_back({scene, crop(scene, sf::IntRect({5, 330}, {300, 150})), {-5, -330}});
+    cases.push_back({crop(scene, sf::IntRect({37, 59}, {500, 380})), scene, {37, 59}});
+    cases.push_back({wide, crop(wide, sf::IntRect({698, 811}, {12, 12})), {-698, -811}});
+    cases.push_back({crop(wide, sf::IntRect({100, 100}, {1400, 1000})), crop(wide, sf::IntRect({95, 1080}, {14, 14})), {5, -980}});
+
+    int failures = 0;
+    for (const AlignCase& test : cases) {
+        processor.setSourceImage(test.source);
+        processor.setMask(test.mask);
+        processor.resetMaskOffset();
+        failures += !processor.alignMask(sf::Color::Magenta) || processor.getMaskOffset() != test.offset;
+    }
+
+    console << std::left << std::setw(28) << "wyrownanie maski"
+            << std::setw(22) << (std::to_string(cases.size()) + " przypadkow")
+            << failures << " bledow" << (failures == 0 ? "" : "  BLAD") << std::endl;
+    return failures == 0;
+}
+
+std::vector<Engine> engines() {
+    return {
+        {"span-skipping (1 watek)", [](ImageProcessor& p) { p.setThreadCount(1); }},
+        {"threaded (2 watki)", [](ImageProcessor& p) { p.setThreadCount(2); }},
+        {"threaded (3 watki)", [](ImageProcessor& p) { p.setThreadCount(3); }},
+        {"threaded (8 watkow)", [](ImageProcessor& p) { p.setThreadCount(8); }},
+        {"dirty-region (2 watki)", [](ImageProcessor& p) { p.setThreadCount(2); }, true},
+    };
+}
+
+// Statystyki z obrazu referencyjnego; piksel jest dotkniety, gdy maska nie jest w nim kluczem
+// ani nie ma zerowego krycia, a obciety, gdy funkcja kanalu trybu wyszla poza zakres
+BlendStatistics referenceStatistics(const Case& test, const sf::Image& expected) {
+    BlendStatistics statistics;
+    const sf::Vector2u sourceSize = test.source.getSize();
+    const sf::Vector2u maskSize = test.mask.getSize();
+    statistics.pixels = static_cast<long long>(sourceSize.x) * sourceSize.y;
+
+    for (unsigned int y = 0; y < sourceSize.y; ++y) {
+        for (unsigned int x = 0; x < sourceSize.x; ++x) {
+            const sf::Color result = expected.getPixel(sf::Vector2u(x, y));
+            ++statistics.histogram[0][result.r];
+            ++statistics.histogram[1][result.g];
+            ++statistics.histogram[2][result.b];
+            ++statistics.histogram[3][result.a];
+
+            int maskX = static_cast<int>(x) + test.offset.x;
+            int maskY = static_cast<int>(y) + test.offset.y;
+            if (test.wrap != MaskWrap::None) {
+                maskX = wrapCoordinate(maskX, static_cast<int>(maskSize.x), test.wrap == MaskWrap::Mirror);
+                maskY = wrapCoordinate(maskY, static_cast<int>(maskSize.y), test.wrap == MaskWrap::Mirror);
+            }
+            if (maskX < 0 || maskX >= static_cast<int>(maskSize.x) || maskY < 0 || maskY >= static_cast<int>(maskSize.y)) {
+                continue;
+            }
+
+            const sf::Color source = test.source.getPixel(sf::Vector2u(x, y));
+            const sf::Color mask = test.mask.getPixel(sf::Vector2u(
+                static_cast<unsigned int>(maskX), static_cast<unsigned int>(maskY)));
+            if (oracleCoverage(mask, test) == 0) {
+                continue;
+            }
+
+            ++statistics.touched;
+            bool clipped = false;
+            oracleMode(source, mask, test, &clipped);
+            statistics.clipped += clipped;
+        }
+    }
+    return statistics;
+}
+
+bool sameStatistics(const BlendStatistics* actual, const BlendStatistics& expected) {
+    return actual && actual->pixels == expected.pixels && actual->touched == expected.touched &&
+           actual->clipped == expected.clipped && actual->histogram == expected.histogram;
+}
+
+// Miekki klucz wprost z definicji, w liczbach zmiennoprzecinkowych: krycie klucza rosnie liniowo
+// od tolerancji do tolerancji + miekkosci (odleglosc to maksimum po kanalach), kolor krawedzi to
+// kolor maski z odjetym udzialem klucza, a wtapianie to rozmycie pudelkowe pokrycia (wiersze,
+// potem kolumny, kazde zaokraglane, krawedzie powielane) ograniczone od gory pierwotnym pokryciem
+sf::Image referenceSoftKey(const Case& test) {
+    const sf::Vector2u maskSize = test.mask.getSize();
+    const int width = static_cast<int>(maskSize.x);
+    const int height = static_cast<int>(maskSize.y);
+    const int limit = std::clamp(test.tolerance, 0, 255);
+    std::vector<int> coverage(static_cast<std::size_t>(width) * height);
+    std::vector<sf::Color> colors(coverage.size());
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const sf::Color mask = test.mask.getPixel(sf::Vector2u(static_cast<unsigned int>(x), static_cast<unsigned int>(y)));
+            const int distance = std::max({std::abs(mask.r - test.key.r), std::abs(mask.g - test.key.g),
+                                           std::abs(mask.b - test.key.b)});
+            int keyAlpha = 255;
+            if (distance <= limit) {
+                keyAlpha = 0;
+            } else if (distance < limit + test.softness) {
+                keyAlpha = static_cast<int>(std::lround((distance - limit) * 255.0 / test.softness));
+            }
+            const int maskAlpha = mask.a == 0 ? 0 : (test.useAlpha ? mask.a : 255);
+            const std::size_t i = static_cast<std::size_t>(y) * width + x;
+            coverage[i] = static_cast<int>(std::lround(keyAlpha * maskAlpha / 255.0));
+
+            colors[i] = mask;
+            if (test.despill && keyAlpha > 0 && keyAlpha < 255) {
+                auto unmix = [&](std::uint8_t value, std::uint8_t key) {
+                    const double original = (value * 255.0 - (255 - keyAlpha) * key) / keyAlpha;
+                    return static_cast<std::uint8_t>(std::clamp(static_cast<long>(std::lround(original)), 0L, 255L));
+                };
+                colors[i] = sf::Color(unmix(mask.r, test.key.r), unmix(mask.g, test.key.g), unmix(mask.b, test.key.b), mask.a);
+            }
+        }
+    }
+
+    if (test.feather > 0) {
+        const int radius = test.feather;
+        const double window = 2 * radius + 1;
+        std::vector<int> rows(coverage.size());
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                double sum = 0.0;
+                for (int i = -radius; i <= radius; ++i) {
+                    sum += coverage[static_cast<std::size_t>(y) * width + std::clamp(x + i, 0, width - 1)];
+                }
+                rows[static_cast<std::size_t>(y) * width + x] = static_cast<int>(std::lround(sum / window));
+            }
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                double sum = 0.0;
+                for (int i = -radius; i <= radius; ++i) {
+                    sum += rows[static_cast<std::size_t>(std::clamp(y + i, 0, height - 1)) * width + x];
+                }
+                int& value = coverage[static_cast<std::size_t>(y) * width + x];
+                value = std::min(value, static_cast<int>(std::lround(sum / window)));
+            }
+        }
+    }
+
+    const sf::Vector2u sourceSize = test.source.getSize();
+    sf::Image result = test.source;
+    for (unsigned int y = 0; y < sourceSize.y; ++y) {
+        for (unsigned int x = 0; x < sourceSize.x; ++x) {
+            const int maskX = static_cast<int>(x) + test.offset.x;
+            const int maskY = static_cast<int>(y) + test.offset.y;
+            if (maskX < 0 || maskX >= width || maskY < 0 || maskY >= height) {
+                continue;
+            }
+            const std::size_t i = static_cast<std::size_t>(maskY) * width + maskX;
+            const sf::Color source = test.source.getPixel(sf::Vector2u(x, y));
+            const int scaled = (coverage[i] * test.opacity + 127) / 255;
+            if (scaled > 0) {
+                result.setPixel(sf::Vector2u(x, y), oracleMix(source, oracleMode(source, colors[i], test), scaled, test));
+            }
+        }
+    }
+    return result;
+}
+
+// Miekki klucz: sama rampa krycia, rampa z odjeciem klucza i wtapianie promieniami 1..6.
+// Maska ma piksele w kazdej odleglosci od klucza do tolerancji + miekkosci + 4, wiec oba
+// konce rampy sa trafiane dokladnie
+bool checkSoftKey(std::ostream& console) {
+    Random random(808);
+    const int tolerances[] = {0, BlendMode::DefaultTolerance, 40};
+    const int softnesses[] = {1, 7, 32, 200};
+
+    auto makeCase = [&](int softness, bool despill, int feather) {
+        Case test;
+        const sf::Vector2u sourceSize(static_cast<unsigned int>(random.range(24, 56)), static_cast<unsigned int>(random.range(20, 48)));
+        test.source.resize(sourceSize);
+        for (unsigned int y = 0; y < sourceSize.y; ++y) {
+            for (unsigned int x = 0; x < sourceSize.x; ++x) {
+                test.source.setPixel(sf::Vector2u(x, y), sf::Color(random.byte(), random.byte(), random.byte(), 255));
+            }
+        }
+        test.key = sf::Color(random.byte(), random.byte(), random.byte());
+        test.tolerance = tolerances[random.next() % 3];
+        test.softness = softness;
+        test.despill = despill;
+        test.feather = feather;
+
+        const sf::Vector2u maskSize(static_cast<unsigned int>(random.range(16, 48)), static_cast<unsigned int>(random.range(16, 40)));
+        test.mask.resize(maskSize);
+        const int reach = std::clamp(test.tolerance, 0, 255) + softness + 4;
+        for (unsigned int y = 0; y < maskSize.y; ++y) {
+            for (unsigned int x = 0; x < maskSize.x; ++x) {
+                // Jeden kanal dokladnie w odleglosci distance, pozostale blizej
+                const int distance = random.range(0, std::min(reach, 255));
+                const int far = static_cast<int>(random.next() % 3);
+                const std::uint8_t key[3] = {test.key.r, test.key.g, test.key.b};
+                std::uint8_t channel[3];
+                for (int c = 0; c < 3; ++c) {
+                    const int offset = c == far ? distance : random.range(-distance, distance);
+                    const int value = key[c] + (random.next() % 2 ? offset : -offset);
+                    channel[c] = static_cast<std::uint8_t>(std::clamp(value, 0, 255));
+                }
+                const std::uint8_t alpha = random.next() % 4 == 0 ? random.byte() : 255;
+                test.mask.setPixel(sf::Vector2u(x, y), sf::Color(channel[0], channel[1], channel[2], alpha));
+            }
+        }
+
+        test.offset = sf::Vector2i(random.range(-12, static_cast<int>(sourceSize.x) - 4), random.range(-12, static_cast<int>(sourceSize.y) - 4));
+        const std::vector<BlendModeType> modes = BlendMode::getAllModes();
+        test.mode = modes[random.next() % modes.size()];
+        test.useAlpha = random.next() % 3 != 0;
+        test.opacity = random.next() % 3 == 0 ? random.byte() : 255;
+        test.linear = random.next() % 4 == 0;
+        return test;
+    };
+
+    struct Group {
+        std::string name;
+        std::vector<Case> cases;
+    };
+    std::vector<Group> groups(3);
+    groups[0].name = "miekki klucz";
+    groups[1].name = "miekki klucz + despill";
+    groups[2].name = "wtapianie klucza";
+    for (int i = 0; i < 24; ++i) {
+        groups[0].cases.push_back(makeCase(softnesses[i % 4], false, 0));
+        groups[1].cases.push_back(makeCase(softnesses[i % 4], true, 0));
+        groups[2].cases.push_back(makeCase(i % 3 == 0 ? 0 : softnesses[i % 4], i % 2 == 0, 1 + i % 6));
+    }
+
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+    bool passed = true;
+    for (const Group& group : groups) {
+        Deviation deviation;
+        for (const Case& test : group.cases) {
+            const sf::Image expected = referenceSoftKey(test);
+            for (const Engine& engine : {engines()[0], engines()[2], engines()[4]}) {
+                processor.setSoftKey(test.softness, test.despill, test.feather);
+                deviation.merge(runCase(processor, engine, test, expected));
+            }
+        }
+        passed &= deviation.max() == 0;
+        console << std::left << std::setw(28) << group.name
+                << std::setw(22) << (std::to_string(group.cases.size()) + " przypadkow")
+                << deviation.channel[0] << "/" << deviation.channel[1] << "/"
+                << deviation.channel[2] << "/" << deviation.channel[3]
+                << " (" << deviation.pixels << ")"
+                << (deviation.max() == 0 ? "" : "  BLAD") << std::endl;
+    }
+    processor.setSoftKey(0);
+    return passed;
+}
+
+// Odwzorowanie odwrotne wprost z definicji, w liczbach zmiennoprzecinkowych: srodek piksela wyniku
+// obrocony wokol srodka i podzielony przez skale; najblizszy bierze piksel zawierajacy punkt,
+// dwuliniowy wazy cztery sasiednie srodki, a poza maska probkowany jest kolor wypelnienia
+sf::Image referenceTransform(const sf::Image& source, const sf::Vector2u& size, const MaskTransform& transform,
+                             const sf::Color& fill) {
+    const sf::Vector2u sourceSize = source.getSize();
+    const double radians = transform.rotation * 3.14159265358979323846 / 180.0;
+    double cosR = std::cos(radians);
+    double sinR = std::sin(radians);
+    // Wielokrotnosci 90 stopni dokladnie: blad przyblizenia pi przesuwalby probki lezace na granicy pikseli
+    if (std::fmod(transform.rotation, 90.0f) == 0.0f) {
+        cosR = std::round(cosR);
+        sinR = std::round(sinR);
+    }
+    const double cosA = cosR / transform.scale;
+    const double sinA = sinR / transform.scale;
+
+    auto sample = [&](double x, double y, int c) -> double {
+        if (x < 0 || y < 0 || x >= sourceSize.x || y >= sourceSize.y) {
+            const std::uint8_t channel[4] = {fill.r, fill.g, fill.b, fill.a};
+            return channel[c];
+        }
+        const sf::Color pixel = source.getPixel(sf::Vector2u(static_cast<unsigned int>(x), static_cast<unsigned int>(y)));
+        const std::uint8_t channel[4] = {pixel.r, pixel.g, pixel.b, pixel.a};
+        return channel[c];
+    };
+
+    sf::Image result(size);
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            const double dx = x + 0.5 - size.x / 2.0;
+            const double dy = y + 0.5 - size.y / 2.0;
+            double u = sourceSize.x / 2.0 + cosA * dx + sinA * dy;
+            double v = sourceSize.y / 2.0 - sinA * dx + cosA * dy;
+            std::uint8_t channel[4];
+            for (int c = 0; c < 4; ++c) {
+                if (transform.filter == ResampleFilter::Nearest) {
+                    channel[c] = static_cast<std::uint8_t>(sample(std::floor(u), std::floor(v), c));
+                    continue;
+                }
+                const double left = std::floor(u - 0.5);
+                const double top = std::floor(v - 0.5);
+                const double fx = u - 0.5 - left;
+                const double fy = v - 0.5 - top;
+                const double value = (sample(left, top, c) * (1 - fx) + sample(left + 1, top, c) * fx) * (1 - fy) +
+                                     (sample(left, top + 1, c) * (1 - fx) + sample(left + 1, top + 1, c) * fx) * fy;
+                channel[c] = static_cast<std::uint8_t>(std::lround(value));
+            }
+            result.setPixel(sf::Vector2u(x, y), sf::Color(channel[0], channel[1], channel[2], channel[3]));
+        }
+    }
+    return result;
+}
+
+// Srednia z pelnych blokow zrodla przy pomniejszaniu o calkowita krotnosc
+sf::Image referenceReduce(const sf::Image& source, unsigned int factor) {
+    const sf::Vector2u size(source.getSize().x / factor, source.getSize().y / factor);
+    sf::Image result(size);
+    for (unsigned int y = 0; y < size.y; ++y) {
+        for (unsigned int x = 0; x < size.x; ++x) {
+            double sum[4] = {0, 0, 0, 0};
+            for (unsigned int sy = y * factor; sy < (y + 1) * factor; ++sy) {
+                for (unsigned int sx = x * factor; sx < (x + 1) * factor; ++sx) {
+                    const sf::Color pixel = source.getPixel(sf::Vector2u(sx, sy));
+                    sum[0] += pixel.r;
+                    sum[1] += pixel.g;
+                    sum[2] += pixel.b;
+                    sum[3] += pixel.a;
+                }
+            }
+            std::uint8_t channel[4];
+            for (int c = 0; c < 4; ++c) {
+                channel[c] = static_cast<std::uint8_t>(std::lround(sum[c] / (factor * factor)));
+            }
+            result.setPixel(sf::Vector2u(x, y), sf::Color(channel[0], channel[1], channel[2], channel[3]));
+        }
+    }
+    return result;
+}
+
+// Przeksztalcenie maski: skala najblizszym (skale potegi dwojki, wiec stalym przecinkiem dokladnie),
+// obroty o wielokrotnosc 90 stopni najblizszym, dwuliniowy dla dowolnych katow z tolerancja 1
+// (wagi 8-bitowe), pomniejszanie obszarowe o calkowita krotnosc i rozmiary wyniku
+bool checkResampler(std::ostream& console) {
+    Random random(4242);
+    auto randomImage = [&](unsigned int width, unsigned int height) {
+        sf::Image image(sf::Vector2u(width, height));
+        for (unsigned int y = 0; y < height; ++y) {
+            for (unsigned int x = 0; x < width; ++x) {
+                image.setPixel(sf::Vector2u(x, y), sf::Color(random.byte(), random.byte(), random.byte(), random.byte()));
+            }
+        }
+        return image;
+    };
+
+    // Wiersze w trzech pasach, jak w parallelFor
+    auto transformed = [](const sf::Image& source, const MaskTransform& transform, const sf::Color& fill) {
+        const sf::Vector2u size = ImageResampler::transformedSize(source.getSize(), transform);
+        std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+        const unsigned int bands[] = {0, size.y / 3, size.y / 2 + 1, size.y};
+        for (int band = 0; band < 3; ++band) {
+            ImageResampler::transformRows(source.getPixelsPtr(), source.getSize(), pixels.data(), size, transform, fill,
+                                          std::min(bands[band], size.y), std::min(bands[band + 1], size.y));
+        }
+        return sf::Image(size, pixels.data());
+    };
+
+    struct Group {
+        std::string name;
+        int cases = 0;
+        int limit = 0;
+        Deviation deviation;
+    };
+    std::vector<Group> groups(4);
+    groups[0].name = "skala (najblizszy)";
+    groups[1].name = "obrot 90/180 (najblizszy)";
+    groups[2].name = "dwuliniowy";
+    groups[2].limit = 1;
+    groups[3].name = "pomniejszanie obszarowe";
+
+    const float scales[] = {0.25f, 0.5f, 2.0f, 4.0f};
+    const float rightAngles[] = {90.0f, 180.0f, 270.0f, -90.0f};
+    for (int i = 0; i < 16; ++i) {
+        const sf::Image source = randomImage(static_cast<unsigned int>(random.range(5, 61)), static_cast<unsigned int>(random.range(5, 47)));
+        const sf::Color fill(random.byte(), random.byte(), random.byte(), random.byte());
+
+        MaskTransform scaled;
+        scaled.scale = scales[i % 4];
+        scaled.filter = ResampleFilter::Nearest;
+        const sf::Image scaledResult = transformed(source, scaled, fill);
+        groups[0].deviation.merge(compare(referenceTransform(source, scaledResult.getSize(), scaled, fill), scaledResult));
+        ++groups[0].cases;
+
+        MaskTransform rotated;
+        rotated.scale = i % 2 == 0 ? 1.0f : scales[i / 2 % 4];
+        rotated.rotation = rightAngles[i % 4];
+        rotated.filter = ResampleFilter::Nearest;
+        const sf::Image rotatedResult = transformed(source, rotated, fill);
+        groups[1].deviation.merge(compare(referenceTransform(source, rotatedResult.getSize(), rotated, fill), rotatedResult));
+        ++groups[1].cases;
+
+        MaskTransform bilinear;
+        bilinear.scale = 0.3f + static_cast<float>(random.range(0, 300)) / 100.0f;
+        bilinear.rotation = static_cast<float>(random.range(-3600, 3600)) / 10.0f;
+        bilinear.filter = ResampleFilter::Bilinear;
+        const sf::Image bilinearResult = transformed(source, bilinear, fill);
+        groups[2].deviation.merge(compare(referenceTransform(source, bilinearResult.getSize(), bilinear, fill), bilinearResult));
+        ++groups[2].cases;
+
+        const unsigned int factor = static_cast<unsigned int>(2 + i % 3);
+        const sf::Image block = randomImage(factor * static_cast<unsigned int>(random.range(1, 24)),
+                                            factor * static_cast<unsigned int>(random.range(1, 24)));
+        const sf::Vector2u reduced(block.getSize().x / factor, block.getSize().y / factor);
+        groups[3].deviation.merge(compare(referenceReduce(block, factor), ImageResampler::resizeArea(block, reduced)));
+        ++groups[3].cases;
+    }
+
+    bool passed = true;
+    for (const Group& group : groups) {
+        passed &= group.deviation.max() <= group.limit;
+        console << std::left << std::setw(28) << group.name
+                << std::setw(22) << (std::to_string(group.cases) + " przypadkow")
+                << group.deviation.channel[0] << "/" << group.deviation.channel[1] << "/"
+                << group.deviation.channel[2] << "/" << group.deviation.channel[3]
+                << " (" << group.deviation.pixels << ")"
+                << (group.deviation.max() <= group.limit ? "" : "  BLAD") << std::endl;
+    }
+
+    // Rozmiar obwiedni obroconej maski; filtr obszarowy najpierw zaokragla pomniejszona maske
+    struct SizeCase {
+        sf::Vector2u size;
+        MaskTransform transform;
+        sf::Vector2u expected;
+    };
+    const std::vector<SizeCase> sizes = {
+        {{200, 100}, {1.0f, 0.0f, ResampleFilter::Bilinear}, {200, 100}},
+        {{200, 100}, {1.5f, 0.0f, ResampleFilter::Nearest}, {300, 150}},
+        {{201, 99}, {1.0f, 90.0f, ResampleFilter::Nearest}, {99, 201}},
+        {{201, 99}, {2.0f, -90.0f, ResampleFilter::Bilinear}, {198, 402}},
+        {{201, 99}, {1.0f, 180.0f, ResampleFilter::Bilinear}, {201, 99}},
+        {{200, 100}, {1.0f, 45.0f, ResampleFilter::Bilinear}, {212, 212}},
+        {{100, 100}, {1.0f, 45.0f, ResampleFilter::Nearest}, {141, 141}},
+        {{1, 1}, {0.1f, 45.0f, ResampleFilter::Bilinear}, {1, 1}},
+        {{101, 37}, {0.5f, 0.0f, ResampleFilter::Area}, {51, 19}},
+        {{101, 37}, {0.5f, 90.0f, ResampleFilter::Area}, {19, 51}},
+        {{103, 41}, {0.5f, 45.0f, ResampleFilter::Area}, {52, 52}},
+        {{103, 41}, {0.5f, 45.0f, ResampleFilter::Bilinear}, {51, 51}},
+        {{30, 10}, {0.1f, 0.0f, ResampleFilter::Area}, {3, 1}},
+        {{30, 4}, {0.1f, 0.0f, ResampleFilter::Area}, {3, 1}},
+        {{200, 100}, {2.0f, 0.0f, ResampleFilter::Area}, {400, 200}},
+    };
+    int failures = 0;
+    for (const SizeCase& test : sizes) {
+        failures += ImageResampler::transformedSize(test.size, test.transform) != test.expected;
+    }
+    passed &= failures == 0;
+    console << std::left << std::setw(28) << "rozmiar po przeksztalceniu"
+            << std::setw(22) << (std::to_string(sizes.size()) + " przypadkow")
+            << failures << " bledow" << (failures == 0 ? "" : "  BLAD") << std::endl;
+    return passed;
+}
+
+// Piramida podgladu po zmianach fragmentow obrazu: poziomy dobudowywane z uniewaznionych
+// prostokatow (takze wychodzacych poza obraz, przed zbudowaniem poziomu i kilka razy przed
+// odczytem) maja byc identyczne z piramida zbudowana od zera i ze srednimi liczonymi wprost
+bool checkTilePyramid(std::ostream& console) {
+    Random random(5150);
+    const sf::Vector2u size(301, 217);
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) * size.y * 4);
+    for (std::uint8_t& value : pixels) {
+        value = random.byte();
+    }
+
+    TilePyramid pyramid(16);
+    pyramid.setImage(pixels.data(), size);
+    const unsigned int levels = pyramid.getLevelCount();
+
+    int rounds = 0;
+    int failures = 0;
+    for (int round = 0; round < 40; ++round) {
+        const int changes = random.range(1, 4);
+        for (int i = 0; i < changes; ++i) {
+            const sf::IntRect rect({random.range(-20, static_cast<int>(size.x) - 1), random.range(-20, static_cast<int>(size.y) - 1)},
+                                   {random.range(1, 90), random.range(1, 70)});
+            const std::optional<sf::IntRect> clipped = rect.findIntersection(sf::IntRect({0, 0}, sf::Vector2i(size)));
+            if (clipped) {
+                for (int y = clipped->position.y; y < clipped->position.y + clipped->size.y; ++y) {
+                    for (int x = clipped->position.x; x < clipped->position.x + clipped->size.x; ++x) {
+                        for (int c = 0; c < 4; ++c) {
+                            pixels[(static_cast<std::size_t>(y) * size.x + x) * 4 + c] = random.byte();
+                        }
+                    }
+                }
+            }
+            pyramid.invalidate(rect);
+        }
+        if (round % 13 == 12) {
+            pyramid.invalidateAll();
+        }
+
+        // Czesc rund odczytuje tylko niektore poziomy - reszta zbiera uniewaznienia do pozniej
+        if (random.next() % 3 == 0) {
+            pyramid.getLevelPixels(static_cast<unsigned int>(random.range(1, static_cast<int>(levels) - 1)));
+            continue;
+        }
+
+        // Piramida od zera i srednie 2x2 wprost (ostatni wiersz i kolumna powielane przy
+        // nieparzystym rozmiarze)
+        ++rounds;
+        TilePyramid rebuilt(16);
+        rebuilt.setImage(pixels.data(), size);
+        std::vector<std::uint8_t> expected = pixels;
+        sf::Vector2u expectedSize = size;
+        for (unsigned int level = 0; level < levels; ++level) {
+            if (level > 0) {
+                const sf::Vector2u previousSize = expectedSize;
+                const std::vector<std::uint8_t> previous = std::move(expected);
+                expectedSize = sf::Vector2u((previousSize.x + 1) / 2, (previousSize.y + 1) / 2);
+                expected.assign(static_cast<std::size_t>(expectedSize.x) * expectedSize.y * 4, 0);
+                for (unsigned int y = 0; y < expectedSize.y; ++y) {
+                    for (unsigned int x = 0; x < expectedSize.x; ++x) {
+                        for (int c = 0; c < 4; ++c) {
+                            int sum = 0;
+                            for (unsigned int sy : {2 * y, std::min(2 * y + 1, previousSize.y - 1)}) {
+                                for (unsigned int sx : {2 * x, std::min(2 * x + 1, previousSize.x - 1)}) {
+                                    sum += previous[(static_cast<std::size_t>(sy) * previousSize.x + sx) * 4 + c];
+                                }
+                            }
+                            expected[(static_cast<std::size_t>(y) * expectedSize.x + x) * 4 + c] = static_cast<std::uint8_t>((sum + 2) / 4);
+                        }
+                    }
+                }
+            }
+
+            failures += pyramid.getLevelSize(level) != expectedSize || rebuilt.getLevelSize(level) != expectedSize ||
+                        !std::equal(expected.begin(), expected.end(), pyramid.getLevelPixels(level)) ||
+                        !std::equal(expected.begin(), expected.end(), rebuilt.getLevelPixels(level));
+        }
+    }
+
+    console << std::left << std::setw(28) << "piramida podgladu"
+            << std::setw(22) << (std::to_string(rounds) + " przypadkow")
+            << failures << " bledow" << (failures == 0 && levels > 4 ? "" : "  BLAD") << std::endl;
+    return failures == 0 && levels > 4;
+}
+
+// Statystyki zbierane w applyMask (pasy wierszy w wielu watkach, przeliczanie tylko zmienionego
+// obszaru z histogramem zrodla z pamieci podrecznej) maja byc dokladnie rowne referencyjnym
+bool checkStatistics(const std::vector<Case>& cases, const std::vector<sf::Image>& expected, std::ostream& console) {
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+    processor.setCollectStatistics(true);
+
+    int failures = 0;
+    long long clipped = 0;
+    for (const Engine& engine : {engines()[0], engines()[2], engines()[4]}) {
+        for (size_t i = 0; i < cases.size(); ++i) {
+            runCase(processor, engine, cases[i], expected[i]);
+            const BlendStatistics reference = referenceStatistics(cases[i], expected[i]);
+            failures += !sameStatistics(processor.getStatistics(), reference);
+            clipped += reference.clipped;
+        }
+    }
+
+    // Po cofnieciu statystyki nie opisuja juz wyniku
+    failures += processor.undo() && processor.getStatistics() != nullptr;
+
+    console << std::left << std::setw(28) << "statystyki wyniku"
+            << std::setw(22) << (std::to_string(cases.size()) + " przypadkow")
+            << failures << " bledow" << (failures == 0 && clipped > 0 ? "" : "  BLAD") << std::endl;
+    return failures == 0 && clipped > 0;
+}
+
+}
+
+int main() {
+    NullBuffer nullBuffer;
+    std::ostream console(std::cout.rdbuf());
+    std::cout.rdbuf(&nullBuffer);
+
+    ImageProcessor processor;
+    processor.setTexturesEnabled(false);
+
+    auto exhaustive = exhaustiveCases();
+    auto randomized = randomCases(200);
+    auto wrapped = wrappedCases(120);
+
+    std::vector<sf::Image> exhaustiveExpected;
+    for (const auto& test : exhaustive) {
+        exhaustiveExpected.push_back(referenceApplyMask(test));
+    }
+    std::vector<sf::Image> randomExpected;
+    for (const auto& test : randomized) {
+        randomExpected.push_back(referenceApplyMask(test));
+    }
+    std::vector<sf::Image> wrappedExpected;
+    for (const auto& test : wrapped) {
+        wrappedExpected.push_back(referenceApplyMask(test));
+    }
+
+    bool passed = true;
+    console << std::left << std::setw(28) << "Silnik"
+            << std::setw(22) << "Tryb"
+            << "max odchylenie R/G/B/A (piksele)" << std::endl;
+
+    for (const auto& engine : engines()) {
+        for (BlendModeType mode : BlendMode::getAllModes()) {
+            Deviation deviation;
+            for (size_t i = 0; i < exhaustive.size(); ++i) {
+                if (exhaustive[i].mode == mode) {
+                    deviation.merge(runCase(processor, engine, exhaustive[i], exhaustiveExpected[i]));
+                }
+            }
+            for (size_t i = 0; i < randomized.size(); ++i) {
+                if (randomized[i].mode == mode) {
+                    deviation.merge(runCase(processor, engine, randomized[i], randomExpected[i]));
+                }
+            }
+            for (size_t i = 0; i < wrapped.size(); ++i) {
+                if (wrapped[i].mode == mode) {
+                    deviation.merge(runCase(processor, engine, wrapped[i], wrappedExpected[i]));
+                }
+            }
+
+            passed &= deviation.max() == 0;
+            console << std::left << std::setw(28) << engine.name
+                    << std::setw(22) << BlendMode::getModeName(mode)
+                    << deviation.channel[0] << "/" << deviation.channel[1] << "/"
+                    << deviation.channel[2] << "/" << deviation.channel[3]
+                    << " (" << deviation.pixels << ")"
+                    << (deviation.max() == 0 ? "" : "  BLAD") << std::endl;
+        }
+    }
+
+    passed &= checkHistory(std::vector<Case>(randomized.begin(), randomized.begin() + 12), console);
+    passed &= checkScalarBlend(randomized, console);
+    passed &= checkAlignment(console);
+    passed &= checkSoftKey(console);
+    passed &= checkResampler(console);
+    passed &= checkTilePyramid(console);
+
+    std::vector<Case> statisticsCases(randomized.begin(), randomized.begin() + 60);
+    std::vector<sf::Image> statisticsExpected(randomExpected.begin(), randomExpected.begin() + 60);
+    statisticsCases.insert(statisticsCases.end(), wrapped.begin(), wrapped.begin() + 30);
+    statisticsExpected.insert(statisticsExpected.end(), wrappedExpected.begin(), wrappedExpected.begin() + 30);
+    passed &= checkStatistics(statisticsCases, statisticsExpected, console);
+
+    // Swiatlo liniowe nie jest dostepne w sciezce 16-bit/float
+    for (PixelFormat format : {PixelFormat::UInt16, PixelFormat::Float32}) {
+        PreciseProcessor precise(format);
+        precise.setThreadCount(3);
+        const std::string name = format == PixelFormat::UInt16 ? "precise (16 bit)" : "precise (float)";
+
+        for (BlendModeType mode : BlendMode::getAllModes()) {
+            Deviation deviation;
+            for (size_t i = 0; i < exhaustive.size(); ++i) {
+                if (exhaustive[i].mode == mode && !exhaustive[i].linear) {
+                    deviation.merge(runPreciseCase(precise, exhaustive[i], exhaustiveExpected[i]));
+                }
+            }
+            for (size_t i = 0; i < randomized.size(); ++i) {
+                if (randomized[i].mode == mode && !randomized[i].linear) {
+                    deviation.merge(runPreciseCase(precise, randomized[i], randomExpected[i]));
+                }
+            }
+
+            passed &= deviation.max() <= PreciseTolerance;
+            console << std::left << std::setw(28) << name
+                    << std::setw(22) << BlendMode::getModeName(mode)
+                    << deviation.channel[0] << "/" << deviation.channel[1] << "/"
+                    << deviation.channel[2] << "/" << deviation.channel[3]
+                    << " (" << deviation.pixels << ")"
+                    << (deviation.max() <= PreciseTolerance ? "" : "  BLAD") << std::endl;
+        }
+    }
+
+    std::cout.rdbuf(console.rdbuf());
+    std::cout << (passed ? "Wszystkie silniki zgodne z referencja" : "Wykryto odchylenia od referencji") << std::endl;
+    return passed ? 0 : 1;
+}